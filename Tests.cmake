@@ -110,4 +110,211 @@ rs_gfs_test(
     ${REVERSINGSPACE_ARCHIVESYSTEM_TEST_INCLUDE_DIRS}
     ${REVERSINGSPACE_ARCHIVESYSTEM_TEST_SOURCES}
     "" # No libs
-)
\ No newline at end of file
+)
+
+# ---------------------------------------------------------------------
+# Hash Testing (default hash function)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_HASH_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/hash/main.cpp"
+)
+
+set(REVERSINGSPACE_HASH_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/hash/"
+)
+
+option(
+    REVERSINGSPACE_HASH_TEST
+    "Simple test for the default hash function"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_HASH_TEST
+    "revspace-storage-test-hash"
+    ${REVERSINGSPACE_HASH_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_HASH_TEST_SOURCES}
+    "" # No libs
+)
+# ---------------------------------------------------------------------
+# Concurrency Testing (StorageServer mount/unmount under load)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_CONCURRENCY_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/concurrency/main.cpp"
+)
+
+set(REVERSINGSPACE_CONCURRENCY_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/concurrency/"
+)
+
+option(
+    REVERSINGSPACE_CONCURRENCY_TEST
+    "Stress test for StorageServer look-ups during mount/unmount"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_CONCURRENCY_TEST
+    "revspace-storage-test-concurrency"
+    ${REVERSINGSPACE_CONCURRENCY_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_CONCURRENCY_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Watcher Testing (change notifications)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_WATCHER_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/watcher/main.cpp"
+)
+
+set(REVERSINGSPACE_WATCHER_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/watcher/"
+)
+
+option(
+    REVERSINGSPACE_WATCHER_TEST
+    "Test for change notifications (DirectoryWatcher, StorageServer watching)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_WATCHER_TEST
+    "revspace-storage-test-watcher"
+    ${REVERSINGSPACE_WATCHER_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_WATCHER_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Listing Testing (single-pass directory listings)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_LISTING_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/listing/main.cpp"
+)
+
+set(REVERSINGSPACE_LISTING_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/listing/"
+)
+
+option(
+    REVERSINGSPACE_LISTING_TEST
+    "Test for single-pass directory listings (DirectoryListing)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_LISTING_TEST
+    "revspace-storage-test-listing"
+    ${REVERSINGSPACE_LISTING_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_LISTING_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Query Testing (prefix and glob queries, IdentityTree)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_QUERY_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/query/main.cpp"
+)
+
+set(REVERSINGSPACE_QUERY_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/query/"
+)
+
+option(
+    REVERSINGSPACE_QUERY_TEST
+    "Test for prefix and glob queries (IdentityTree)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_QUERY_TEST
+    "revspace-storage-test-query"
+    ${REVERSINGSPACE_QUERY_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_QUERY_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Persist Testing (saved mount indexes, MountIndexFile)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_PERSIST_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/persist/main.cpp"
+)
+
+set(REVERSINGSPACE_PERSIST_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/persist/"
+)
+
+option(
+    REVERSINGSPACE_PERSIST_TEST
+    "Test for saved mount indexes (MountIndexFile)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_PERSIST_TEST
+    "revspace-storage-test-persist"
+    ${REVERSINGSPACE_PERSIST_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_PERSIST_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Static Server Testing (compile-time mount stacks, StaticStorageServer)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_STATICSERVER_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/staticserver/main.cpp"
+)
+
+set(REVERSINGSPACE_STATICSERVER_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/staticserver/"
+)
+
+option(
+    REVERSINGSPACE_STATICSERVER_TEST
+    "Test (and benchmark) for compile-time mount stacks (StaticStorageServer)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_STATICSERVER_TEST
+    "revspace-storage-test-staticserver"
+    ${REVERSINGSPACE_STATICSERVER_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_STATICSERVER_TEST_SOURCES}
+    "" # No libs
+)
+
+# ---------------------------------------------------------------------
+# Pack Testing (reference archive format, PackArchive/PackBuilder)
+# ---------------------------------------------------------------------
+
+set(REVERSINGSPACE_PACK_TEST_SOURCES
+    "${PROJECT_SOURCE_DIR}/tests/pack/main.cpp"
+)
+
+set(REVERSINGSPACE_PACK_TEST_INCLUDE_DIRS 
+    "${PROJECT_SOURCE_DIR}/tests/pack/"
+)
+
+option(
+    REVERSINGSPACE_PACK_TEST
+    "Test for the reference archive format (PackArchive, PackBuilder)"
+    OFF
+)
+
+rs_gfs_test(
+    REVERSINGSPACE_PACK_TEST
+    "revspace-storage-test-pack"
+    ${REVERSINGSPACE_PACK_TEST_INCLUDE_DIRS}
+    ${REVERSINGSPACE_PACK_TEST_SOURCES}
+    "" # No libs
+)
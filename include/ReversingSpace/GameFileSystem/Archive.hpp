@@ -15,10 +15,12 @@
 
 #include <ReversingSpace/GameFileSystem/Directory.hpp>
 #include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/LazyMount.hpp>
 #include <ReversingSpace/Storage/Core.hpp>
 #include <ReversingSpace/Storage/File.hpp>
 
 #include <functional>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -46,8 +48,31 @@ namespace reversingspace {
 		 * probably a bad idea for many applications (particularly mods and
 		 * developer tooling), it may be useful for end-game products (should
 		 * there be a reason to try to hide how the hashing is done).
+		 *
+		 * Implementations should `enumerate` their table of contents: prefix
+		 * and glob queries are then answered from an `IdentityTree` built on
+		 * the first query (an archive does not change once loaded).
+		 *
+		 * Implementations which map their file can return entries as
+		 * `ArchiveEntryFile`s over that one mapping, which cost nothing
+		 * to open.
 		 */
 		class Archive : public FileSystem {
+		private:
+			/// Builds `identity_tree` (on the first query).
+			std::once_flag identity_tree_once;
+
+			/// Identity tree (nullptr if the archive does not enumerate).
+			IdentityTreePointer identity_tree;
+
+			/// Gets the identity tree, building it on first use.
+			const IdentityTree* query_tree() {
+				std::call_once(identity_tree_once, [this]() {
+					identity_tree = IdentityTree::build(*this);
+				});
+				return identity_tree.get();
+			}
+
 		public: // Archive specific.
 			/// Virtual deconstructor/destructor.
 			virtual ~Archive() {}
@@ -90,6 +115,36 @@ namespace reversingspace {
 			 */
 			virtual FilePointer get_file(StringIdentity identity,
 				storage::FileAccess access = storage::FileAccess::Read) = 0;
+
+			/**
+			 * @brief Enumerates the identities starting with `prefix`.
+			 * @param[in] prefix    Prefix (e.g. "shaders/").
+			 * @param[in] callback  Function called once per identity (sorted).
+			 * @return false if the archive does not enumerate.
+			 */
+			virtual bool enumerate_prefix(StringIdentity prefix, const EnumerationFunction& callback) {
+				auto tree = query_tree();
+				if (tree == nullptr) {
+					return false;
+				}
+				tree->find_prefix(prefix, callback);
+				return true;
+			}
+
+			/**
+			 * @brief Enumerates the identities matching a glob pattern.
+			 * @param[in] pattern   Pattern (see `GlobPattern`).
+			 * @param[in] callback  Function called once per identity (sorted).
+			 * @return false if the archive does not enumerate.
+			 */
+			virtual bool enumerate_glob(StringIdentity pattern, const EnumerationFunction& callback) {
+				auto tree = query_tree();
+				if (tree == nullptr) {
+					return false;
+				}
+				tree->find_glob(GlobPattern(pattern), callback);
+				return true;
+			}
 		};
 
 		/**
@@ -191,29 +246,86 @@ namespace reversingspace {
 			ArchivePointer load(const std::string& name) {
 				// Step directories (top to bottom).
 				for (auto dir = directories.rbegin(); dir != directories.rend(); ++dir) {
-					auto path = (*dir)->get_child_path(name);
-
-					// Read symlinks.
-					while (std::filesystem::is_symlink(path)) {
-						path = std::filesystem::read_symlink(path);
+					auto archive = open_archive(resolve_path((*dir)->get_child_path(name)), loaders);
+					if (archive != nullptr) {
+						// Success.
+						return archive;
 					}
+				}
+				// Failure to find or load.
+				return nullptr;
+			}
 
-					// Attempt a file load, this does an internal "is it valid" check.
-					auto storage_file = storage::File::create(path);
-					if (storage_file == nullptr) {
-						continue;
+			/**
+			 * @brief Finds an archive without opening it.
+			 * @param[in] name   Name of an archive.
+			 * @return Path of the archive (symlinks read), or an empty path if none exists.
+			 *
+			 * Directories are stepped top to bottom, as by `load`.
+			 */
+			std::filesystem::path find(const std::string& name) const {
+				for (auto dir = directories.rbegin(); dir != directories.rend(); ++dir) {
+					auto path = resolve_path((*dir)->get_child_path(name));
+					std::error_code error;
+					if (std::filesystem::is_regular_file(path, error)) {
+						return path;
 					}
+				}
+				return std::filesystem::path();
+			}
 
-					// Find a valid handler.
-					for (auto handler = loaders.begin(); handler != loaders.end(); ++handler) {
-						auto archive = (*handler)(storage_file);
-						if (archive != nullptr) {
-							// Success.
-							return archive;
-						}
+			/**
+			 * @brief Prepares an archive to be loaded on first use.
+			 * @param[in] name   Name of an archive.
+			 * @return Lazy mount over the archive, or nullptr if it cannot be found.
+			 *
+			 * Only the archive's path is found now (see `find`); it is opened,
+			 * and the loaders run, on the mount's first use.  Unlike `load`,
+			 * an archive no loader accepts does not fall through to lower
+			 * directories: the mount is then empty.  The loaders are copied,
+			 * so the mount does not depend on this system.
+			 */
+			LazyMountPointer load_lazy(const std::string& name) const {
+				auto path = find(name);
+				if (path.empty()) {
+					return nullptr;
+				}
+				auto archive_loaders = loaders;
+				return LazyMount::create(path, [path, archive_loaders]() -> FileSystemPointer {
+					return open_archive(path, archive_loaders);
+				});
+			}
+
+		private:
+			/// Reads symlinks.
+			static std::filesystem::path resolve_path(std::filesystem::path path) {
+				while (std::filesystem::is_symlink(path)) {
+					path = std::filesystem::read_symlink(path);
+				}
+				return path;
+			}
+
+			/**
+			 * @brief Opens an archive with the first loader accepting it.
+			 * @param[in] path     Path of the archive.
+			 * @param[in] loaders  Loaders to try, in order.
+			 * @return Archive, or nullptr on failure.
+			 */
+			static ArchivePointer open_archive(const std::filesystem::path& path,
+				const std::vector<ArchiveLoaderFunc>& loaders) {
+				// Attempt a file load, this does an internal "is it valid" check.
+				auto storage_file = storage::File::create(path);
+				if (storage_file == nullptr) {
+					return nullptr;
+				}
+
+				// Find a valid handler.
+				for (auto handler = loaders.begin(); handler != loaders.end(); ++handler) {
+					auto archive = (*handler)(storage_file);
+					if (archive != nullptr) {
+						return archive;
 					}
 				}
-				// Failure to find or load.
 				return nullptr;
 			}
 		};
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_ARCHIVEENTRYFILE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_ARCHIVEENTRYFILE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/ReadOnlyFile.hpp>
+#include <ReversingSpace/Storage/File.hpp>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `ArchiveEntryFile`.
+		class ArchiveEntryFile;
+
+		/// Shared pointer type for `ArchiveEntryFile`.
+		using ArchiveEntryFilePointer = std::shared_ptr<ArchiveEntryFile>;
+
+		/**
+		 * @brief Read-only file over a byte range of an archive's mapping.
+		 *
+		 * Archives map their file once and hand out one of these per
+		 * entry: it holds the shared `storage::View` (which holds the
+		 * `storage::File`), the range and its own cursor, so opening an
+		 * entry makes no system call and no mapping, and reads are
+		 * copies out of the existing mapping.  (`PlatformFile`, by
+		 * contrast, maps on every read.)
+		 *
+		 * The entry keeps the mapping alive, so it may outlive the
+		 * archive it came from.  Writes are refused.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API ArchiveEntryFile : public ReadOnlyFile {
+		private:
+			/// Mapping the entry lies in.
+			storage::ViewPointer view;
+
+			/// Start of the entry (within `view`).
+			const char* begin;
+
+		public:
+			/// Use `create`.
+			ArchiveEntryFile(storage::ViewPointer view, const char* begin, storage::StorageSize size)
+				: ReadOnlyFile(size), view(std::move(view)), begin(begin) {}
+
+			/**
+			 * @brief Creates an entry over part of a mapping.
+			 * @param[in] view    Mapping (shared with the archive and its other entries).
+			 * @param[in] offset  Offset of the entry within the view.
+			 * @param[in] size    Size of the entry.
+			 * @return Entry, or nullptr if the range does not lie within the view.
+			 */
+			static ArchiveEntryFilePointer create(storage::ViewPointer view,
+				storage::StorageSize offset, storage::StorageSize size);
+
+			/// Gets the mapping.
+			storage::ViewPointer get_view() const {
+				return view;
+			}
+
+			/**
+			 * @brief Gets the entry's bytes in place (`get_size` of them).
+			 *
+			 * Valid for as long as the entry (or its view) lives, and
+			 * avoids the copy a `read` makes.
+			 */
+			const char* get_data() const {
+				return begin;
+			}
+
+		public: // ReadOnlyFile
+			using ReadOnlyFile::read_from;
+
+			storage::StorageSize read_from(storage::StorageOffset offset,
+				char* data, storage::StorageSize requested);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_ARCHIVEENTRYFILE_HPP
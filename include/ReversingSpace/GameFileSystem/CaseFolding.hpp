@@ -0,0 +1,75 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+/**
+ * @file CaseFolding.hpp
+ * @brief Case folding of identities (for case-insensitive look-ups).
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_CASEFOLDING_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_CASEFOLDING_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// memcpy
+#include <cstring>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Folds a name to lower case.
+		 * @param[in] data    Name.
+		 * @param[in] length  Length of the name, in bytes.
+		 * @param[out] out    Storage for `length` bytes (may be `data`).
+		 *
+		 * Only ASCII letters are folded; other bytes (including UTF-8
+		 * sequences) are copied unchanged, so the folded name is the same
+		 * length.  Eight bytes are folded at a time: for each byte below
+		 * 0x80, the range test against 'A'..'Z' is done with two additions
+		 * on the whole word, and the case bit is set where both agree.
+		 */
+		inline void fold_case(const char* data, size_t length, char* out) {
+			const std::uint64_t ONES = 0x0101010101010101ULL;
+			const std::uint64_t HIGH = 0x8080808080808080ULL;
+			size_t i = 0;
+			for (; i + 8 <= length; i += 8) {
+				std::uint64_t word;
+				memcpy(&word, data + i, 8);
+				std::uint64_t low7 = word & ~HIGH;
+				std::uint64_t above_z = low7 + ONES * (0x7F - 'Z');
+				std::uint64_t from_a = low7 + ONES * (0x80 - 'A');
+				std::uint64_t upper = (from_a ^ above_z) & ~word & HIGH;
+				word |= upper >> 2;
+				memcpy(out + i, &word, 8);
+			}
+			for (; i < length; ++i) {
+				char c = data[i];
+				out[i] = (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+			}
+		}
+
+		/**
+		 * @brief Folds a name to lower case (see `fold_case` above).
+		 * @param[in] name  Name.
+		 * @return Folded copy.
+		 */
+		inline std::string fold_case(StringIdentity name) {
+			std::string folded(name.size(), '\0');
+			if (!name.empty()) {
+				fold_case(name.data(), name.size(), &folded[0]);
+			}
+			return folded;
+		}
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_CASEFOLDING_HPP
@@ -0,0 +1,194 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSEDENTRYFILE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSEDENTRYFILE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/ReadOnlyFile.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+#include <ReversingSpace/Storage/File.hpp>
+
+// std::mutex
+#include <mutex>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `CompressedEntryFile`.
+		class CompressedEntryFile;
+
+		/// Shared pointer type for `CompressedEntryFile`.
+		using CompressedEntryFilePointer = std::shared_ptr<CompressedEntryFile>;
+
+		/**
+		 * @brief Read-only file over a block-compressed archive entry.
+		 *
+		 * The entry is cut into fixed-size blocks, each compressed on its
+		 * own (`lz_compress`), and stored as a block table followed by
+		 * the blocks:
+		 * - The table holds one 64-bit end offset per block, relative to
+		 *   the start of the entry (block `i` starts where block `i - 1`
+		 *   ends, the first just after the table);
+		 * - A block whose stored size equals its decompressed size was
+		 *   not worth compressing and is stored as-is.
+		 *
+		 * Like `ArchiveEntryFile`, this shares the archive's mapping and
+		 * costs nothing to open.  Reads decompress only the blocks they
+		 * cover: whole blocks straight into the caller's buffer, partial
+		 * ones through a one-block cache, so small sequential reads
+		 * decompress each block once.  A damaged block ends the read
+		 * short (nothing is read out of range).
+		 *
+		 * Given a worker pool (`set_worker_pool`), a read covering several
+		 * whole blocks decompresses them on the pool and the calling
+		 * thread at once, each block straight into its place in the
+		 * caller's buffer.  Either way the stored blocks are prefetched
+		 * a few ahead of those being decompressed, so reading the next
+		 * overlaps decompressing this one.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API CompressedEntryFile : public ReadOnlyFile {
+		public:
+			/// Default block size.
+			static const std::uint32_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+		private:
+			/// Mapping the entry lies in.
+			storage::ViewPointer view;
+
+			/// Start of the stored entry (the block table).
+			const char* begin;
+
+			/// Size of the stored entry.
+			storage::StorageSize stored_size;
+
+			/// Decompressed size of every block but the last.
+			std::uint32_t block_size;
+
+			/// Number of blocks.
+			storage::StorageSize block_count;
+
+			/// Block last decompressed for a partial read.
+			std::vector<char> cache;
+
+			/// Index of the cached block (`block_count`: none).
+			storage::StorageSize cached_block;
+
+			/// Cache mutex.
+			std::mutex cache_mutex;
+
+			/// Pool for multi-block reads (nullptr: the calling thread only).
+			WorkerPoolPointer pool;
+
+			/// Asks for the stored bytes of blocks [first, first + count) to be read in.
+			void prefetch_blocks(storage::StorageSize first, storage::StorageSize count) const;
+
+			/**
+			 * @brief Decompresses consecutive whole blocks into place.
+			 * @return Number of blocks decompressed before the first damaged one.
+			 */
+			storage::StorageSize read_blocks(storage::StorageSize first,
+				storage::StorageSize count, char* out) const;
+
+		public:
+			/// Use `create`.
+			CompressedEntryFile(storage::ViewPointer view, const char* begin, storage::StorageSize stored_size,
+				storage::StorageSize size, std::uint32_t block_size);
+
+			/**
+			 * @brief Creates a file over a block-compressed entry.
+			 * @param[in] view         Mapping (shared with the archive and its other entries).
+			 * @param[in] offset       Offset of the stored entry within the view.
+			 * @param[in] stored_size  Size of the stored entry (table and blocks).
+			 * @param[in] size         Size of the decompressed entry.
+			 * @param[in] block_size   Decompressed size of each block.
+			 * @return File, or nullptr if the range does not lie within the
+			 *         view or cannot hold the block table.
+			 *
+			 * Blocks are checked as they are read, not here.
+			 */
+			static CompressedEntryFilePointer create(storage::ViewPointer view,
+				storage::StorageSize offset, storage::StorageSize stored_size,
+				storage::StorageSize size, std::uint32_t block_size);
+
+			/**
+			 * @brief Compresses an entry into the stored layout.
+			 * @param[in] data        Entry.
+			 * @param[in] size        Size of the entry.
+			 * @param[in] block_size  Decompressed size of each block.
+			 * @param[out] stored     Table and blocks (replaced).
+			 */
+			static void compress(const char* data, storage::StorageSize size,
+				std::uint32_t block_size, std::vector<char>& stored);
+
+			/**
+			 * @brief Compresses consecutive blocks (for entries written piecemeal).
+			 * @param[in] data        Whole blocks of the entry (only the entry's last may be short).
+			 * @param[in] size        Size of `data`.
+			 * @param[in] block_size  Decompressed size of each block.
+			 * @param[in] base        Offset (within the stored entry) at which `blocks` will be written.
+			 * @param[out] blocks     Compressed blocks (appended).
+			 * @param[out] ends       End offset of each block (appended, for the table).
+			 */
+			static void compress_blocks(const char* data, storage::StorageSize size,
+				std::uint32_t block_size, storage::StorageSize base,
+				std::vector<char>& blocks, std::vector<std::uint64_t>& ends);
+
+			/**
+			 * @brief Decompresses one block.
+			 * @param[in] block  Index of the block.
+			 * @param[out] out   Destination (the block's decompressed size).
+			 * @return false if the block is damaged.
+			 */
+			bool read_block(storage::StorageSize block, char* out) const;
+
+			/// Sets the pool multi-block reads are decompressed on (nullptr: calling thread only).
+			void set_worker_pool(WorkerPoolPointer worker_pool) {
+				pool = std::move(worker_pool);
+			}
+
+			/// Number of blocks.
+			storage::StorageSize get_block_count() const {
+				return block_count;
+			}
+
+			/// Decompressed size of every block but the last.
+			std::uint32_t get_block_size() const {
+				return block_size;
+			}
+
+			/// Size of the stored (compressed) entry.
+			storage::StorageSize get_stored_size() const {
+				return stored_size;
+			}
+
+		public: // ReadOnlyFile
+			using ReadOnlyFile::read_from;
+
+			storage::StorageSize read_from(storage::StorageOffset offset,
+				char* data, storage::StorageSize requested);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSEDENTRYFILE_HPP
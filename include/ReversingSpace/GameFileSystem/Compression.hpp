@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSION_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSION_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Worst-case size of `lz_compress`'s output.
+		 * @param[in] size  Size of the input.
+		 * @return Output size which always suffices.
+		 */
+		constexpr size_t lz_compress_bound(size_t size) {
+			return size + size / 255 + 16;
+		}
+
+		/**
+		 * @brief Compresses a buffer with the built-in LZ codec.
+		 * @param[in] source       Input.
+		 * @param[in] size         Size of the input.
+		 * @param[out] target      Output.
+		 * @param[in] capacity     Size of the output buffer.
+		 * @return Size of the output, or 0 if it would not fit in `capacity`.
+		 *
+		 * A byte-oriented LZ77 (in the manner of LZ4): each sequence is a
+		 * token (literal and match lengths), the literals, and a 16-bit
+		 * offset back into the output.  Matches are found through a hash
+		 * of the next four bytes, greedily, so compression is fast and
+		 * decompression is little more than copying.  Each buffer is
+		 * self-contained (no dictionary carries over), so blocks can be
+		 * decompressed independently.
+		 */
+		REVSPACE_GAMEFILESYSTEM_API size_t lz_compress(const char* source, size_t size,
+			char* target, size_t capacity);
+
+		/**
+		 * @brief Decompresses the output of `lz_compress`.
+		 * @param[in] source       Input.
+		 * @param[in] size         Size of the input.
+		 * @param[out] target      Output.
+		 * @param[in] target_size  Exact size of the decompressed data.
+		 * @return false if the input is malformed or does not decompress
+		 *         to exactly `target_size` bytes (nothing is written out of range).
+		 */
+		REVSPACE_GAMEFILESYSTEM_API bool lz_decompress(const char* source, size_t size,
+			char* target, size_t target_size);
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_COMPRESSION_HPP
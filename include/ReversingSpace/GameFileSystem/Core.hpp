@@ -35,6 +35,9 @@
 // std::string
 #include <string>
 
+// std::string_view
+#include <string_view>
+
 namespace reversingspace {
 	namespace gfs {
 		/// If the file is below this size it will be completely mapped
@@ -45,13 +48,22 @@ namespace reversingspace {
 		using HashedIdentity = std::uint64_t;
 
 		/// String identity.
-		using StringIdentity = const std::string&;
+		///
+		/// A view, so callers holding a literal, a `std::string` or a slice
+		/// of a larger buffer can look a name up without allocating.  The
+		/// view is only borrowed for the duration of the call.
+		using StringIdentity = std::string_view;
 
 		/**
 		 * @brief Function used for hashing.
 		 */
 		using HashFunction = std::function<HashedIdentity(StringIdentity name)>;
 
+		/**
+		 * @brief Function used for enumerating identities.
+		 */
+		using EnumerationFunction = std::function<void(StringIdentity name)>;
+
 		// Forward for `File`.
 		class File;
 
@@ -78,6 +90,12 @@ namespace reversingspace {
 		/// Shared pointer type for `File`.
 		using ArchivePointer = std::shared_ptr<Archive>;
 
+		// Forward for `LazyMount`.
+		class LazyMount;
+
+		/// Shared pointer type for `LazyMount`.
+		using LazyMountPointer = std::shared_ptr<LazyMount>;
+
 		// Forward for `PlatformFile`.
 		class REVSPACE_GAMEFILESYSTEM_API PlatformFile;
 
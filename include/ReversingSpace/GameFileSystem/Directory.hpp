@@ -13,12 +13,47 @@
 #ifndef REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORY_HPP
 #define REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORY_HPP
 
+#include <ReversingSpace/GameFileSystem/CaseFolding.hpp>
 #include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/DirectoryHandle.hpp>
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+#include <ReversingSpace/GameFileSystem/DirectoryWatcher.hpp>
 #include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
 #include <ReversingSpace/Storage/Core.hpp>
 
+// std::atomic (case folding flag)
+#include <atomic>
+
+// memcpy (stamps)
+#include <cstring>
+
+// std::unique_lock
+#include <mutex>
+
+// std::shared_mutex
+#include <shared_mutex>
+
+// std::void_t
+#include <type_traits>
+
+// std::unordered_map (hash index)
+#include <unordered_map>
+
 namespace reversingspace {
 	namespace gfs {
+		/**
+		 * @brief Whether a file type can wrap an opened `storage::File`
+		 * (`FileType::create(storage::FilePointer)`), which lets `Directory`
+		 * open it relative to a `DirectoryHandle`.
+		 */
+		template<class FileType, class = void>
+		struct wraps_stored_file : std::false_type {};
+
+		template<class FileType>
+		struct wraps_stored_file<FileType,
+			std::void_t<decltype(FileType::create(std::declval<storage::FilePointer>()))>> : std::true_type {};
+
 		/**
 		 * @brief Directory Implementation.
 		 */
@@ -28,6 +63,438 @@ namespace reversingspace {
 			/// Directory path.
 			std::filesystem::path path;
 
+			/// Hash function used for hashed look-ups (may be nullptr).
+			HashFunction hash_function;
+
+			/**
+			 * @brief Hashed identity -> relative path.
+			 *
+			 * Built on the first hashed look-up (see `hash_index_built`).
+			 * Paths are views into `hash_names`.
+			 */
+			std::unordered_map<HashedIdentity, StringIdentity> hash_index;
+
+			/// Storage for the relative paths in `hash_index`.
+			NameArena hash_names;
+
+			/// Whether `hash_index` reflects the directory.
+			bool hash_index_built = false;
+
+			/// Guards `hash_function`, `hash_index` and `hash_index_built`.
+			mutable std::shared_mutex hash_index_mutex;
+
+			/// Drops the hash index (caller holds `hash_index_mutex`).
+			void clear_hash_index() {
+				hash_index.clear();
+				hash_names.clear();
+				hash_index_built = false;
+			}
+
+			/**
+			 * @brief Whether string look-ups ignore ASCII case (see `set_case_folding`).
+			 *
+			 * Changed under `folded_index_mutex`, but read without it first,
+			 * so look-ups which do not fold neither fold nor lock.
+			 */
+			std::atomic<bool> case_folding{ false };
+
+			/**
+			 * @brief Folded relative path -> real relative path.
+			 *
+			 * Built on the first string look-up while folding (see
+			 * `folded_index_built`).  Real paths are views into `folded_names`.
+			 */
+			IdentityMap<StringIdentity> folded_index;
+
+			/// Storage for the real paths in `folded_index`.
+			NameArena folded_names;
+
+			/// Whether `folded_index` reflects the directory.
+			bool folded_index_built = false;
+
+			/// Guards changes to `case_folding`, and `folded_index` and `folded_index_built`.
+			mutable std::shared_mutex folded_index_mutex;
+
+			/// Drops the folded index (caller holds `folded_index_mutex`).
+			void clear_folded_index() {
+				folded_index.clear();
+				folded_names.clear();
+				folded_index_built = false;
+			}
+
+			/// Adds a real path to the folded index (first casing wins; caller holds `folded_index_mutex`).
+			void insert_folded(StringIdentity real) {
+				auto folded = fold_case(real);
+				if (folded_index.count(folded) == 0) {
+					folded_index[folded] = folded_names.store(real);
+				}
+			}
+
+			/// Pool for recursive scans (may be nullptr; accessed atomically).
+			WorkerPoolPointer scan_pool;
+
+			/**
+			 * @brief Identity tree answering prefix and glob queries.
+			 *
+			 * Built on the first query; nullptr until then and after changes.
+			 */
+			IdentityTreePointer identity_tree;
+
+			/// Guards `identity_tree` (and serialises building it).
+			std::mutex identity_tree_mutex;
+
+			/**
+			 * @brief Gets the identity tree, building it if needed.
+			 * @return Tree, or nullptr while folding case (see `enumerate`).
+			 */
+			IdentityTreePointer query_tree() {
+				if (is_case_folding()) {
+					return nullptr;
+				}
+				std::lock_guard<std::mutex> lock(identity_tree_mutex);
+				if (identity_tree == nullptr) {
+					// The listing is already sorted; the tree copies the names.
+					std::vector<StringIdentity> names;
+					auto listing = scan();
+					if (listing != nullptr) {
+						names.reserve(listing->size());
+						for (auto& entry : *listing) {
+							if (entry.type == EntryType::File) {
+								names.push_back(entry.name);
+							}
+						}
+					}
+					identity_tree = IdentityTree::create(std::move(names));
+				}
+				return identity_tree;
+			}
+
+			/// Opens `handle` (once, on first use).
+			std::once_flag handle_once;
+
+			/// Handle on the root (nullptr if unsupported; see `root_handle`).
+			DirectoryHandlePointer handle;
+
+			/**
+			 * @brief Gets the handle on the root, opening it on first use.
+			 * @return Handle, or nullptr if relative opens are unsupported.
+			 */
+			DirectoryHandle* root_handle() {
+				std::call_once(handle_once, [this]() {
+					handle = DirectoryHandle::create(path);
+				});
+				return handle.get();
+			}
+
+			/**
+			 * @brief Opens a child.
+			 * @tparam OtherFileType  Type of file to create.
+			 * @param[in] identity  Relative path of the child.
+			 * @param[in] access    Access type.
+			 * @return Pointer to a file, or nullptr on failure.
+			 *
+			 * Read-only opens go through the root handle (`openat` on a cached
+			 * parent descriptor) where the file type and platform allow it;
+			 * anything else (including writes, which may need to create
+			 * directories) opens by full path.
+			 */
+			template<class OtherFileType>
+			FilePointer open_child(StringIdentity identity, storage::FileAccess access) {
+				if constexpr (wraps_stored_file<OtherFileType>::value) {
+					bool read_only = !((int)access & (int)storage::FileAccess::Write);
+					if (read_only && !identity.empty() && identity.front() != '/') {
+						if (auto root = root_handle()) {
+							return OtherFileType::create(root->open(identity, child_path(identity), access));
+						}
+					}
+				}
+				return OtherFileType::create(child_path(identity), access);
+			}
+
+			/// Guards `watcher`.
+			std::mutex watcher_mutex;
+
+			/**
+			 * @brief Change watcher (nullptr unless watching).
+			 *
+			 * Declared last, so it is stopped before anything it updates is
+			 * destroyed.
+			 */
+			DirectoryWatcherPointer watcher;
+
+			/**
+			 * @brief Applies a batch of changes to the folded index.
+			 * @param[in] changes  Changes reported by the watcher.
+			 */
+			void apply_folded_changes(const DirectoryChanges& changes) {
+				std::unique_lock lock(folded_index_mutex);
+				if (!folded_index_built) {
+					return; // Built fresh on the next folded look-up.
+				}
+				for (auto& change : changes) {
+					switch (change.kind) {
+						case DirectoryChange::Kind::Added: {
+							insert_folded(change.identity);
+						} break;
+						case DirectoryChange::Kind::Removed: {
+							auto entry = folded_index.find(fold_case(change.identity));
+							if (entry != folded_index.end() && entry->second == change.identity) {
+								folded_index.erase(entry);
+							}
+						} break;
+						case DirectoryChange::Kind::Rescan: {
+							clear_folded_index();
+							return;
+						}
+						default: break;
+					}
+				}
+			}
+
+			/**
+			 * @brief Applies a batch of changes to the hash index.
+			 * @param[in] changes  Changes reported by the watcher.
+			 */
+			void apply_changes(const DirectoryChanges& changes) {
+				for (auto& change : changes) {
+					if (change.kind == DirectoryChange::Kind::Rescan) {
+						// Directories may have moved; reopen them as needed.
+						if (auto root = root_handle()) {
+							root->forget();
+						}
+						break;
+					}
+				}
+				for (auto& change : changes) {
+					if (change.kind != DirectoryChange::Kind::Modified) {
+						// The tree is immutable; the next query rebuilds it.
+						invalidate_query_index();
+						break;
+					}
+				}
+
+				apply_folded_changes(changes);
+
+				std::unique_lock lock(hash_index_mutex);
+				if (!hash_index_built) {
+					return; // Built fresh on the next hashed look-up.
+				}
+				for (auto& change : changes) {
+					switch (change.kind) {
+						case DirectoryChange::Kind::Added: {
+							auto hashed = hash_function(change.identity);
+							if (hash_index.count(hashed) == 0) {
+								hash_index.emplace(hashed, hash_names.store(change.identity));
+							}
+						} break;
+						case DirectoryChange::Kind::Removed: {
+							auto entry = hash_index.find(hash_function(change.identity));
+							if (entry != hash_index.end() && entry->second == change.identity) {
+								hash_index.erase(entry);
+							}
+						} break;
+						case DirectoryChange::Kind::Rescan: {
+							clear_hash_index();
+							return;
+						}
+						default: break;
+					}
+				}
+			}
+
+			/**
+			 * @brief Builds the full path of a child.
+			 * @param[in] identity  Relative path of the child.
+			 * @return Full path.
+			 *
+			 * On POSIX the native string is assembled once and moved into
+			 * the path, so this costs a single allocation (`path / identity`
+			 * builds a temporary and then appends to it).
+			 */
+			std::filesystem::path child_path(StringIdentity identity) const {
+#if defined(_WIN32)
+				return path / identity;
+#else
+				const auto& root = path.native();
+				if (root.empty() || (!identity.empty() && identity.front() == '/')) {
+					return path / identity;
+				}
+				std::string native;
+				native.reserve(root.size() + 1 + identity.size());
+				native.append(root);
+				if (root.back() != '/') {
+					native.push_back('/');
+				}
+				native.append(identity.data(), identity.size());
+				return std::filesystem::path(std::move(native));
+#endif//defined(_WIN32)
+			}
+
+			/**
+			 * @brief Looks up a hashed identity, building the index if needed.
+			 * @param[in] identity  Hashed identity.
+			 * @param[out] relative  Relative path of the file (copied, as the index may change once unlocked).
+			 * @return true if the identity is known.
+			 */
+			bool find_hashed(HashedIdentity identity, std::string& relative) {
+				{
+					std::shared_lock lock(hash_index_mutex);
+					if (hash_function == nullptr) {
+						return false;
+					}
+					if (hash_index_built) {
+						auto entry = hash_index.find(identity);
+						if (entry == hash_index.end()) {
+							return false;
+						}
+						relative.assign(entry->second);
+						return true;
+					}
+				}
+
+				std::unique_lock lock(hash_index_mutex);
+				if (!hash_index_built && hash_function != nullptr) {
+					clear_hash_index();
+					for_each_file([this](StringIdentity child) {
+						// First name wins on collision.
+						auto hashed = hash_function(child);
+						if (hash_index.count(hashed) == 0) {
+							hash_index.emplace(hashed, hash_names.store(child));
+						}
+					});
+					hash_index_built = true;
+				}
+				auto entry = hash_index.find(identity);
+				if (entry == hash_index.end()) {
+					return false;
+				}
+				relative.assign(entry->second);
+				return true;
+			}
+
+			/**
+			 * @brief Resolves the real casing of an identity, if folding.
+			 * @param[in] identity   Identity, in any casing.
+			 * @param[out] relative  Real relative path (copied), or empty if there is none.
+			 * @return false if case folding is off (`relative` is untouched).
+			 *
+			 * This is one hash look-up once the folded index is built (on
+			 * the first call while folding), and one atomic load otherwise.
+			 */
+			bool find_folded(StringIdentity identity, std::string& relative) {
+				if (!case_folding.load(std::memory_order_acquire)) {
+					return false;
+				}
+
+				// Fold into a stack buffer where it fits.
+				char buffer[256];
+				std::string long_name;
+				char* folded_data = buffer;
+				if (identity.size() > sizeof(buffer)) {
+					long_name.resize(identity.size());
+					folded_data = &long_name[0];
+				}
+				fold_case(identity.data(), identity.size(), folded_data);
+				StringIdentity folded(folded_data, identity.size());
+
+				{
+					std::shared_lock lock(folded_index_mutex);
+					if (!case_folding) {
+						return false;
+					}
+					if (folded_index_built) {
+						auto entry = folded_index.find(folded);
+						relative.assign((entry != folded_index.end()) ? entry->second : StringIdentity());
+						return true;
+					}
+				}
+
+				std::unique_lock lock(folded_index_mutex);
+				if (!case_folding) {
+					return false;
+				}
+				if (!folded_index_built) {
+					clear_folded_index();
+					for_each_file([this](StringIdentity child) {
+						insert_folded(child);
+					});
+					folded_index_built = true;
+				}
+				auto entry = folded_index.find(folded);
+				relative.assign((entry != folded_index.end()) ? entry->second : StringIdentity());
+				return true;
+			}
+
+			/**
+			 * @brief Opens a child by string identity (resolving its casing if folding).
+			 * @tparam OtherFileType  Type of file to create.
+			 * @param[in] identity  Relative path of the child.
+			 * @param[in] access    Access type.
+			 * @return Pointer to a file, or nullptr on failure.
+			 *
+			 * While folding, an identity with no match can still be created
+			 * (with the casing given) by a writing open.
+			 */
+			template<class OtherFileType>
+			FilePointer open_named(StringIdentity identity, storage::FileAccess access) {
+				std::string relative;
+				if (find_folded(identity, relative)) {
+					if (!relative.empty()) {
+						return open_child<OtherFileType>(relative, access);
+					}
+					if (!((int)access & (int)storage::FileAccess::Write)) {
+						return nullptr;
+					}
+				}
+				return open_child<OtherFileType>(identity, access);
+			}
+
+			/**
+			 * @brief Calls `callback` with every regular file below the directory.
+			 * @param[in] callback  Function called once per identity (sorted).
+			 */
+			void for_each_file(const EnumerationFunction& callback) const {
+				auto listing = scan();
+				if (listing == nullptr) {
+					return;
+				}
+				for (auto& entry : *listing) {
+					if (entry.type == EntryType::File) {
+						callback(entry.name);
+					}
+				}
+			}
+
+			/**
+			 * @brief Gets the modification time of a directory below this one.
+			 * @param[in] relative  Relative path ("" for this directory).
+			 * @param[out] time     Modification time (in the file clock's units).
+			 * @return false if it cannot be read.
+			 */
+			bool directory_time(StringIdentity relative, std::int64_t& time) const {
+				std::error_code error;
+				auto written = std::filesystem::last_write_time(
+					relative.empty() ? path : child_path(relative), error);
+				if (error) {
+					return false;
+				}
+				time = (std::int64_t)written.time_since_epoch().count();
+				return true;
+			}
+
+			/// Appends a directory's record (length, path, time) to a stamp.
+			bool append_stamp(std::string& stamp, StringIdentity relative) const {
+				std::int64_t time = 0;
+				if (!directory_time(relative, time)) {
+					return false;
+				}
+				auto length = (std::uint32_t)relative.size();
+				stamp.append((const char*)&length, sizeof(length));
+				stamp.append(relative);
+				stamp.append((const char*)&time, sizeof(time));
+				return true;
+			}
+
 		public:
 			/**
 			 * @brief Gets a child path from the directory.
@@ -116,36 +583,316 @@ namespace reversingspace {
 				return nullptr;
 			}
 
+			/**
+			 * @brief Lists the directory's children in a single pass.
+			 * @param[in] metadata  Fill in sizes and modification times.
+			 * @return Listing, or nullptr if the directory cannot be read.
+			 */
+			DirectoryListingPointer list(bool metadata = false) const {
+				return DirectoryListing::create(path, metadata);
+			}
+
+			/**
+			 * @brief Lists the whole tree below the directory.
+			 * @param[in] metadata  Fill in sizes and modification times.
+			 * @return Listing (sorted by relative path), or nullptr if the directory cannot be read.
+			 *
+			 * Subdirectories are read in parallel if a pool has been set
+			 * (see `set_worker_pool`).
+			 */
+			DirectoryListingPointer scan(bool metadata = false) const {
+				return DirectoryListing::scan(path, metadata, std::atomic_load(&scan_pool));
+			}
+
+			/**
+			 * @brief Sets the pool used by recursive scans.
+			 * @param[in] pool  Pool (nullptr scans on the calling thread).
+			 *
+			 * Scans back `enumerate`, and so the hash index, the merged index
+			 * of a `StorageServer` and identity filters.
+			 */
+			void set_worker_pool(WorkerPoolPointer pool) {
+				std::atomic_store(&scan_pool, pool);
+			}
+
 			/// Gets the number of child directories.
 			size_t directory_count() {
-				return (size_t)std::count_if(
-					std::filesystem::directory_iterator(path),
-					std::filesystem::directory_iterator(),
-					static_cast<bool(*)(const std::filesystem::path&)>(std::filesystem::is_directory)
-				);
+				auto listing = list();
+				return (listing != nullptr) ? listing->count(EntryType::Directory) : 0;
 			}
 
 			/// Gets the number of child files.
 			size_t file_count() {
-				return (size_t)std::count_if(
-					std::filesystem::directory_iterator(path),
-					std::filesystem::directory_iterator(),
-					static_cast<bool(*)(const std::filesystem::path&)>(std::filesystem::is_regular_file)
-				);
+				auto listing = list();
+				return (listing != nullptr) ? listing->count(EntryType::File) : 0;
+			}
+
+		public: // Hashed look-ups
+			/**
+			 * @brief Sets the hash function used for hashed look-ups.
+			 * @param[in] function  Hash function (nullptr disables hashed look-ups).
+			 *
+			 * The hash index is built lazily, on the first hashed look-up, by
+			 * scanning the whole tree and hashing every (relative) identity:
+			 * that first look-up costs as much as `enumerate`.  Later ones are
+			 * one hash look-up.
+			 *
+			 * Unless the directory is watched, the index is not rebuilt when
+			 * files are added or removed: a file added afterwards is not found
+			 * by hash until `invalidate_hash_index` (or `set_hash_function`)
+			 * is called.
+			 */
+			void set_hash_function(HashFunction function) {
+				std::unique_lock lock(hash_index_mutex);
+				hash_function = function;
+				clear_hash_index();
+			}
+
+			/**
+			 * @brief Drops the hash index; the next hashed look-up rebuilds it.
+			 *
+			 * The index does not notice files appearing or vanishing.
+			 */
+			void invalidate_hash_index() {
+				std::unique_lock lock(hash_index_mutex);
+				clear_hash_index();
+			}
+
+		public: // Prefix and glob queries
+			/**
+			 * @brief Drops the identity tree; the next query rebuilds it.
+			 *
+			 * The tree is built by scanning the directory once, on the first
+			 * `enumerate_prefix` or `enumerate_glob`; later queries do not
+			 * touch the disk.  Like the hash index it does not notice files
+			 * appearing or vanishing unless the directory is watched.
+			 */
+			void invalidate_query_index() {
+				std::lock_guard<std::mutex> lock(identity_tree_mutex);
+				identity_tree = nullptr;
+			}
+
+		public: // Case-insensitive look-ups
+			/**
+			 * @brief Enables or disables case-insensitive string look-ups.
+			 * @param[in] enabled  Whether to fold case.
+			 *
+			 * While folding, `get_file("Textures/UI.DDS")` finds
+			 * `textures/ui.dds`: a folded path -> real path index is built
+			 * once (on the first string look-up) and each look-up is a single
+			 * hash look-up.  Only ASCII letters are folded; where several
+			 * files differ only in case, the first in sorted order wins.
+			 * Hashed look-ups are unaffected.
+			 *
+			 * A folding directory does not enumerate (its identities are not
+			 * the exact names), so a `StorageServer` probes it in place
+			 * rather than indexing or filtering it; enable this before
+			 * mounting.
+			 */
+			void set_case_folding(bool enabled) {
+				std::unique_lock lock(folded_index_mutex);
+				case_folding = enabled;
+				clear_folded_index();
+			}
+
+			/// Whether string look-ups ignore case.
+			bool is_case_folding() const {
+				return case_folding.load(std::memory_order_acquire);
 			}
 
 		public: // FileSystem
+			/**
+			 * @brief Adopts the hash function if one has not been set.
+			 * @param[in] function  Hash function used by the owner.
+			 *
+			 * Nothing is scanned until the first hashed look-up (see
+			 * `set_hash_function`).
+			 */
+			void offer_hash_function(const HashFunction& function) {
+				{
+					std::shared_lock lock(hash_index_mutex);
+					if (hash_function != nullptr) {
+						return;
+					}
+				}
+				set_hash_function(function);
+			}
+
+			/// Hashed identities are hashes of the directory's own (string) identities.
+			bool resolves_unlisted_hashes() {
+				return false;
+			}
+
+			/**
+			 * @brief Builds a filter over the directory's identities.
+			 * @return Filter (covering hashed identities if a hash function is set).
+			 */
+			IdentityFilterPointer build_identity_filter() {
+				HashFunction function;
+				{
+					std::shared_lock lock(hash_index_mutex);
+					function = hash_function;
+				}
+				return IdentityFilter::build(*this, function);
+			}
+
+			/**
+			 * @brief Describes the directory tree's contents.
+			 * @param[out] stamp  Relative path and modification time of every directory.
+			 * @return false while folding case, or if the tree cannot be read.
+			 *
+			 * Adding, removing or renaming a file changes its directory's
+			 * modification time, so `check_stamp` costs one `stat` per
+			 * directory and reads no listings.  (Rewriting a file in place
+			 * does not, but leaves the identities unchanged.)
+			 */
+			bool get_stamp(std::string& stamp) {
+				if (is_case_folding()) {
+					return false;
+				}
+				auto listing = scan();
+				if (listing == nullptr) {
+					return false;
+				}
+				stamp.clear();
+				if (!append_stamp(stamp, StringIdentity())) {
+					return false;
+				}
+				for (auto& entry : *listing) {
+					if (entry.type == EntryType::Directory && !append_stamp(stamp, entry.name)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * @brief Checks a stamp from `get_stamp`.
+			 * @param[in] stamp  Stamp saved earlier.
+			 * @return true if no directory in it has changed (or vanished).
+			 *
+			 * New directories show up as a change to their parent.
+			 */
+			bool check_stamp(StringIdentity stamp) {
+				if (stamp.empty() || is_case_folding()) {
+					return false;
+				}
+				size_t offset = 0;
+				while (offset < stamp.size()) {
+					std::uint32_t length = 0;
+					std::int64_t saved = 0;
+					std::int64_t current = 0;
+					if (stamp.size() - offset < sizeof(length)) {
+						return false;
+					}
+					memcpy(&length, stamp.data() + offset, sizeof(length));
+					offset += sizeof(length);
+					if (stamp.size() - offset < (size_t)length + sizeof(saved)) {
+						return false;
+					}
+					auto relative = stamp.substr(offset, length);
+					offset += length;
+					memcpy(&saved, stamp.data() + offset, sizeof(saved));
+					offset += sizeof(saved);
+					if (!directory_time(relative, current) || current != saved) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * @brief Watches the directory for changes.
+			 * @param[in] callback  Also receives each batch (may be nullptr).
+			 * @return false if watching is unsupported on this platform.
+			 *
+			 * The hash index is updated incrementally from each batch (so it
+			 * stays valid without rebuilding) before `callback` is called.
+			 */
+			bool watch(const DirectoryChangeFunction& callback) {
+				std::lock_guard<std::mutex> lock(watcher_mutex);
+				watcher = nullptr;
+				watcher = DirectoryWatcher::create(path, [this, callback](const DirectoryChanges& changes) {
+					apply_changes(changes);
+					if (callback != nullptr) {
+						callback(changes);
+					}
+				});
+				return watcher != nullptr;
+			}
+
+			/// Stops watching the directory.
+			void unwatch() {
+				std::lock_guard<std::mutex> lock(watcher_mutex);
+				watcher = nullptr;
+			}
+
+			/**
+			 * @brief Enumerates every regular file below the directory.
+			 * @param[in] callback  Function called once per identity.
+			 * @return true, unless case folding is on (see `set_case_folding`).
+			 *
+			 * Identities are relative, generic (forward slashed) paths; this
+			 * is the form `get_file` expects, in sorted order (see `scan`).
+			 * Symlinked directories are followed, as `get_file` would follow
+			 * them.
+			 */
+			bool enumerate(const EnumerationFunction& callback) {
+				if (is_case_folding()) {
+					return false;
+				}
+				for_each_file(callback);
+				return true;
+			}
+
+			/**
+			 * @brief Enumerates the files whose identities start with `prefix`.
+			 * @param[in] prefix    Prefix (e.g. "shaders/").
+			 * @param[in] callback  Function called once per identity (sorted).
+			 * @return true, unless case folding is on.
+			 *
+			 * Answered from the identity tree (see `invalidate_query_index`).
+			 */
+			bool enumerate_prefix(StringIdentity prefix, const EnumerationFunction& callback) {
+				auto tree = query_tree();
+				if (tree == nullptr) {
+					return false;
+				}
+				tree->find_prefix(prefix, callback);
+				return true;
+			}
+
+			/**
+			 * @brief Enumerates the files whose identities match a glob pattern.
+			 * @param[in] pattern   Pattern (see `GlobPattern`).
+			 * @param[in] callback  Function called once per identity (sorted).
+			 * @return true, unless case folding is on.
+			 */
+			bool enumerate_glob(StringIdentity pattern, const EnumerationFunction& callback) {
+				auto tree = query_tree();
+				if (tree == nullptr) {
+					return false;
+				}
+				tree->find_glob(GlobPattern(pattern), callback);
+				return true;
+			}
+
 			/**
 			 * @brief Gets a file from the underlying filesystem.
 			 * @param[in] identity  Hashed identity of the file.
 			 * @param[in] access    Access type (defaulting to `Read` state).
 			 * @return Pointer to a file, or nullptr if look-up fails.
 			 *
-			 * This will always fail due to the nature of the hashed identity.
+			 * This always fails unless a hash function has been set (or
+			 * offered by a `StorageServer`); see `set_hash_function`.
 			 */
 			FilePointer get_file(HashedIdentity identity,
 				storage::FileAccess access = storage::FileAccess::Read) {
-				return nullptr;
+				std::string relative;
+				if (!find_hashed(identity, relative)) {
+					return nullptr;
+				}
+				return open_child<FileType>(relative, access);
 			}
 
 			/**
@@ -153,10 +900,31 @@ namespace reversingspace {
 			 * @param[in] identity  Hashed identity of the file.
 			 * @param[in] access    Access type (defaulting to `Read` state).
 			 * @return Pointer to a file, or nullptr if look-up fails.
+			 *
+			 * Read-only opens are made relative to the root (see
+			 * `DirectoryHandle`) where supported.  Case is ignored while
+			 * folding (see `set_case_folding`).
 			 */
 			FilePointer get_file(StringIdentity identity,
 				storage::FileAccess access = storage::FileAccess::Read) {
-				return FileType::create(path / identity, access);
+				return open_named<FileType>(identity, access);
+			}
+
+			/**
+			 * @brief Checks whether a file is known to be absent.
+			 * @param[in] identity  Relative path of the file.
+			 * @return true only if nothing exists at its path (a `stat` miss).
+			 *
+			 * Errors other than a missing entry (such as no permission)
+			 * confirm nothing.  Case is ignored while folding.
+			 */
+			bool lacks(StringIdentity identity) {
+				std::string relative;
+				find_folded(identity, relative);
+				std::error_code error;
+				auto status = std::filesystem::status(
+					child_path(relative.empty() ? identity : StringIdentity(relative)), error);
+				return status.type() == std::filesystem::file_type::not_found;
 			}
 
 			/**
@@ -169,7 +937,19 @@ namespace reversingspace {
 			template<class OtherFileType>
 			FilePointer get_file_typed(StringIdentity identity,
 				storage::FileAccess access = storage::FileAccess::Read) {
-				return OtherFileType::create(path / identity, access);
+				return open_named<OtherFileType>(identity, access);
+			}
+
+			/**
+			 * @brief Drops cached subdirectory descriptors.
+			 *
+			 * Only needed if subdirectories were moved within the tree while
+			 * the directory was not being watched (a watcher does this).
+			 */
+			void forget_subdirectories() {
+				if (auto root = root_handle()) {
+					root->forget();
+				}
 			}
 		};
 	}
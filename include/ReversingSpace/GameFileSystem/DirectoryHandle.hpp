@@ -0,0 +1,151 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYHANDLE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYHANDLE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+#include <ReversingSpace/Storage/File.hpp>
+
+// std::atomic
+#include <atomic>
+
+// std::shared_mutex
+#include <shared_mutex>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `DirectoryHandle`.
+		class DirectoryHandle;
+
+		/// Shared pointer type for `DirectoryHandle`.
+		using DirectoryHandlePointer = std::shared_ptr<DirectoryHandle>;
+
+		/**
+		 * @brief Open handle on a directory, for opening files relative to it.
+		 *
+		 * Opening `root/a/b/file` by path makes the kernel walk every
+		 * component on every open.  This holds a descriptor on the root
+		 * (`O_PATH` on Linux) and caches descriptors for recently used
+		 * subdirectories, so an open only resolves the file's own name
+		 * (`openat`).  The root is held open, so renaming it does not
+		 * break look-ups.
+		 *
+		 * A cached subdirectory keeps pointing at the directory it was
+		 * opened on: one which is deleted is noticed and reopened, but one
+		 * which is moved within the tree is only noticed after `forget`.
+		 *
+		 * This is implemented on POSIX platforms; elsewhere `create` returns
+		 * nullptr.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API DirectoryHandle {
+		private:
+			/// Open directory descriptor (closed when the last user lets go).
+			struct Descriptor {
+				/// Descriptor.
+				storage::PlatformFileHandle handle;
+
+				/// Value of `clock` when last used (for eviction).
+				std::atomic<std::uint64_t> last_used{ 0 };
+
+				explicit Descriptor(storage::PlatformFileHandle handle): handle(handle) {}
+				~Descriptor();
+			};
+
+			/// Shared pointer type for `Descriptor`.
+			using DescriptorPointer = std::shared_ptr<Descriptor>;
+
+			/// Root descriptor.
+			DescriptorPointer root;
+
+			/// Maximum number of cached subdirectories.
+			size_t capacity;
+
+			/// Use counter (for eviction).
+			std::atomic<std::uint64_t> clock{ 0 };
+
+			/// Guards `subdirectories`.
+			mutable std::shared_mutex mutex;
+
+			/// Relative path -> cached descriptor.
+			IdentityMap<DescriptorPointer> subdirectories;
+
+			/**
+			 * @brief Opens a directory relative to another (platform specific).
+			 * @return Descriptor, or `PLATFORM_INVALID_FILE_HANDLE`.
+			 */
+			static storage::PlatformFileHandle open_directory(storage::PlatformFileHandle parent,
+				const char* name);
+
+			/// Checks whether an open directory has been deleted (platform specific).
+			static bool is_deleted(storage::PlatformFileHandle directory);
+
+			/**
+			 * @brief Gets a subdirectory's descriptor, opening (and caching) it if needed.
+			 * @param[in] relative  Relative path of the subdirectory.
+			 * @param[out] cached   Whether the descriptor came from the cache.
+			 * @return Descriptor, or nullptr if the subdirectory cannot be opened.
+			 */
+			DescriptorPointer subdirectory(StringIdentity relative, bool& cached);
+
+			/// Drops one cached subdirectory.
+			void forget(StringIdentity relative);
+
+		public:
+			/// Default number of cached subdirectories.
+			static const size_t DEFAULT_CAPACITY = 64;
+
+			/// Use `create`.
+			DirectoryHandle() {}
+
+			DirectoryHandle(const DirectoryHandle&) = delete;
+			DirectoryHandle& operator=(const DirectoryHandle&) = delete;
+
+			/**
+			 * @brief Opens a file below the directory.
+			 * @param[in] identity  Relative, generic path of the file.
+			 * @param[in] path      Full path of the file (kept by the file for `get_path`).
+			 * @param[in] access    Access mode (parent directories are not created).
+			 * @return File, or nullptr on failure.
+			 */
+			storage::FilePointer open(StringIdentity identity, std::filesystem::path path,
+				storage::FileAccess access = storage::FileAccess::Read);
+
+			/// Drops every cached subdirectory (e.g. after directories were moved).
+			void forget();
+
+			/// Number of cached subdirectories.
+			size_t cached_count() const;
+
+			/**
+			 * @brief Opens a handle on a directory.
+			 * @param[in] path      Directory.
+			 * @param[in] capacity  Maximum number of cached subdirectories.
+			 * @return Handle, or nullptr if unsupported or the directory cannot be opened.
+			 */
+			static DirectoryHandlePointer create(const std::filesystem::path& path,
+				size_t capacity = DEFAULT_CAPACITY);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYHANDLE_HPP
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYLISTING_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYLISTING_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+// std::intptr_t
+#include <cstdint>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Type of a directory entry.
+		 *
+		 * Symbolic links report the type of their target (as
+		 * `std::filesystem::is_directory` and `is_regular_file` do).
+		 */
+		enum class EntryType : std::uint8_t {
+			/// The type could not be determined (e.g. a dangling link).
+			Unknown,
+
+			/// Regular file.
+			File,
+
+			/// Directory.
+			Directory,
+
+			/// Anything else (device, socket, pipe).
+			Other,
+		};
+
+		/**
+		 * @brief Entry in a `DirectoryListing`.
+		 */
+		struct DirectoryEntry {
+			/// Name (a view into the listing, valid while it lives).
+			StringIdentity name;
+
+			/// Type (of the target, for links).
+			EntryType type;
+
+			/// Size in bytes (only with metadata).
+			std::uint64_t size;
+
+			/// Modification time, in nanoseconds since the Unix epoch (only with metadata).
+			std::int64_t modified;
+		};
+
+		// Forward for `DirectoryListing`.
+		class DirectoryListing;
+
+		/// Shared pointer type for `DirectoryListing`.
+		using DirectoryListingPointer = std::shared_ptr<const DirectoryListing>;
+
+		/**
+		 * @brief Listing of a directory's children, read in a single pass.
+		 *
+		 * The platform's bulk directory read is used (`getdents64` on Linux,
+		 * `FindFirstFileEx` on Windows, `readdir` elsewhere) and types are
+		 * taken from it where the platform supplies them; a `stat` is only
+		 * issued for links, for entries of unknown type, and when metadata
+		 * is requested (relative to the open directory, so no paths are
+		 * built).  Names are packed into one arena.
+		 *
+		 * `.` and `..` are not listed.  The order is the platform's.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API DirectoryListing {
+		private:
+			/// Name storage.
+			NameArena names;
+
+			/// Entries (names point into `names`).
+			std::vector<DirectoryEntry> entries;
+
+			/// Open handle on a directory (a descriptor, or unused; platform specific).
+			using DirectoryHandle = std::intptr_t;
+
+			/// Value of a `DirectoryHandle` which failed to open.
+			static const DirectoryHandle INVALID_DIRECTORY = -1;
+
+			/**
+			 * @brief Opens a directory for `read` (platform specific).
+			 * @param[in] path  Directory.
+			 * @return Handle, or `INVALID_DIRECTORY`.
+			 */
+			static DirectoryHandle open_directory(const std::filesystem::path& path);
+
+			/**
+			 * @brief Opens a subdirectory relative to its parent (platform specific).
+			 * @param[in] parent  Handle on the parent (still open).
+			 * @param[in] name    Name of the subdirectory within the parent.
+			 * @return Handle, or `INVALID_DIRECTORY`.
+			 */
+			static DirectoryHandle open_child(DirectoryHandle parent, const char* name);
+
+			/// Closes a handle from `open_directory` or `open_child` (platform specific).
+			static void close_directory(DirectoryHandle directory);
+
+			/// Identity of a directory (device and inode, or the platform's equivalent).
+			struct DirectoryId {
+				std::uint64_t device;
+				std::uint64_t inode;
+
+				bool operator==(const DirectoryId& other) const {
+					return device == other.device && inode == other.inode;
+				}
+			};
+
+			/**
+			 * @brief Identifies an open directory (platform specific).
+			 * @param[in] directory  Handle on the directory.
+			 * @param[in] path       Path of the scanned root.
+			 * @param[in] prefix     Relative path of the directory (as for `read`).
+			 * @param[out] id        Identity.
+			 * @return false if the directory could not be identified.
+			 */
+			static bool identify(DirectoryHandle directory, const std::filesystem::path& path,
+				const std::string& prefix, DirectoryId& id);
+
+			/**
+			 * @brief Reads an open directory (platform specific).
+			 * @param[in] directory  Handle on the directory (left open).
+			 * @param[in] path       Path of the scanned root.
+			 * @param[in] prefix     Relative path of the directory ("" for the root, else ending in '/').
+			 * @param[in] metadata   Fill in sizes and modification times.
+			 * @return false if the directory could not be read.
+			 *
+			 * Entries are named `prefix` + name.
+			 */
+			bool read(DirectoryHandle directory, const std::filesystem::path& path,
+				const std::string& prefix, bool metadata);
+
+			/// Adds an entry (copying its name into the arena).
+			void add(StringIdentity prefix, StringIdentity name, EntryType type,
+				std::uint64_t size, std::int64_t modified) {
+				entries.push_back(DirectoryEntry{ names.store(prefix, name), type, size, modified });
+			}
+
+			/// Shared state of a `scan`.
+			struct Scan;
+
+		public:
+			/// Entries, in the order the platform returned them.
+			const std::vector<DirectoryEntry>& get_entries() const {
+				return entries;
+			}
+
+			std::vector<DirectoryEntry>::const_iterator begin() const {
+				return entries.begin();
+			}
+
+			std::vector<DirectoryEntry>::const_iterator end() const {
+				return entries.end();
+			}
+
+			/// Number of entries.
+			size_t size() const {
+				return entries.size();
+			}
+
+			/// Number of entries of a type.
+			size_t count(EntryType type) const {
+				size_t total = 0;
+				for (auto& entry : entries) {
+					total += (entry.type == type) ? 1 : 0;
+				}
+				return total;
+			}
+
+			/**
+			 * @brief Lists a directory.
+			 * @param[in] path      Directory to list.
+			 * @param[in] metadata  Fill in sizes and modification times (costs a `stat` per entry, except on Windows).
+			 * @return Listing, or nullptr if the directory cannot be read.
+			 */
+			static DirectoryListingPointer create(const std::filesystem::path& path,
+				bool metadata = false);
+
+			/**
+			 * @brief Lists a directory tree.
+			 * @param[in] path      Directory to list.
+			 * @param[in] metadata  Fill in sizes and modification times.
+			 * @param[in] pool      Pool to fan subdirectories out to (nullptr to scan on this thread).
+			 * @return Listing, or nullptr if `path` cannot be read.
+			 *
+			 * Entries (files and directories) are named by their relative,
+			 * generic paths and sorted by name, so the result does not depend
+			 * on the number of threads.  Each subdirectory is opened relative
+			 * to its parent's handle where the platform allows it (so no
+			 * paths are built or walked again), and unreadable ones are
+			 * skipped.  Symlinked directories are followed, except into one
+			 * of their own ancestors (a loop is listed once, not entered).
+			 *
+			 * The calling thread scans too, so this may be called from a task
+			 * running on `pool`.
+			 */
+			static DirectoryListingPointer scan(const std::filesystem::path& path,
+				bool metadata = false, WorkerPoolPointer pool = nullptr);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYLISTING_HPP
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYWATCHER_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYWATCHER_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// std::chrono::milliseconds
+#include <chrono>
+
+// std::thread
+#include <thread>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief A change to one identity below a watched directory.
+		 */
+		struct DirectoryChange {
+			/// Kind of change.
+			enum class Kind {
+				/// The identity appeared (created, or moved in).
+				Added,
+
+				/// The identity vanished (deleted, or moved out).
+				Removed,
+
+				/// The identity's content changed.
+				Modified,
+
+				/// Events were lost (or a directory vanished); anything
+				/// derived from the directory must be rebuilt.  `identity`
+				/// is empty.
+				Rescan,
+			};
+
+			/// Kind of change.
+			Kind kind;
+
+			/// Relative, generic identity (as `Directory::enumerate` gives it).
+			std::string identity;
+		};
+
+		/// Batch of (coalesced) changes.
+		using DirectoryChanges = std::vector<DirectoryChange>;
+
+		/// Function receiving batches of changes (on the watcher's thread).
+		using DirectoryChangeFunction = std::function<void(const DirectoryChanges& changes)>;
+
+		// Forward for `DirectoryWatcher`.
+		class DirectoryWatcher;
+
+		/// Pointer type for `DirectoryWatcher`.
+		using DirectoryWatcherPointer = std::unique_ptr<DirectoryWatcher>;
+
+		/**
+		 * @brief Watches a directory tree for changes.
+		 *
+		 * Events are read on a background thread and coalesced: the first
+		 * event opens a batch, and the batch is delivered once `latency`
+		 * has passed, with repeated events on one identity merged (so a
+		 * file written in many chunks is reported once).
+		 *
+		 * This is implemented with `inotify` on Linux; elsewhere `create`
+		 * returns nullptr.  Subdirectories created later are watched as
+		 * they appear.  Symlinked directories are not watched (changes
+		 * inside them are not reported).
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API DirectoryWatcher {
+		private:
+			/// Platform state (inotify descriptors, watch table).
+			struct Platform;
+
+			/// Watched root.
+			std::filesystem::path root;
+
+			/// Receives batches.
+			DirectoryChangeFunction callback;
+
+			/// Coalescing window.
+			std::chrono::milliseconds latency;
+
+			/// Platform state.
+			std::unique_ptr<Platform> platform;
+
+			/// Background thread.
+			std::thread thread;
+
+			/// Background thread body.
+			void run();
+
+		public:
+			/// Default coalescing window.
+			static constexpr std::chrono::milliseconds DEFAULT_LATENCY{ 50 };
+
+			/// Use `create`.
+			DirectoryWatcher();
+
+			/// Stops watching (joining the background thread).
+			~DirectoryWatcher();
+
+			DirectoryWatcher(const DirectoryWatcher&) = delete;
+			DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+			/// Gets the watched root.
+			std::filesystem::path get_path() const {
+				return root;
+			}
+
+			/**
+			 * @brief Starts watching a directory tree.
+			 * @param[in] root      Directory to watch (recursively).
+			 * @param[in] callback  Receives each batch, on the watcher's thread.
+			 * @param[in] latency   Coalescing window.
+			 * @return Watcher, or nullptr if watching is unsupported or fails.
+			 *
+			 * Destroying the watcher stops it; no batch is delivered after
+			 * the destructor returns.
+			 */
+			static DirectoryWatcherPointer create(const std::filesystem::path& root,
+				DirectoryChangeFunction callback,
+				std::chrono::milliseconds latency = DEFAULT_LATENCY);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_DIRECTORYWATCHER_HPP
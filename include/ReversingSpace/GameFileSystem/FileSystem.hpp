@@ -14,6 +14,9 @@
 #define REVERSINGSPACE_GAMEFILESYSTEM_FILESYSTEM_HPP
 
 #include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/DirectoryWatcher.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityFilter.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityTree.hpp>
 #include <ReversingSpace/Storage/Core.hpp>
 
 namespace reversingspace {
@@ -58,6 +61,154 @@ namespace reversingspace {
 			 */
 			virtual FilePointer get_file(StringIdentity identity,
 				storage::FileAccess access = storage::FileAccess::Read) = 0;
+
+		public: // Optional.
+
+			/**
+			 * @brief Enumerates every string identity in the filesystem.
+			 * @param[in] callback  Function called once per identity.
+			 * @return true if the filesystem supports enumeration.
+			 *
+			 * Identities passed to `callback` must resolve through
+			 * `get_file(StringIdentity)`.  The default implementation does
+			 * not enumerate, so indexes built above it must fall back to
+			 * probing the filesystem directly.
+			 */
+			virtual bool enumerate(const EnumerationFunction& /*callback*/) {
+				return false;
+			}
+
+			/**
+			 * @brief Enumerates the string identities starting with a prefix.
+			 * @param[in] prefix    Prefix (e.g. "shaders/"; empty matches everything).
+			 * @param[in] callback  Function called once per matching identity.
+			 * @return true if the filesystem supports enumeration.
+			 *
+			 * The default filters a full `enumerate`; filesystems keeping an
+			 * `IdentityTree` answer from it instead, in sorted order and in
+			 * time proportional to the number of results.
+			 */
+			virtual bool enumerate_prefix(StringIdentity prefix, const EnumerationFunction& callback) {
+				return enumerate([prefix, &callback](StringIdentity name) {
+					if (name.substr(0, prefix.size()) == prefix) {
+						callback(name);
+					}
+				});
+			}
+
+			/**
+			 * @brief Enumerates the string identities matching a glob pattern.
+			 * @param[in] pattern   Pattern (see `GlobPattern`), e.g. "**.lua".
+			 * @param[in] callback  Function called once per matching identity.
+			 * @return true if the filesystem supports enumeration.
+			 *
+			 * The default filters a full `enumerate` (see `enumerate_prefix`).
+			 */
+			virtual bool enumerate_glob(StringIdentity pattern, const EnumerationFunction& callback) {
+				GlobPattern glob(pattern);
+				return enumerate([&glob, &callback](StringIdentity name) {
+					if (glob.matches(name)) {
+						callback(name);
+					}
+				});
+			}
+
+			/**
+			 * @brief Checks whether a file is known to be absent.
+			 * @param[in] identity  Identity of the file.
+			 * @return true only if the filesystem confirms there is no such file.
+			 *
+			 * `StorageServer` asks before dropping an index entry whose
+			 * file could not be opened: a file which is there but cannot be
+			 * opened right now (out of descriptors, no permission, locked)
+			 * must keep its entry.  The default cannot confirm anything.
+			 */
+			virtual bool lacks(StringIdentity /*identity*/) {
+				return false;
+			}
+
+			/**
+			 * @brief Offers a hash function to the filesystem.
+			 * @param[in] function  Hash function used by the owner.
+			 *
+			 * This is called by `StorageServer` when mounting, so filesystems
+			 * without native hashed identities (such as `Directory`) can still
+			 * answer `get_file(HashedIdentity)`.  The default ignores it.
+			 */
+			virtual void offer_hash_function(const HashFunction& /*function*/) {}
+
+			/**
+			 * @brief Whether hashed look-ups can find files string look-ups cannot.
+			 * @return false if every hashed identity is the hash of a string one.
+			 *
+			 * `StorageServer` retries a string look-up which missed as a
+			 * hashed one, but only on mounts which return true here: for
+			 * the others the retry could only find the name which already
+			 * missed (or a name colliding with it).  The default assumes
+			 * there may be hashed-only entries.
+			 */
+			virtual bool resolves_unlisted_hashes() {
+				return true;
+			}
+
+			/**
+			 * @brief Builds a filter over the filesystem's identities.
+			 * @return Filter, or nullptr if one cannot be built.
+			 *
+			 * Used by `StorageServer` (once mount filters are enabled) to skip
+			 * mounts which cannot hold a file.  The default enumerates string
+			 * identities only; filesystems resolving hashed identities should
+			 * cover those too (see `IdentityFilter::build`).
+			 */
+			virtual IdentityFilterPointer build_identity_filter() {
+				return IdentityFilter::build(*this);
+			}
+
+			/**
+			 * @brief Describes the filesystem's current contents, for persisted indexes.
+			 * @param[out] stamp  Opaque bytes which change whenever the identities do.
+			 * @return false if the filesystem cannot describe its contents.
+			 *
+			 * `StorageServer::save_index` stores each mount's stamp, and
+			 * `load_index` only trusts the saved identities of mounts whose
+			 * stamp still checks out.  The default cannot stamp, so such
+			 * mounts are probed in place after loading.
+			 */
+			virtual bool get_stamp(std::string& /*stamp*/) {
+				return false;
+			}
+
+			/**
+			 * @brief Checks a stamp from `get_stamp` against the current contents.
+			 * @param[in] stamp  Stamp saved earlier.
+			 * @return true if the identities are unchanged.
+			 *
+			 * This runs at start-up, so it should be cheaper than `enumerate`;
+			 * the default stamps again and compares.
+			 */
+			virtual bool check_stamp(StringIdentity stamp) {
+				std::string current;
+				return get_stamp(current) && current == stamp;
+			}
+
+			/**
+			 * @brief Starts reporting changes to the filesystem's identities.
+			 * @param[in] callback  Receives batches of changes (on another thread).
+			 * @return true if changes will be reported.
+			 *
+			 * A filesystem reports to one callback at a time; watching again
+			 * replaces the previous callback.  The default cannot watch.
+			 */
+			virtual bool watch(const DirectoryChangeFunction& /*callback*/) {
+				return false;
+			}
+
+			/**
+			 * @brief Stops reporting changes.
+			 *
+			 * No batch is delivered after this returns.
+			 */
+			virtual void unwatch() {}
 		};
 	}
 }
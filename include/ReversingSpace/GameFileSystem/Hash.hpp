@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+/**
+ * @file Hash.hpp
+ * @brief Default (built-in) identity hashing.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_HASH_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_HASH_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// size_t
+#include <cstddef>
+
+// std::string_view (batch hashing)
+#include <string_view>
+
+// std::vector
+#include <vector>
+
+namespace reversingspace {
+	namespace gfs {
+		/// FNV-1a (64-bit) offset basis.
+		const HashedIdentity FNV1A_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+
+		/// FNV-1a (64-bit) prime.
+		const HashedIdentity FNV1A_PRIME = 0x100000001b3ULL;
+
+		/**
+		 * @brief Continues a 64-bit FNV-1a hash over more bytes.
+		 * @param[in] hash    Hash of the preceding bytes (or the offset basis).
+		 * @param[in] data    Bytes to be hashed.
+		 * @param[in] length  Number of bytes.
+		 * @return Hash of the preceding bytes followed by `data`.
+		 *
+		 * This allows a name to be hashed in pieces (e.g. a directory and
+		 * then a file name) without joining the pieces first.
+		 */
+		constexpr HashedIdentity fnv1a_extend(HashedIdentity hash,
+			const char* data, size_t length) {
+			for (size_t i = 0; i < length; ++i) {
+				hash ^= (HashedIdentity)(std::uint8_t)data[i];
+				hash *= FNV1A_PRIME;
+			}
+			return hash;
+		}
+
+		/**
+		 * @brief Hashes a name with 64-bit FNV-1a.
+		 * @param[in] data    Name (not necessarily null terminated).
+		 * @param[in] length  Length of the name, in bytes.
+		 * @return Hashed identity.
+		 *
+		 * This is `constexpr`, so names known at compile time never need to
+		 * be hashed at runtime.  The bytes are hashed as given (no case or
+		 * separator normalisation happens here).
+		 */
+		constexpr HashedIdentity fnv1a(const char* data, size_t length) {
+			return fnv1a_extend(FNV1A_OFFSET_BASIS, data, length);
+		}
+
+		/**
+		 * @brief Default (runtime) hash for identities.
+		 * @param[in] name  Identity to be hashed.
+		 * @return Hashed identity; identical to `fnv1a` of the same bytes.
+		 */
+		REVSPACE_GAMEFILESYSTEM_API HashedIdentity default_hash(StringIdentity name);
+
+		/**
+		 * @brief Gets the default hash as a `HashFunction`.
+		 *
+		 * This is the function to hand to `StorageServer` (or a `Directory`)
+		 * if there is no existing hashing scheme to be compatible with.
+		 */
+		REVSPACE_GAMEFILESYSTEM_API HashFunction default_hash_function();
+
+		/**
+		 * @brief Hashes many names in one call (default hash).
+		 * @param[in] names   Names to be hashed.
+		 * @param[in] count   Number of names.
+		 * @param[out] hashes Output (`count` entries); `hashes[i]` is `default_hash(names[i])`.
+		 *
+		 * This is intended for building indexes over large mounts.  FNV-1a
+		 * is a serial multiply chain per name, so hashing one name at a
+		 * time is bound by multiply latency; this interleaves several
+		 * names so the chains overlap.  Output is identical to hashing
+		 * each name with `default_hash`.
+		 */
+		REVSPACE_GAMEFILESYSTEM_API void default_hash_batch(const std::string_view* names,
+			size_t count, HashedIdentity* hashes);
+
+		/**
+		 * @brief Hashes many names in one call (default hash).
+		 * @param[in] names   Names to be hashed.
+		 * @return Hashes, in the same order as `names`.
+		 */
+		inline std::vector<HashedIdentity> default_hash_batch(
+			const std::vector<std::string_view>& names) {
+			std::vector<HashedIdentity> hashes(names.size());
+			default_hash_batch(names.data(), names.size(), hashes.data());
+			return hashes;
+		}
+
+		namespace literals {
+			/**
+			 * @brief Compile-time identity hashing.
+			 *
+			 * `"textures/ui.dds"_gfs` is the `HashedIdentity` that the default
+			 * hash produces for `textures/ui.dds`.
+			 */
+			constexpr HashedIdentity operator"" _gfs(const char* data, size_t length) {
+				return fnv1a(data, length);
+			}
+		}
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_HASH_HPP
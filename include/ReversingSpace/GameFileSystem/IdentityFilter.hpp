@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYFILTER_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYFILTER_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `IdentityFilter`.
+		class IdentityFilter;
+
+		/// Shared pointer type for `IdentityFilter`.
+		using IdentityFilterPointer = std::shared_ptr<const IdentityFilter>;
+
+		/**
+		 * @brief Bloom filter over the identities of a filesystem.
+		 *
+		 * Answers "definitely absent" or "maybe present" for string and
+		 * hashed identities, so a `StorageServer` can skip mounts which
+		 * cannot hold a file without calling `get_file` on them.  It is
+		 * sized at 10 bits per key inserted (under 1% false positives).
+		 * Each file is one key, or two when hashed identities are covered
+		 * (its string and hashed identities), so a filter built with a
+		 * hash function takes 20 bits per file: 250000 bytes for 100000.
+		 *
+		 * A filter is a snapshot: files added after it was built are
+		 * reported absent, so it must be rebuilt when content changes.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API IdentityFilter {
+		private:
+			/// Bit array.
+			std::vector<std::uint64_t> bits;
+
+			/// Number of bits in use (a multiple of 64).
+			std::uint64_t bit_count;
+
+			/// Whether hashed identities were inserted.
+			bool hashed;
+
+			/// Sets (or tests) the bits for a key.
+			void insert_key(std::uint64_t key);
+			bool test_key(std::uint64_t key) const;
+
+		public:
+			/// Bits per expected key (string and hashed identities count separately).
+			static const size_t BITS_PER_ENTRY = 10;
+
+			/// Bits set per entry (optimal for 10 bits per entry).
+			static const unsigned PROBES = 7;
+
+			/**
+			 * @brief Constructs an empty filter.
+			 * @param[in] expected_entries  Number of keys to be inserted (string and hashed).
+			 * @param[in] covers_hashed     Whether hashed identities will be inserted.
+			 *
+			 * Without `covers_hashed`, hashed look-ups always report "maybe".
+			 */
+			IdentityFilter(size_t expected_entries, bool covers_hashed);
+
+			/// Inserts a string identity.
+			void insert(StringIdentity identity);
+
+			/// Inserts a hashed identity.
+			void insert(HashedIdentity identity);
+
+			/// Returns false if `identity` is definitely absent.
+			bool may_contain(StringIdentity identity) const;
+
+			/// Returns false if `identity` is definitely absent.
+			bool may_contain(HashedIdentity identity) const;
+
+			/// Returns true if hashed identities are covered.
+			bool covers_hashed() const {
+				return hashed;
+			}
+
+			/// Size of the bit array, in bytes.
+			size_t memory_size() const {
+				return bits.size() * sizeof(std::uint64_t);
+			}
+
+			/**
+			 * @brief Builds a filter by enumerating a filesystem.
+			 * @param[in] filesystem  Filesystem to be enumerated.
+			 * @param[in] function    Hash function for hashed identities (may be nullptr).
+			 * @return Filter, or nullptr if the filesystem cannot enumerate.
+			 *
+			 * Sized by the keys inserted: one per identity, two with
+			 * `function` (see `BITS_PER_ENTRY`).
+			 *
+			 * `function` must be the one the filesystem itself uses to
+			 * resolve hashed identities, or hashed look-ups would be wrongly
+			 * reported absent.
+			 */
+			static IdentityFilterPointer build(FileSystem& filesystem,
+				const HashFunction& function = nullptr);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYFILTER_HPP
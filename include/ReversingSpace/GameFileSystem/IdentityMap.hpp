@@ -0,0 +1,309 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYMAP_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYMAP_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// memcpy
+#include <cstring>
+#include <iterator>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Owned storage for identity strings.
+		 *
+		 * Names are copied into large chunks, so storing many names does
+		 * not cost an allocation per name, and views into the arena stay
+		 * valid until `clear` is called.
+		 */
+		class NameArena {
+		private:
+			/// Default chunk size (bytes).
+			static const size_t CHUNK_SIZE = 64 * 1024;
+
+			/// Allocated chunks.
+			std::vector<std::unique_ptr<char[]>> chunks;
+
+			/// Bytes used in the last chunk.
+			size_t used = CHUNK_SIZE;
+
+			/// Total bytes stored.
+			size_t stored = 0;
+
+			/**
+			 * @brief Reserves room for a name.
+			 * @param[in] length  Length of the name (non-zero).
+			 * @return Storage for `length` bytes.
+			 */
+			char* allocate(size_t length) {
+				stored += length;
+				if (length > CHUNK_SIZE) {
+					// Oversized: give it a chunk of its own (keeping the
+					// current chunk as the one being filled).
+					std::unique_ptr<char[]> chunk(new char[length]);
+					char* data = chunk.get();
+					chunks.insert(chunks.end() - (chunks.empty() ? 0 : 1), std::move(chunk));
+					return data;
+				}
+				if (used + length > CHUNK_SIZE) {
+					chunks.emplace_back(new char[CHUNK_SIZE]);
+					used = 0;
+				}
+				char* data = chunks.back().get() + used;
+				used += length;
+				return data;
+			}
+
+		public:
+			NameArena() {}
+
+			// Views must not outlive the arena they point into, so copying
+			// is left to the owners (see `IdentityMap`).
+			NameArena(const NameArena&) = delete;
+			NameArena& operator=(const NameArena&) = delete;
+			NameArena(NameArena&& other) {
+				*this = std::move(other);
+			}
+
+			NameArena& operator=(NameArena&& other) {
+				chunks = std::move(other.chunks);
+				used = other.used;
+				stored = other.stored;
+				other.clear();
+				return *this;
+			}
+
+			/**
+			 * @brief Copies a name into the arena.
+			 * @param[in] name  Name to be stored.
+			 * @return View of the stored copy.
+			 */
+			StringIdentity store(StringIdentity name) {
+				if (name.empty()) {
+					return StringIdentity();
+				}
+				char* data = allocate(name.size());
+				memcpy(data, name.data(), name.size());
+				return StringIdentity(data, name.size());
+			}
+
+			/**
+			 * @brief Stores the concatenation of two pieces (e.g. a directory prefix and a name).
+			 * @param[in] prefix  First piece.
+			 * @param[in] name    Second piece.
+			 * @return View of the stored name.
+			 */
+			StringIdentity store(StringIdentity prefix, StringIdentity name) {
+				size_t length = prefix.size() + name.size();
+				if (length == 0) {
+					return StringIdentity();
+				}
+				char* data = allocate(length);
+				if (!prefix.empty()) {
+					memcpy(data, prefix.data(), prefix.size());
+				}
+				if (!name.empty()) {
+					memcpy(data + prefix.size(), name.data(), name.size());
+				}
+				return StringIdentity(data, length);
+			}
+
+			/**
+			 * @brief Takes over another arena's names.
+			 * @param[in] other  Arena to be emptied; views into it stay valid (now owned here).
+			 */
+			void adopt(NameArena&& other) {
+				if (other.chunks.empty()) {
+					return;
+				}
+				// Keep the current chunk last, as the one being filled.
+				auto at = chunks.end() - (chunks.empty() ? 0 : 1);
+				chunks.insert(at, std::make_move_iterator(other.chunks.begin()),
+					std::make_move_iterator(other.chunks.end()));
+				stored += other.stored;
+				other.clear();
+			}
+
+			/// Total bytes stored (including orphaned names).
+			size_t size() const {
+				return stored;
+			}
+
+			/// Releases every stored name (invalidating all views).
+			void clear() {
+				chunks.clear();
+				used = CHUNK_SIZE;
+				stored = 0;
+			}
+		};
+
+		/**
+		 * @brief Hash map keyed by string identity.
+		 *
+		 * C++17 has no heterogeneous look-up for unordered containers, so
+		 * a map keyed by `std::string` forces callers holding a view to
+		 * allocate a string per look-up.  This keys the map by views into
+		 * a `NameArena` instead: look-ups never allocate, and inserting a
+		 * new key costs a copy into the arena.
+		 *
+		 * Erased keys are left in the arena; it is compacted once they
+		 * outweigh the live keys.
+		 */
+		template<typename Value>
+		class IdentityMap {
+		private:
+			/// Key storage.
+			NameArena arena;
+
+			/// Bytes of key storage in use by live keys.
+			size_t live_bytes = 0;
+
+			/// Views (into `arena`) -> values.
+			std::unordered_map<StringIdentity, Value> entries;
+
+			/// Rebuilds the arena from the live keys.
+			void compact() {
+				NameArena fresh;
+				std::unordered_map<StringIdentity, Value> moved;
+				moved.reserve(entries.size());
+				for (auto& entry : entries) {
+					moved.emplace(fresh.store(entry.first), std::move(entry.second));
+				}
+				entries.swap(moved);
+				arena = std::move(fresh);
+			}
+
+		public:
+			IdentityMap() {}
+
+			/// Copies the entries (keys are re-stored in this map's arena).
+			IdentityMap(const IdentityMap& other) : live_bytes(other.live_bytes) {
+				entries.reserve(other.entries.size());
+				for (auto& entry : other.entries) {
+					entries.emplace(arena.store(entry.first), entry.second);
+				}
+			}
+
+			IdentityMap& operator=(const IdentityMap& other) {
+				if (this != &other) {
+					IdentityMap copy(other);
+					*this = std::move(copy);
+				}
+				return *this;
+			}
+
+			// Moving keeps the views valid (the arena's chunks do not move).
+			IdentityMap(IdentityMap&&) = default;
+			IdentityMap& operator=(IdentityMap&&) = default;
+
+			using iterator = typename std::unordered_map<StringIdentity, Value>::iterator;
+			using const_iterator = typename std::unordered_map<StringIdentity, Value>::const_iterator;
+
+			iterator begin() { return entries.begin(); }
+			iterator end() { return entries.end(); }
+			const_iterator begin() const { return entries.begin(); }
+			const_iterator end() const { return entries.end(); }
+
+			/// Number of entries.
+			size_t size() const {
+				return entries.size();
+			}
+
+			/// Returns true if there are no entries.
+			bool empty() const {
+				return entries.empty();
+			}
+
+			/// Reserves space for a number of entries.
+			void reserve(size_t count) {
+				entries.reserve(count);
+			}
+
+			/// Finds an entry (no allocation).
+			iterator find(StringIdentity identity) {
+				return entries.find(identity);
+			}
+
+			/// Finds an entry (no allocation).
+			const_iterator find(StringIdentity identity) const {
+				return entries.find(identity);
+			}
+
+			/// Returns 1 if `identity` is present, otherwise 0.
+			size_t count(StringIdentity identity) const {
+				return entries.count(identity);
+			}
+
+			/**
+			 * @brief Gets the value for an identity, inserting it if missing.
+			 * @param[in] identity  Identity (copied into the map if new).
+			 * @return Reference to the value.
+			 */
+			Value& operator[](StringIdentity identity) {
+				auto entry = entries.find(identity);
+				if (entry != entries.end()) {
+					return entry->second;
+				}
+				live_bytes += identity.size();
+				return entries[arena.store(identity)];
+			}
+
+			/**
+			 * @brief Erases an identity.
+			 * @return Number of entries erased (0 or 1).
+			 */
+			size_t erase(StringIdentity identity) {
+				auto entry = entries.find(identity);
+				if (entry == entries.end()) {
+					return 0;
+				}
+				erase(entry);
+				return 1;
+			}
+
+			/**
+			 * @brief Erases an entry by iterator.
+			 * @return Iterator following the erased entry.
+			 */
+			iterator erase(iterator entry) {
+				live_bytes -= entry->first.size();
+				auto next = entries.erase(entry);
+				// Compaction would invalidate `next`, so leave it to `clear`
+				// or a later (non-iterating) erase.
+				return next;
+			}
+
+			/// Compacts key storage if erased keys dominate it.
+			void shrink() {
+				if (arena.size() > 2 * live_bytes + 4096) {
+					compact();
+				}
+			}
+
+			/// Removes every entry.
+			void clear() {
+				entries.clear();
+				arena.clear();
+				live_bytes = 0;
+			}
+		};
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYMAP_HPP
@@ -0,0 +1,253 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYTREE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYTREE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Glob pattern over identities.
+		 *
+		 * `?` matches one character and `*` any run of characters, neither
+		 * crossing a '/'; `**` matches any run, '/' included.  A `**`
+		 * directly followed by '/' also matches nothing, so "any number of
+		 * directories" includes none.  Every other character matches
+		 * itself.  For example, `*.lua` lists the scripts at the top of
+		 * a tree and `**.lua` lists every script in it.
+		 *
+		 * Matching runs a set of pattern positions over the name one
+		 * character at a time, which lets `IdentityTree` drop whole
+		 * subtrees as soon as no position survives.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API GlobPattern {
+		public:
+			/// Active pattern positions (one flag per position).
+			using State = std::vector<std::uint8_t>;
+
+		private:
+			/// Kinds of pattern element.
+			enum class Token : std::uint8_t {
+				/// One given character.
+				Literal,
+
+				/// `?`
+				One,
+
+				/// `*`
+				Star,
+
+				/// `**` (not followed by '/').
+				DeepStar,
+
+				/// Start of `**` followed by '/', which may be skipped (followed by its `DeepStar` and '/').
+				DeepDirectory,
+			};
+
+			/// Pattern element.
+			struct Element {
+				Token token;
+				char literal;
+			};
+
+			/// Elements, in order.
+			std::vector<Element> elements;
+
+			/// The pattern up to its first wildcard.
+			std::string literal_prefix;
+
+			/// Activates the positions reachable without consuming a character.
+			void close(State& state) const;
+
+		public:
+			/**
+			 * @brief Compiles a pattern.
+			 * @param[in] pattern  Pattern (see the class notes).
+			 */
+			explicit GlobPattern(StringIdentity pattern);
+
+			/// The pattern up to its first wildcard (every match starts with it).
+			const std::string& get_literal_prefix() const {
+				return literal_prefix;
+			}
+
+			/// State before any character is read.
+			State start() const;
+
+			/**
+			 * @brief Reads one character.
+			 * @param[in] from  State before `c`.
+			 * @param[in] c     Character.
+			 * @param[out] to   State after `c`.
+			 * @return false if no position survives (no name continuing this way matches).
+			 */
+			bool advance(const State& from, char c, State& to) const;
+
+			/// Whether a name ending in `state` matches.
+			bool accepts(const State& state) const {
+				return state[elements.size()] != 0;
+			}
+
+			/// Whether `name` matches.
+			bool matches(StringIdentity name) const;
+		};
+
+		// Forward for `IdentityTree`.
+		class IdentityTree;
+
+		/// Shared pointer type for `IdentityTree`.
+		using IdentityTreePointer = std::shared_ptr<const IdentityTree>;
+
+		/**
+		 * @brief Compact radix tree over a set of identities.
+		 *
+		 * Answers prefix and glob queries without touching the filesystem
+		 * the identities came from.  A prefix query walks one path down
+		 * the tree and then lists the subtree below it, so its cost is the
+		 * length of the prefix plus the size of the results; a glob query
+		 * starts below its literal prefix and prunes branches the pattern
+		 * cannot match.  Results come out in sorted order.
+		 *
+		 * Nodes sit in one array (children contiguous, sorted by their
+		 * first byte) and edge labels in one string, so the tree holds no
+		 * per-node allocations.  A tree is immutable once built: like an
+		 * `IdentityFilter` it is a snapshot, and is rebuilt when content
+		 * changes.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API IdentityTree {
+		private:
+			/// Tree node.  The root (node 0) has an empty label.
+			struct Node {
+				/// Offset of the edge label in `labels`.
+				std::uint32_t label_offset;
+
+				/// Length of the edge label.
+				std::uint32_t label_length;
+
+				/// Index of the first child in `nodes`.
+				std::uint32_t first_child;
+
+				/// Number of children.
+				std::uint32_t child_count;
+
+				/// Whether the path to this node is an identity.
+				bool terminal;
+			};
+
+			/// Nodes (the root first).
+			std::vector<Node> nodes;
+
+			/// Edge labels, end to end.
+			std::string labels;
+
+			/// Number of identities.
+			size_t identity_count = 0;
+
+			/// Label of a node.
+			StringIdentity label(const Node& node) const {
+				return StringIdentity(labels.data() + node.label_offset, node.label_length);
+			}
+
+			/**
+			 * @brief Builds the subtree below a node.
+			 * @param[in] names  Sorted, unique identities.
+			 * @param[in] node   Node whose path is `names[first]`'s first `depth` bytes.
+			 * @param[in] first  First identity below `node`.
+			 * @param[in] last   One past the last identity below `node`.
+			 * @param[in] depth  Length of the path to `node`.
+			 */
+			void build_below(const std::vector<StringIdentity>& names, size_t node,
+				size_t first, size_t last, size_t depth);
+
+			/**
+			 * @brief Finds the highest node every identity starting with `prefix` is below.
+			 * @param[in] prefix  Prefix.
+			 * @param[out] node   Node found.
+			 * @param[out] path   Path to `node` (starts with `prefix`, but may be longer).
+			 * @return false if no identity starts with `prefix`.
+			 */
+			bool descend(StringIdentity prefix, size_t& node, std::string& path) const;
+
+			/// Reports every identity at or below `node` (`path` is the path to it).
+			void list(size_t node, std::string& path, const EnumerationFunction& callback) const;
+
+			/// Reports the identities at or below `node` which `pattern` accepts from `state`.
+			void match(size_t node, std::string& path, const GlobPattern::State& state,
+				const GlobPattern& pattern, const EnumerationFunction& callback) const;
+
+		public:
+			/// Use `create` or `build`.
+			IdentityTree() {}
+
+			/// Number of identities.
+			size_t size() const {
+				return identity_count;
+			}
+
+			/// Number of nodes (for sizing).
+			size_t node_count() const {
+				return nodes.size();
+			}
+
+			/// Approximate memory held, in bytes.
+			size_t memory_size() const {
+				return nodes.capacity() * sizeof(Node) + labels.capacity();
+			}
+
+			/**
+			 * @brief Reports every identity starting with `prefix`.
+			 * @param[in] prefix    Prefix (e.g. "shaders/"; empty lists everything).
+			 * @param[in] callback  Called once per identity, in sorted order.
+			 *
+			 * Names passed to `callback` are only valid during the call.
+			 */
+			void find_prefix(StringIdentity prefix, const EnumerationFunction& callback) const;
+
+			/**
+			 * @brief Reports every identity matching a glob pattern.
+			 * @param[in] pattern   Pattern.
+			 * @param[in] callback  Called once per identity, in sorted order.
+			 */
+			void find_glob(const GlobPattern& pattern, const EnumerationFunction& callback) const;
+
+			/**
+			 * @brief Builds a tree.
+			 * @param[in] names  Identities (any order; duplicates are dropped).
+			 * @return Tree.
+			 */
+			static IdentityTreePointer create(std::vector<StringIdentity> names);
+
+			/**
+			 * @brief Builds a tree by enumerating a filesystem.
+			 * @param[in] filesystem  Filesystem to be enumerated.
+			 * @return Tree, or nullptr if the filesystem cannot enumerate.
+			 */
+			static IdentityTreePointer build(FileSystem& filesystem);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_IDENTITYTREE_HPP
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_LAZYMOUNT_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_LAZYMOUNT_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+
+// std::atomic
+#include <atomic>
+
+// std::function
+#include <functional>
+
+// std::once_flag, std::mutex
+#include <mutex>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Function opening the filesystem behind a `LazyMount`.
+		 * @return Filesystem, or nullptr if it cannot be opened.
+		 */
+		using LazyMountOpenFunction = std::function<FileSystemPointer()>;
+
+		/**
+		 * @brief Mount which opens its filesystem on first use.
+		 *
+		 * Only the path and an open function are kept until something
+		 * needs the contents: the first look-up, enumeration or query
+		 * opens the filesystem (exactly once, whichever thread gets there
+		 * first) and every call after that is forwarded to it.  Mounting
+		 * hundreds of archives then costs nothing up front, and only the
+		 * ones a session touches are ever opened.
+		 *
+		 * What opens it depends on how the `StorageServer` resolves:
+		 * probing opens each mount a look-up reaches, and building an index
+		 * or filters opens every mount.  A loaded index (`load_index`) only
+		 * goes to the mounts providing an identity (a miss opens none);
+		 * mounts over a single
+		 * file stamp it by its size and modification time, so validating
+		 * the index opens nothing.
+		 *
+		 * A mount whose filesystem cannot be opened is empty.
+		 */
+		class LazyMount : public FileSystem {
+		private:
+			/// Path of the filesystem (reported before it is opened).
+			std::filesystem::path path;
+
+			/// Opens the filesystem (dropped once used).
+			LazyMountOpenFunction open_function;
+
+			/// Opens `target` (once).
+			std::once_flag open_once;
+
+			/// The opened filesystem (nullptr if it could not be opened).
+			FileSystemPointer target;
+
+			/// Set once `target` is final (and has been offered `hash_function`).
+			std::atomic<bool> opened{ false };
+
+			/// Guards `hash_function` and its hand-over to `target`.
+			std::mutex hash_mutex;
+
+			/// Hash function offered before opening.
+			HashFunction hash_function;
+
+			/// `resolves_unlisted_hashes` until opened.
+			bool unlisted_hashes;
+
+			/// Stamps `path` by size and modification time, if it is a file.
+			bool file_stamp(std::string& stamp) const {
+				std::error_code error;
+				if (!std::filesystem::is_regular_file(path, error)) {
+					return false;
+				}
+				auto size = (std::uint64_t)std::filesystem::file_size(path, error);
+				if (error) {
+					return false;
+				}
+				auto time = (std::int64_t)std::filesystem::last_write_time(path, error).time_since_epoch().count();
+				if (error) {
+					return false;
+				}
+				stamp.assign((const char*)&size, sizeof(size));
+				stamp.append((const char*)&time, sizeof(time));
+				return true;
+			}
+
+		public:
+			/**
+			 * @brief Creates a lazy mount.
+			 * @param[in] path             Path of the filesystem (see `get_path`).
+			 * @param[in] function         Opens the filesystem; called at most once.
+			 * @param[in] unlisted_hashes  Answer to `resolves_unlisted_hashes` until opened.
+			 */
+			LazyMount(const std::filesystem::path& path, LazyMountOpenFunction function,
+				bool unlisted_hashes = false)
+				: path(path), open_function(std::move(function)), unlisted_hashes(unlisted_hashes) {}
+
+			/**
+			 * @brief Opens the filesystem (if that has not happened yet).
+			 * @return Filesystem, or nullptr if it cannot be opened.
+			 *
+			 * Safe to call from any number of threads; the open function
+			 * runs once and the others wait for it.
+			 */
+			FileSystemPointer open() {
+				std::call_once(open_once, [this]() {
+					auto opened_target = open_function ? open_function() : nullptr;
+					open_function = nullptr;
+					std::lock_guard<std::mutex> guard(hash_mutex);
+					if (opened_target != nullptr && hash_function != nullptr) {
+						opened_target->offer_hash_function(hash_function);
+					}
+					target = opened_target;
+					opened = true;
+				});
+				return target;
+			}
+
+			/// Returns true once the filesystem has been opened (or failed to open).
+			bool is_opened() const {
+				return opened;
+			}
+
+			/**
+			 * @brief Creates a lazy mount.
+			 * @param[in] path             Path of the filesystem.
+			 * @param[in] function         Opens the filesystem.
+			 * @param[in] unlisted_hashes  Answer to `resolves_unlisted_hashes` until opened.
+			 * @return Pointer to the mount.
+			 */
+			static LazyMountPointer create(const std::filesystem::path& path,
+				LazyMountOpenFunction function, bool unlisted_hashes = false) {
+				return std::make_shared<LazyMount>(path, std::move(function), unlisted_hashes);
+			}
+
+		public: // FileSystem
+			/// Gets the path (without opening).
+			std::filesystem::path get_path() const {
+				return path;
+			}
+
+			FilePointer get_file(HashedIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read) {
+				auto filesystem = open();
+				return (filesystem == nullptr) ? nullptr : filesystem->get_file(identity, access);
+			}
+
+			FilePointer get_file(StringIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read) {
+				auto filesystem = open();
+				return (filesystem == nullptr) ? nullptr : filesystem->get_file(identity, access);
+			}
+
+			/**
+			 * @brief Asks the filesystem, once opened (without opening it).
+			 *
+			 * `StorageServer` asks every mount after a string look-up
+			 * misses, so opening here would open every archive.  Until
+			 * opened, the answer given at construction is used (by default,
+			 * false: hashed-only entries are found once something opens
+			 * the mount).  One which cannot be opened resolves nothing.
+			 */
+			bool resolves_unlisted_hashes() {
+				if (!opened) {
+					return unlisted_hashes;
+				}
+				return target != nullptr && target->resolves_unlisted_hashes();
+			}
+
+			/// Asks the opened filesystem (nothing is confirmed if it cannot be opened).
+			bool lacks(StringIdentity identity) {
+				auto filesystem = open();
+				return filesystem != nullptr && filesystem->lacks(identity);
+			}
+
+			/// Enumerates the opened filesystem (nothing, if it cannot be opened).
+			bool enumerate(const EnumerationFunction& callback) {
+				auto filesystem = open();
+				return (filesystem == nullptr) || filesystem->enumerate(callback);
+			}
+
+			bool enumerate_prefix(StringIdentity prefix, const EnumerationFunction& callback) {
+				auto filesystem = open();
+				return (filesystem == nullptr) || filesystem->enumerate_prefix(prefix, callback);
+			}
+
+			bool enumerate_glob(StringIdentity pattern, const EnumerationFunction& callback) {
+				auto filesystem = open();
+				return (filesystem == nullptr) || filesystem->enumerate_glob(pattern, callback);
+			}
+
+			/// Kept until opening (passed on straight away once opened).
+			void offer_hash_function(const HashFunction& function) {
+				std::lock_guard<std::mutex> guard(hash_mutex);
+				hash_function = function;
+				if (opened && target != nullptr) {
+					target->offer_hash_function(function);
+				}
+			}
+
+			IdentityFilterPointer build_identity_filter() {
+				auto filesystem = open();
+				return (filesystem == nullptr)
+					? IdentityFilter::build(*this)
+					: filesystem->build_identity_filter();
+			}
+
+			/// A file is stamped without opening it; anything else is opened and asked.
+			bool get_stamp(std::string& stamp) {
+				if (file_stamp(stamp)) {
+					return true;
+				}
+				auto filesystem = open();
+				return filesystem != nullptr && filesystem->get_stamp(stamp);
+			}
+
+			bool check_stamp(StringIdentity stamp) {
+				std::string current;
+				if (file_stamp(current)) {
+					return current == stamp;
+				}
+				auto filesystem = open();
+				return filesystem != nullptr && filesystem->check_stamp(stamp);
+			}
+
+			bool watch(const DirectoryChangeFunction& callback) {
+				auto filesystem = open();
+				return filesystem != nullptr && filesystem->watch(callback);
+			}
+
+			/// Only stops an opened filesystem (an unopened one is not watched).
+			void unwatch() {
+				if (opened && target != nullptr) {
+					target->unwatch();
+				}
+			}
+		};
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_LAZYMOUNT_HPP
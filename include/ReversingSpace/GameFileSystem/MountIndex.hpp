@@ -0,0 +1,257 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEX_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEX_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+#include <ReversingSpace/GameFileSystem/MountIndexFile.hpp>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Merged (overlay) index over a stack of mounts.
+		 *
+		 * Maps each string identity to the mounts which provide it, highest
+		 * priority first, so a look-up does not need to probe every mount.
+		 * The stack is ordered as `StorageServer` orders it: the last mount
+		 * has the highest priority.
+		 *
+		 * Mounts which cannot `enumerate` are recorded as opaque; they are
+		 * still probed (in stack order) so priority semantics are kept.
+		 *
+		 * The index does not watch the disk.  Identities must be given in
+		 * the form the mounts enumerate them (for `Directory` this is the
+		 * generic relative path).
+		 *
+		 * An index can be saved (`save`) and later loaded (`load`) without
+		 * enumerating anything: the loaded file is looked up in place, and
+		 * later changes are kept in memory on top of it.
+		 *
+		 * Copies are cheap: they share the index's storage until changed.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API MountIndex {
+		private:
+			/// One shard of `providers`.
+			using ProviderMap = IdentityMap<std::vector<FileSystemPointer>>;
+
+			/// Number of shards `providers` is split into.
+			static const size_t SHARD_COUNT = 256;
+
+			/**
+			 * @brief Identity -> providing mounts (highest priority first), in shards.
+			 *
+			 * Shards are shared between copies of the index and copied on
+			 * their first change (`writable`), so copying the index costs
+			 * `SHARD_COUNT` pointers and a change copies only the shards it
+			 * touches.  (`StorageServer` copies its index on every mount
+			 * table change.)  Empty until the first identity is added; a
+			 * shard is nullptr until it holds one.
+			 *
+			 * Once a file is loaded, an identity listed here overrides the
+			 * file's entry (even with an empty list).
+			 */
+			std::vector<std::shared_ptr<ProviderMap>> providers;
+
+			/// Mounts which could not be enumerated (or whose saved entries were stale).
+			std::unordered_set<const FileSystem*> opaque;
+
+			/**
+			 * @brief Stamp of each indexed mount, taken before it was enumerated.
+			 *
+			 * Saved with the index, so a change made after enumeration
+			 * (but before `save`) still fails the stamp check on load.
+			 */
+			std::unordered_map<const FileSystem*, std::shared_ptr<const std::string>> stamps;
+
+			/// Loaded index file (nullptr unless `load` was used).
+			MountIndexFilePointer mapped;
+
+			/// Mount at each position of `mapped`'s mount list (nullptr once unusable).
+			std::vector<FileSystemPointer> mapped_mounts;
+
+			/// Shard holding an identity.
+			static size_t shard_of(StringIdentity identity);
+
+			/// Finds an identity's provider list (nullptr if `providers` does not list it).
+			const std::vector<FileSystemPointer>* find_providers(StringIdentity identity) const;
+
+			/// Gets a shard for changing (copied first if another index shares it).
+			ProviderMap& writable(size_t shard);
+
+			/**
+			 * @brief Collects an identity's providers from `mapped`.
+			 * @param[in] identity  Identity.
+			 * @param[out] list     Providers still mounted, highest priority first.
+			 * @return false if the file does not list the identity.
+			 */
+			bool mapped_providers(StringIdentity identity, std::vector<FileSystemPointer>& list) const;
+
+			/**
+			 * @brief Gets an identity's provider list for changing.
+			 * @param[in] identity  Identity.
+			 * @return List (copied from `mapped` on first change).
+			 */
+			std::vector<FileSystemPointer>& modify(StringIdentity identity);
+
+			/// Drops an identity whose provider list is empty (unless it must hide `mapped`'s entry).
+			void drop_if_empty(StringIdentity identity);
+
+			/**
+			 * @brief Enumerates a mount, then merges it into the index.
+			 * @param[in] mountable  Mount to be merged.
+			 * @param[in] ranks      Stack position of each mount.
+			 */
+			void merge(const FileSystemPointer& mountable,
+				const std::unordered_map<const FileSystem*, size_t>& ranks);
+
+			/**
+			 * @brief Records a mount as a provider of one identity.
+			 * @param[in] identity   Identity provided.
+			 * @param[in] mountable  Providing mount.
+			 * @param[in] ranks      Stack position of each mount.
+			 */
+			void place(StringIdentity identity, const FileSystemPointer& mountable,
+				const std::unordered_map<const FileSystem*, size_t>& ranks);
+
+		public:
+			/**
+			 * @brief Builds the index from scratch.
+			 * @param[in] stack  Mount stack (bottom to top).
+			 */
+			void build(const std::vector<FileSystemPointer>& stack);
+
+			/**
+			 * @brief Merges a newly mounted filesystem into the index.
+			 * @param[in] stack      Mount stack, including `mountable`.
+			 * @param[in] mountable  The new mount.
+			 *
+			 * Only `mountable` is enumerated; existing entries are kept.
+			 */
+			void insert(const std::vector<FileSystemPointer>& stack,
+				const FileSystemPointer& mountable);
+
+			/**
+			 * @brief Removes an unmounted filesystem from the index.
+			 * @param[in] mountable  The removed mount.
+			 *
+			 * Identities it provided fall through to the next provider;
+			 * nothing is re-enumerated.
+			 */
+			void erase(const FileSystemPointer& mountable);
+
+			/**
+			 * @brief Records an identity which appeared in a mount.
+			 * @param[in] stack      Mount stack, including `mountable`.
+			 * @param[in] identity   Identity which appeared.
+			 * @param[in] mountable  Mount it appeared in.
+			 *
+			 * Ignored for opaque mounts (they are always probed).
+			 */
+			void add(const std::vector<FileSystemPointer>& stack,
+				StringIdentity identity, const FileSystemPointer& mountable);
+
+			/**
+			 * @brief Records an identity which vanished from a mount.
+			 * @param[in] identity   Identity which vanished.
+			 * @param[in] mountable  Mount it vanished from.
+			 */
+			void remove(StringIdentity identity, const FileSystemPointer& mountable);
+
+			/// Empties the index.
+			void clear();
+
+			/// Number of distinct identities in the index.
+			size_t size() const;
+
+			/**
+			 * @brief Saves the index.
+			 * @param[in] stack  Mount stack the index was built from.
+			 * @param[in] path   File to write.
+			 * @return false if the file could not be written.
+			 *
+			 * Each mount is saved with its path and the stamp taken when it
+			 * was enumerated (see `FileSystem::get_stamp`), not a fresh one,
+			 * so anything changed since is caught on load.  Mounts which
+			 * cannot stamp (or are opaque) are saved without their
+			 * identities, and are probed in place once loaded.
+			 */
+			bool save(const std::vector<FileSystemPointer>& stack,
+				const std::filesystem::path& path) const;
+
+			/**
+			 * @brief Replaces the index with a saved one.
+			 * @param[in] stack  Current mount stack.
+			 * @param[in] file   Saved index.
+			 * @return false (leaving the index unchanged) if the mount list differs.
+			 *
+			 * The mounts must be the saved ones, by path and in order.  A
+			 * mount whose stamp no longer checks out (see
+			 * `FileSystem::check_stamp`) is treated as opaque, so it is
+			 * probed in place and priority is kept; its saved entries are
+			 * ignored.
+			 */
+			bool load(const std::vector<FileSystemPointer>& stack,
+				const MountIndexFilePointer& file);
+
+			/// Number of mounts treated as opaque (not enumerable, or stale when loaded).
+			size_t opaque_count() const {
+				return opaque.size();
+			}
+
+			/**
+			 * @brief Resolves an identity using the index.
+			 * @param[in] stack     Mount stack the index was built from.
+			 * @param[in] identity  Identity to be found.
+			 * @param[out] owner    Mount which resolved the identity.
+			 * @param[out] stale    If given, receives listed providers confirmed to no longer have the file.
+			 * @return Pointer to a file (or nullptr on failure).
+			 *
+			 * Without opaque mounts this only probes the providers of
+			 * `identity` (typically one); otherwise opaque mounts are probed
+			 * in their stack positions too.  A listed provider which fails
+			 * is only reported stale if it confirms the file is gone (see
+			 * `FileSystem::lacks`); stale providers can be dropped with
+			 * `remove`.
+			 */
+			FilePointer resolve(const std::vector<FileSystemPointer>& stack,
+				StringIdentity identity, FileSystemPointer& owner,
+				std::vector<FileSystemPointer>* stale = nullptr) const;
+
+			/**
+			 * @brief Enumerates every indexed identity (once each).
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if an opaque mount makes the listing incomplete.
+			 */
+			bool enumerate(const EnumerationFunction& callback) const;
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEX_HPP
@@ -0,0 +1,177 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEXFILE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEXFILE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/Storage/File.hpp>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `MountIndexFile`.
+		class MountIndexFile;
+
+		/// Shared pointer type for `MountIndexFile`.
+		using MountIndexFilePointer = std::shared_ptr<const MountIndexFile>;
+
+		/**
+		 * @brief Persisted merged index (see `MountIndex::save`), read in place.
+		 *
+		 * The file is mapped and looked up directly: an open-addressing
+		 * table of identities (by FNV-1a), each pointing at its providers'
+		 * positions in the saved mount list, highest priority first.
+		 * Opening checks the header and section bounds only, so it costs
+		 * the same however many identities the file holds; entries are
+		 * bounds-checked as they are read, so a damaged file cannot be
+		 * read out of range.
+		 *
+		 * Each mount is saved with its path and stamp (see
+		 * `FileSystem::get_stamp`), which the loader uses to decide which
+		 * mounts' entries can still be trusted.
+		 *
+		 * The layout is native-endian and versioned (`FORMAT_VERSION`);
+		 * files written by another version or byte order are rejected.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API MountIndexFile {
+		public:
+			/// Layout version (bumped whenever the layout changes).
+			static const std::uint32_t FORMAT_VERSION = 1;
+
+			/// Mount, as written.
+			struct MountRecord {
+				/// Path of the mount (generic form).
+				std::string path;
+
+				/// Stamp of the mount (see `FileSystem::get_stamp`).
+				std::string stamp;
+
+				/// Whether the mount's identities were saved (false: probe it in place).
+				bool indexed;
+			};
+
+			/// Identity, as written.
+			struct Entry {
+				/// Identity.
+				StringIdentity identity;
+
+				/// Positions of its providers in the mount list, highest priority first.
+				std::vector<std::uint32_t> positions;
+			};
+
+			/// Function receiving each saved identity and its provider positions.
+			using EntryFunction = std::function<void(StringIdentity identity,
+				const std::uint32_t* positions, size_t count)>;
+
+		private:
+			/// The mapped file.
+			storage::FilePointer file;
+
+			/// Mapping of the whole file.
+			storage::ViewPointer view;
+
+			/// Start of the mapping.
+			const char* data = nullptr;
+
+			/// Sections (pointers into the mapping).
+			const char* mounts = nullptr;
+			const char* slots = nullptr;
+			const std::uint32_t* providers = nullptr;
+			const char* strings = nullptr;
+
+			/// Section sizes (in records, words and bytes respectively).
+			std::uint32_t mount_total = 0;
+			std::uint32_t slot_total = 0;
+			std::uint64_t provider_total = 0;
+			std::uint64_t string_total = 0;
+
+			/// Number of identities.
+			std::uint64_t identity_total = 0;
+
+			/**
+			 * @brief Reads the provider list of a slot.
+			 * @return false if the slot is empty or its fields are out of range.
+			 */
+			bool read_slot(std::uint32_t slot, StringIdentity& identity,
+				const std::uint32_t*& positions, size_t& count) const;
+
+			/// Reads a string from the string section (empty if out of range).
+			StringIdentity read_string(std::uint64_t offset, std::uint64_t length) const;
+
+		public:
+			/// Use `open`.
+			MountIndexFile() {}
+
+			/// Number of saved mounts.
+			size_t mount_count() const {
+				return mount_total;
+			}
+
+			/// Path of a saved mount (generic form).
+			StringIdentity mount_path(size_t position) const;
+
+			/// Stamp of a saved mount.
+			StringIdentity mount_stamp(size_t position) const;
+
+			/// Whether a saved mount's identities were saved.
+			bool mount_indexed(size_t position) const;
+
+			/// Number of saved identities.
+			size_t size() const {
+				return (size_t)identity_total;
+			}
+
+			/**
+			 * @brief Finds an identity.
+			 * @param[in] identity    Identity to be found.
+			 * @param[out] positions  Its providers' positions (valid while the file lives).
+			 * @param[out] count      Number of providers.
+			 * @return false if the identity was not saved.
+			 */
+			bool find(StringIdentity identity, const std::uint32_t*& positions, size_t& count) const;
+
+			/// Calls `callback` for every saved identity (in table order).
+			void for_each(const EntryFunction& callback) const;
+
+			/**
+			 * @brief Maps an index file.
+			 * @param[in] path  File to be mapped.
+			 * @return File, or nullptr if it is missing, of another version, or malformed.
+			 */
+			static MountIndexFilePointer open(const std::filesystem::path& path);
+
+			/**
+			 * @brief Writes an index file.
+			 * @param[in] path     File to be written (replaced whole, via a temporary file).
+			 * @param[in] mounts   Mount list (bottom to top).
+			 * @param[in] entries  Identities (positions refer to `mounts`).
+			 * @return false if the file could not be written.
+			 */
+			static bool write(const std::filesystem::path& path,
+				const std::vector<MountRecord>& mounts, const std::vector<Entry>& entries);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_MOUNTINDEXFILE_HPP
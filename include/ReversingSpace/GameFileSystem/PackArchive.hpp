@@ -0,0 +1,241 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_PACKARCHIVE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_PACKARCHIVE_HPP
+
+#include <ReversingSpace/GameFileSystem/Archive.hpp>
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+#include <ReversingSpace/Storage/File.hpp>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `PackArchive`.
+		class PackArchive;
+
+		/// Shared pointer type for `PackArchive`.
+		using PackArchivePointer = std::shared_ptr<PackArchive>;
+
+		/**
+		 * @brief Reference archive format (read-only), read in place.
+		 *
+		 * A pack is one file: a header, a table of contents and the
+		 * entries' data, each entry starting on an `alignment` boundary
+		 * (a page, by default).  Files are written by `PackBuilder`.
+		 *
+		 * The whole file is mapped once and the table of contents is
+		 * used where it lies: opening checks the header and section
+		 * bounds only, so it costs the same however many entries the
+		 * pack holds.  Entries are bounds-checked as they are read, so
+		 * a damaged pack cannot be read out of range.
+		 *
+		 * Entries are placed by a minimal perfect hash over their hashed
+		 * identities (FNV-1a of the name, as `default_hash`): the identity
+		 * picks a bucket, the bucket's seed picks the entry, and a look-up
+		 * reads one seed and one entry.  String look-ups hash the name and
+		 * compare it with the stored one.
+		 *
+		 * The layout is native-endian and versioned (`FORMAT_VERSION`);
+		 * files written by another version or byte order are rejected.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API PackArchive : public Archive {
+		public:
+			/// Layout version (bumped whenever the layout changes).
+			static const std::uint32_t FORMAT_VERSION = 2;
+
+			/// Default entry alignment (a page).
+			static const std::uint32_t DEFAULT_ALIGNMENT = 4096;
+
+			/// File signature.
+			static const char MAGIC[8];
+
+			/// Written as-is; read back differently on another byte order.
+			static const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+			/// Entry flag: stored block-compressed (see `CompressedEntryFile`).
+			static const std::uint32_t ENTRY_COMPRESSED = 1;
+
+			/// File header (at offset 0).
+			struct Header {
+				char magic[8];
+				std::uint32_t version;
+				std::uint32_t byte_order;
+				std::uint64_t file_size;
+				std::uint32_t entry_count;
+				std::uint32_t bucket_count;
+				std::uint32_t alignment;
+				std::uint32_t block_size;
+				std::uint64_t seeds_offset;
+				std::uint64_t entries_offset;
+				std::uint64_t names_offset;
+				std::uint64_t names_size;
+			};
+
+			/// Table of contents entry (one per slot of the perfect hash).
+			struct Entry {
+				HashedIdentity hash;
+				std::uint64_t offset;
+				std::uint64_t size;
+				std::uint64_t stored_size;
+				std::uint32_t name_offset;
+				std::uint32_t name_length;
+				std::uint32_t flags;
+				std::uint32_t reserved;
+			};
+
+			/// Scrambles a hashed identity (so buckets and slots spread evenly).
+			static constexpr std::uint64_t mix(std::uint64_t value) {
+				value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+				value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+				return value ^ (value >> 31);
+			}
+
+			/// Bucket of a hashed identity.
+			static constexpr std::uint32_t bucket_of(HashedIdentity hash, std::uint32_t bucket_count) {
+				return (std::uint32_t)(mix(hash) % bucket_count);
+			}
+
+			/// Entry of a hashed identity, given its bucket's seed.
+			static constexpr std::uint32_t slot_of(HashedIdentity hash, std::uint32_t seed,
+				std::uint32_t entry_count) {
+				return (std::uint32_t)(mix(hash ^ (0x9e3779b97f4a7c15ull * ((std::uint64_t)seed + 1))) % entry_count);
+			}
+
+		private:
+			/// The mapped file.
+			storage::FilePointer file;
+
+			/// Mapping of the whole file.
+			storage::ViewPointer view;
+
+			/// Start of the mapping.
+			const char* data = nullptr;
+
+			/// Size of the mapping.
+			std::uint64_t data_size = 0;
+
+			/// Block size of compressed entries.
+			std::uint32_t block_size = 0;
+
+			/// Pool compressed entries decompress multi-block reads on.
+			WorkerPoolPointer pool;
+
+			/// Sections (pointers into the mapping).
+			const std::uint32_t* seeds = nullptr;
+			const Entry* entries = nullptr;
+			const char* names = nullptr;
+
+			/// Section sizes (in records and bytes respectively).
+			std::uint32_t entry_total = 0;
+			std::uint32_t bucket_total = 0;
+			std::uint64_t name_total = 0;
+
+			/**
+			 * @brief Finds an entry by hashed identity.
+			 * @return Entry, or nullptr if absent or out of range.
+			 */
+			const Entry* find_entry(HashedIdentity identity) const;
+
+			/// Reads an entry's name (empty if out of range).
+			StringIdentity read_name(const Entry& entry) const;
+
+			/// Opens an entry as a file (an `ArchiveEntryFile` or `CompressedEntryFile` sharing `view`).
+			FilePointer open_entry(const Entry& entry) const;
+
+		public:
+			/// Use `open`.
+			PackArchive() {}
+
+			/// Number of entries.
+			std::uint32_t get_child_count() const {
+				return entry_total;
+			}
+
+			/**
+			 * @brief Sets the pool compressed entries decompress on.
+			 * @param[in] worker_pool  Pool (nullptr: each read's calling thread only).
+			 *
+			 * Applies to entries opened afterwards.
+			 */
+			void set_worker_pool(WorkerPoolPointer worker_pool) {
+				pool = std::move(worker_pool);
+			}
+
+			/// Path of the pack.
+			std::filesystem::path get_path() const;
+
+			/**
+			 * @brief Gets an entry by hashed identity (FNV-1a of its name).
+			 * @param[in] identity  Hashed identity of the entry.
+			 * @param[in] access    Access type (only `Read` is supported).
+			 * @return Pointer to a file, or nullptr if look-up fails.
+			 */
+			FilePointer get_file(HashedIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read);
+
+			/**
+			 * @brief Gets an entry by name.
+			 * @param[in] identity  Name of the entry.
+			 * @param[in] access    Access type (only `Read` is supported).
+			 * @return Pointer to a file, or nullptr if look-up fails.
+			 */
+			FilePointer get_file(StringIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read);
+
+			/// Every entry is named (hashed look-ups find nothing string ones cannot).
+			bool resolves_unlisted_hashes() {
+				return false;
+			}
+
+			/// Enumerates every entry's name (in table order).
+			bool enumerate(const EnumerationFunction& callback);
+
+			/// Builds a filter covering names and their FNV-1a hashes.
+			IdentityFilterPointer build_identity_filter();
+
+			/**
+			 * @brief Maps a pack.
+			 * @param[in] file  File to be mapped.
+			 * @return Archive, or nullptr if it is not a pack, of another version, or malformed.
+			 */
+			static PackArchivePointer open(const storage::FilePointer& file);
+
+			/**
+			 * @brief Maps a pack.
+			 * @param[in] path  File to be mapped.
+			 * @return Archive, or nullptr if it is missing, of another version, or malformed.
+			 */
+			static PackArchivePointer open(const std::filesystem::path& path);
+
+			/**
+			 * @brief Loader for `ArchiveSystem::register_loader`.
+			 * @param[in] file  File to be mapped.
+			 * @return Archive, or nullptr if the file is not a pack (see `open`).
+			 */
+			static ArchivePointer load(const storage::FilePointer file) {
+				return open(file);
+			}
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_PACKARCHIVE_HPP
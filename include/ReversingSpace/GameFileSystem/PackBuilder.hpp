@@ -0,0 +1,262 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_PACKBUILDER_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_PACKBUILDER_HPP
+
+#include <ReversingSpace/GameFileSystem/CompressedEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+// std::string
+#include <string>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Writes packs (see `PackArchive`).
+		 *
+		 * Entries are named and given either a file on disk (read when
+		 * the pack is written) or bytes held in memory, one at a time,
+		 * from a directory tree (`add_directory`) or from a manifest
+		 * (`add_manifest`).  Names must be unique, and so must their
+		 * FNV-1a hashes: `write` fails rather than write a pack in which
+		 * an entry cannot be found.
+		 *
+		 * Layout:
+		 * - Entries named by the access trace (`set_access_trace`) are
+		 *   written first, in trace order, so a start-up which reads
+		 *   them in that order reads the pack front to back; the rest
+		 *   follow in the order added;
+		 * - Entries of identical content are stored once and share it
+		 *   (unless `set_deduplication(false)`); content is compared
+		 *   byte for byte, not just by hash;
+		 * - Entries start on an `alignment` boundary (a page, by
+		 *   default); `set_small_entries` packs entries below a size
+		 *   more tightly;
+		 * - With `set_compression`, entries are block-compressed where
+		 *   that saves at least an eighth of their size, and stored
+		 *   as-is otherwise.
+		 *
+		 * Given a worker pool (`set_worker_pool`), sources are sized and
+		 * their contents hashed on the pool while the calling thread hashes
+		 * the names and builds the perfect hash, and entries are read ahead
+		 * (and compressed) on the pool while the calling thread writes.  The pack is the
+		 * same either way.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API PackBuilder {
+		public:
+			/// Figures from the last `write`.
+			struct Statistics {
+				/// Entries written.
+				size_t entries = 0;
+
+				/// Distinct contents stored (less than `entries` when deduplicated).
+				size_t stored = 0;
+
+				/// Bytes of entry content (before deduplication).
+				std::uint64_t content_bytes = 0;
+
+				/// Bytes not stored thanks to deduplication.
+				std::uint64_t deduplicated_bytes = 0;
+
+				/// Distinct contents stored block-compressed.
+				size_t compressed = 0;
+
+				/// Size of the pack.
+				std::uint64_t file_size = 0;
+			};
+
+		private:
+			/// Entry to be written.
+			struct Source {
+				/// Name (identity) of the entry.
+				std::string name;
+
+				/// File holding the entry (empty: use `bytes`).
+				std::filesystem::path path;
+
+				/// Bytes of the entry (when `path` is empty).
+				std::vector<std::uint8_t> bytes;
+			};
+
+			/// Entries, in the order added.
+			std::vector<Source> sources;
+
+			/// Entry alignment (a power of two).
+			std::uint32_t alignment;
+
+			/// Entries smaller than this use `small_alignment` (0: none do).
+			std::uint64_t small_threshold = 0;
+
+			/// Alignment of small entries (a power of two).
+			std::uint32_t small_alignment = 8;
+
+			/// Names in first-access order.
+			std::vector<std::string> access_trace;
+
+			/// Whether identical contents are stored once.
+			bool deduplicate = true;
+
+			/// Whether entries are block-compressed (where it pays).
+			bool compress = false;
+
+			/// Block size of compressed entries (a power of two).
+			std::uint32_t block_size;
+
+			/// Pool for hashing and reading ahead (nullptr: the calling thread only).
+			WorkerPoolPointer pool;
+
+			/// Figures from the last `write`.
+			mutable Statistics statistics;
+
+		public:
+			/// Constructs an empty builder (page-aligned entries).
+			PackBuilder();
+
+			/**
+			 * @brief Sets the entry alignment.
+			 * @param[in] value  Alignment in bytes (a power of two).
+			 * @return false (leaving it unchanged) if `value` is not a power of two.
+			 *
+			 * The default is a page (`PackArchive::DEFAULT_ALIGNMENT`), so
+			 * every entry can be mapped on its own; smaller alignments
+			 * pack many small entries more tightly.
+			 */
+			bool set_alignment(std::uint32_t value);
+
+			/// Gets the entry alignment.
+			std::uint32_t get_alignment() const {
+				return alignment;
+			}
+
+			/**
+			 * @brief Aligns entries below a size more tightly.
+			 * @param[in] threshold  Entries smaller than this many bytes are small (0: none are).
+			 * @param[in] value      Alignment of small entries (a power of two).
+			 * @return false (leaving them unchanged) if `value` is not a power of two.
+			 *
+			 * Large entries stay on `alignment` boundaries, so they can be
+			 * mapped (and read ahead) by page; small ones no longer waste
+			 * most of a page each.
+			 */
+			bool set_small_entries(std::uint64_t threshold, std::uint32_t value = 8);
+
+			/**
+			 * @brief Sets the access trace.
+			 * @param[in] names  Entry names in the order they are first read.
+			 *
+			 * Names not in the pack are ignored, as are repeats.
+			 */
+			void set_access_trace(std::vector<std::string> names);
+
+			/**
+			 * @brief Reads an access trace (one name per line).
+			 * @param[in] path  Trace file.
+			 * @return false if it cannot be read.
+			 */
+			bool load_access_trace(const std::filesystem::path& path);
+
+			/// Sets whether identical contents are stored once (on by default).
+			void set_deduplication(bool enabled) {
+				deduplicate = enabled;
+			}
+
+			/**
+			 * @brief Sets whether entries are block-compressed (off by default).
+			 * @param[in] enabled  Whether to compress.
+			 * @param[in] value    Block size: a power of two from 4KB to 1MB.
+			 * @return false (leaving it unchanged) if `value` is out of range.
+			 *
+			 * Smaller blocks make reads of part of an entry cheaper; larger
+			 * ones compress better.  Entries which do not shrink by an eighth
+			 * are stored as-is (entries too large to hold in memory, which
+			 * are compressed as they are streamed, are kept either way).
+			 */
+			bool set_compression(bool enabled,
+				std::uint32_t value = CompressedEntryFile::DEFAULT_BLOCK_SIZE);
+
+			/// Sets the pool used to hash and read ahead (nullptr: calling thread only).
+			void set_worker_pool(WorkerPoolPointer worker_pool) {
+				pool = std::move(worker_pool);
+			}
+
+			/// Number of entries added.
+			size_t size() const {
+				return sources.size();
+			}
+
+			/// Figures from the last successful `write`.
+			const Statistics& get_statistics() const {
+				return statistics;
+			}
+
+			/**
+			 * @brief Adds a file on disk (read by `write`).
+			 * @param[in] name  Name (identity) of the entry.
+			 * @param[in] path  File to be stored.
+			 */
+			void add(StringIdentity name, const std::filesystem::path& path);
+
+			/**
+			 * @brief Adds bytes held in memory.
+			 * @param[in] name   Name (identity) of the entry.
+			 * @param[in] bytes  Contents of the entry.
+			 */
+			void add(StringIdentity name, std::vector<std::uint8_t> bytes);
+
+			/**
+			 * @brief Adds every file in a directory tree.
+			 * @param[in] path    Root of the tree.
+			 * @param[in] prefix  Prepended to each relative (generic) path to name it.
+			 * @return false if the tree cannot be read.
+			 *
+			 * Files are added sorted by relative path (see `DirectoryListing::scan`).
+			 */
+			bool add_directory(const std::filesystem::path& path, StringIdentity prefix = StringIdentity());
+
+			/**
+			 * @brief Adds the files a manifest lists.
+			 * @param[in] path  Manifest file.
+			 * @return false if it cannot be read.
+			 *
+			 * One entry per line: either a name, stored from the file of
+			 * that name next to the manifest, or a name, a tab and the
+			 * file to store (relative to the manifest unless absolute).
+			 * Blank lines and lines starting with `#` are skipped.
+			 */
+			bool add_manifest(const std::filesystem::path& path);
+
+			/**
+			 * @brief Writes the pack.
+			 * @param[in] path  File to be written (replaced whole, via a temporary file).
+			 * @return false if a source cannot be read, two entries share a
+			 *         name or hash, or the file could not be written.
+			 */
+			bool write(const std::filesystem::path& path) const;
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_PACKBUILDER_HPP
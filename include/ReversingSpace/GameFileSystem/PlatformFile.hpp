@@ -63,21 +63,37 @@ namespace reversingspace {
 			 * @param[in] path    Path to file.
 			 * @param[in] access  Requested access to file.
 			 * @return shared_ptr to a PlatformFile, or nullptr on failure.
+			 *
+			 * The path is moved into the stored file (pass an rvalue to
+			 * avoid copying it).
 			 */
-			inline static PlatformFilePointer create(const std::filesystem::path& path,
+			inline static PlatformFilePointer create(std::filesystem::path path,
 				storage::FileAccess access = storage::FileAccess::Read) {
 				
 				// Get a stored file.
 				// This leaves issue #2 (symlinking) an upstream issue
 				// and not something that needs re-addressing here!
-				auto stored = storage::File::create(path, access);
+				auto stored = storage::File::create(std::move(path), access);
+				if (stored == nullptr) {
+					return nullptr;
+				}
+
+				return create(std::move(stored));
+			}
+
+			/**
+			 * @brief Inline static helper to wrap an opened stored file.
+			 * @param[in] stored  Stored file (e.g. from `DirectoryHandle::open`).
+			 * @return shared_ptr to a PlatformFile, or nullptr if `stored` is nullptr.
+			 */
+			inline static PlatformFilePointer create(storage::FilePointer stored) {
 				if (stored == nullptr) {
 					return nullptr;
 				}
 
 				// Create and return.
 				auto file = std::make_shared<PlatformFile>();
-				file->stored_file = stored;
+				file->stored_file = std::move(stored);
 				file->cursor = 0;
 
 				return file;
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_READONLYFILE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_READONLYFILE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/File.hpp>
+
+// std::mutex
+#include <mutex>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Base for read-only files of a fixed size.
+		 *
+		 * Holds the size and the cursor, and implements everything but
+		 * positioned reads on top of them: `seek`, `tell` and `read` go
+		 * through the cursor, the vector `read_from` sizes the vector and
+		 * forwards, and writes are refused.  Implementations only provide
+		 * `read_from` into a buffer.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API ReadOnlyFile : public File {
+		protected:
+			/// Size of the file.
+			const storage::StorageSize size;
+
+		private:
+			/// Cursor.
+			storage::StorageSize cursor = 0;
+
+			/// Cursor mutex.
+			mutable std::mutex cursor_mutex;
+
+		protected:
+			/// Constructs a file of `size` bytes (cursor at the start).
+			explicit ReadOnlyFile(storage::StorageSize size) : size(size) {}
+
+			/// Number of bytes readable at `offset` (none past the end).
+			storage::StorageSize allowance(storage::StorageOffset offset,
+				storage::StorageSize requested) const;
+
+		public: // File
+			storage::StorageSize seek(storage::StorageOffset offset,
+				storage::Seek whence = storage::Seek::Set);
+
+			storage::StorageSize get_size() const {
+				return size;
+			}
+
+			storage::StorageOffset tell() const;
+
+			storage::StorageSize read(char* data, storage::StorageSize requested);
+
+			storage::StorageSize read(std::vector<std::uint8_t>& data,
+				storage::StorageSize requested);
+
+			/// Reads `allowance` bytes at `offset` (implemented by each file).
+			storage::StorageSize read_from(storage::StorageOffset offset,
+				char* data, storage::StorageSize requested) = 0;
+
+			storage::StorageSize read_from(storage::StorageOffset offset,
+				std::vector<std::uint8_t>& data, storage::StorageSize requested);
+
+			/// Read-only: returns 0.
+			storage::StorageSize write(char*, storage::StorageSize) {
+				return 0;
+			}
+
+			/// Read-only: returns 0.
+			storage::StorageSize write(std::vector<std::uint8_t>&, storage::StorageSize) {
+				return 0;
+			}
+
+			/// Read-only: returns 0.
+			storage::StorageSize write_to(storage::StorageOffset, char*, storage::StorageSize) {
+				return 0;
+			}
+
+			/// Read-only: returns 0.
+			storage::StorageSize write_to(storage::StorageOffset,
+				std::vector<std::uint8_t>&, storage::StorageSize) {
+				return 0;
+			}
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_READONLYFILE_HPP
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_SEALEDTABLE_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_SEALEDTABLE_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `SealedTable`.
+		class SealedTable;
+
+		/// Shared pointer type for `SealedTable`.
+		using SealedTablePointer = std::shared_ptr<const SealedTable>;
+
+		/**
+		 * @brief Frozen identity -> mount table over a whole mount stack.
+		 *
+		 * Built once (see `StorageServer::seal`) by enumerating every mount
+		 * from the top down; each identity maps to the one mount which
+		 * resolves it.  A look-up is one FNV-1a hash and a short linear
+		 * probe through a flat, at most half full slot array, after which
+		 * only the owning mount is asked for the file.
+		 *
+		 * Nothing in the table changes after `build`, so any number of
+		 * threads can read it without synchronisation.  It holds the
+		 * mounts it points at.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API SealedTable {
+		private:
+			/// Slot (empty when `owner` is `EMPTY_SLOT`).
+			struct Slot {
+				/// FNV-1a hash of the identity.
+				std::uint64_t hash;
+
+				/// Offset of the identity in `names`.
+				std::uint32_t name_offset;
+
+				/// Length of the identity.
+				std::uint32_t name_length;
+
+				/// Position of the owning mount in `mounts`.
+				std::uint32_t owner;
+			};
+
+			/// Marks an empty slot.
+			static const std::uint32_t EMPTY_SLOT = 0xffffffff;
+
+			/// Slots (a power of two).
+			std::vector<Slot> slots;
+
+			/// Identities, end to end.
+			std::string names;
+
+			/// The mounts (bottom to top).
+			std::vector<FileSystemPointer> mounts;
+
+			/// Number of identities.
+			size_t identity_count = 0;
+
+		public:
+			/// Use `build`.
+			SealedTable() {}
+
+			/// Number of identities.
+			size_t size() const {
+				return identity_count;
+			}
+
+			/// Approximate memory held, in bytes.
+			size_t memory_size() const {
+				return slots.capacity() * sizeof(Slot) + names.capacity();
+			}
+
+			/**
+			 * @brief Finds the mount resolving an identity.
+			 * @param[in] identity  Identity to be found.
+			 * @return Mount, or nullptr if no mount listed the identity.
+			 */
+			FileSystem* find(StringIdentity identity) const;
+
+			/**
+			 * @brief Gets a file from the mount resolving it.
+			 * @param[in] identity  Identity to be found.
+			 * @return File, or nullptr if no mount listed it (or the mount failed to open it).
+			 */
+			FilePointer get_file(StringIdentity identity) const;
+
+			/// Calls `callback` for every identity (in table order).
+			void for_each(const EnumerationFunction& callback) const;
+
+			/**
+			 * @brief Builds a table over a mount stack.
+			 * @param[in] stack  Mounts (bottom to top).
+			 * @return Table, or nullptr if a mount cannot be enumerated.
+			 */
+			static SealedTablePointer build(const std::vector<FileSystemPointer>& stack);
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_SEALEDTABLE_HPP
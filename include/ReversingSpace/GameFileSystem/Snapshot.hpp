@@ -0,0 +1,192 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_SNAPSHOT_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_SNAPSHOT_HPP
+
+// std::atomic
+#include <atomic>
+
+// std::uint64_t
+#include <cstdint>
+
+// std::unique_ptr
+#include <memory>
+
+// std::mutex, std::lock_guard
+#include <mutex>
+
+// std::this_thread::yield
+#include <thread>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Read-copy-update holder for an immutable value.
+		 *
+		 * Readers pin the current value without taking a lock (two atomic
+		 * increments and a load); writers copy the value, modify the copy
+		 * and publish it with a single pointer swap.  Writers are serialised
+		 * with each other, and a writer waits for the readers of the value
+		 * it replaced before freeing it, so a pinned value stays valid (and
+		 * unchanged) for as long as the `Reader` lives.  Every update copies
+		 * the value, so `T` should share its bulk between copies.
+		 *
+		 * Readers are counted per epoch (two slots, alternating); a writer
+		 * flips the epoch after publishing, then waits for the old slot to
+		 * drain.  New readers always land in the new slot.
+		 *
+		 * A thread must not update a `Snapshot` while it holds a `Reader` of
+		 * the same `Snapshot` (the update would wait for itself).
+		 */
+		template<typename T>
+		class Snapshot {
+		private:
+			/// Currently published value (never nullptr).
+			std::atomic<const T*> current;
+
+			/// Publication epoch; readers register in slot `epoch & 1`.
+			mutable std::atomic<std::uint64_t> epoch{ 0 };
+
+			/// Reader counts (one cache line each, as every reader hits them).
+			struct alignas(64) Slot {
+				std::atomic<size_t> readers{ 0 };
+			};
+			mutable Slot slots[2];
+
+			/// Serialises writers.
+			std::mutex writer;
+
+			/**
+			 * @brief Publishes a value and frees its predecessor.
+			 * @param[in] next  New value (ownership is taken).
+			 *
+			 * The caller holds `writer`.
+			 */
+			void publish(const T* next) {
+				const T* previous = current.exchange(next);
+				auto old_epoch = epoch.fetch_add(1);
+				auto& slot = slots[old_epoch & 1].readers;
+				while (slot.load() != 0) {
+					std::this_thread::yield();
+				}
+				delete previous;
+			}
+
+		public:
+			/**
+			 * @brief Pinned (read-only) view of the published value.
+			 *
+			 * Keep these short-lived: writers wait for them.
+			 */
+			class Reader {
+			private:
+				/// Slot counter holding this reader (nullptr once released).
+				std::atomic<size_t>* slot;
+
+				/// Pinned value.
+				const T* value;
+
+				friend class Snapshot;
+
+				Reader(std::atomic<size_t>* slot, const T* value) : slot(slot), value(value) {}
+
+			public:
+				Reader(const Reader&) = delete;
+				Reader& operator=(const Reader&) = delete;
+
+				Reader(Reader&& other) : slot(other.slot), value(other.value) {
+					other.slot = nullptr;
+				}
+
+				~Reader() {
+					if (slot != nullptr) {
+						slot->fetch_sub(1);
+					}
+				}
+
+				const T* operator->() const {
+					return value;
+				}
+
+				const T& operator*() const {
+					return *value;
+				}
+			};
+
+			/**
+			 * @brief Constructs a snapshot holding a value.
+			 * @param[in] initial  Initial value.
+			 */
+			explicit Snapshot(T initial = T()) : current(new T(std::move(initial))) {}
+
+			Snapshot(const Snapshot&) = delete;
+			Snapshot& operator=(const Snapshot&) = delete;
+
+			/// Frees the published value (no readers may remain).
+			~Snapshot() {
+				delete current.load();
+			}
+
+			/**
+			 * @brief Pins the published value (lock-free).
+			 * @return Reader for the value.
+			 */
+			Reader read() const {
+				for (;;) {
+					auto observed = epoch.load();
+					auto& slot = slots[observed & 1].readers;
+					slot.fetch_add(1);
+					// A writer may have flipped the epoch (and started waiting
+					// on this slot) in between; if so back out and retry, so
+					// that writer is not held up by a value it never sees.
+					if (epoch.load() == observed) {
+						return Reader(&slot, current.load());
+					}
+					slot.fetch_sub(1);
+				}
+			}
+
+			/**
+			 * @brief Copies, modifies and publishes the value.
+			 * @param[in] mutate  Called with the copy; returns false to abandon it.
+			 * @return Result of `mutate` (nothing is published on false).
+			 */
+			template<typename Function>
+			bool update(Function&& mutate) {
+				std::lock_guard<std::mutex> lock(writer);
+				std::unique_ptr<T> next(new T(*current.load()));
+				if (!mutate(*next)) {
+					return false;
+				}
+				publish(next.release());
+				return true;
+			}
+
+			/**
+			 * @brief Runs a function under the writer lock, without copying.
+			 * @param[in] inspect  Called with the published value.
+			 * @return Result of `inspect`.
+			 *
+			 * For work which must not race an `update` but changes nothing
+			 * (no copy is made and nothing is published).
+			 */
+			template<typename Function>
+			auto exclusive(Function&& inspect) {
+				std::lock_guard<std::mutex> lock(writer);
+				return inspect(*current.load());
+			}
+		};
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_SNAPSHOT_HPP
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_STATICSTORAGESERVER_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_STATICSTORAGESERVER_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+
+// std::tuple
+#include <tuple>
+
+// std::index_sequence
+#include <utility>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * @brief Storage server over a mount stack fixed at compile time.
+		 * @tparam Userland  Userland filesystem type (e.g. `Directory<PlatformFile>`).
+		 * @tparam Dataland  Dataland filesystem types, highest priority first.
+		 *
+		 * For layouts which never change, such as
+		 * `StaticStorageServer<Directory<PlatformFile>, PatchArchive, BaseArchive>`.
+		 * The mounts are held by value, so the server allocates nothing of
+		 * its own, and look-ups walk the stack with calls bound at compile
+		 * time: each mount's `get_file` is called by its qualified name,
+		 * which skips virtual dispatch and lets the compiler inline it
+		 * (declare mount types `final` to make the most of this).
+		 *
+		 * Look-ups resolve exactly as `StorageServer`'s (without its index,
+		 * filters or cache): userland first, then dataland from the top
+		 * down, then (given a hash function) dataland again by hash.
+		 * Note that `Dataland` lists mounts top first, whereas
+		 * `StorageServer::mount` pushes them bottom first.
+		 *
+		 * Mount types must be constructible from one argument each and
+		 * need not be copyable or movable; the server is neither.
+		 */
+		template<typename Userland, typename... Dataland>
+		class StaticStorageServer {
+		private:
+			/// Userland storage space.
+			Userland userland;
+
+			/// Dataland mounts (highest priority first).
+			std::tuple<Dataland...> dataland;
+
+			/// Hash function (for string look-ups falling back to hashed ones).
+			HashFunction hash_function;
+
+			/// Calls a mount's own `get_file` (bound statically).
+			template<typename Mount, typename Key>
+			static FilePointer get_from(Mount& mount, const Key& identity,
+				storage::FileAccess access = storage::FileAccess::Read) {
+				return mount.Mount::get_file(identity, access);
+			}
+
+			/// Walks dataland from the top, stopping at the first hit.
+			template<typename Key, size_t... Positions>
+			FilePointer walk_dataland(const Key& identity, std::index_sequence<Positions...>) {
+				FilePointer file = nullptr;
+				(void)(((file = get_from(std::get<Positions>(dataland), identity)) != nullptr) || ...);
+				return file;
+			}
+
+			/// Retries a missed string look-up hashed, on mounts with hashed-only entries.
+			template<size_t... Positions>
+			FilePointer retry_hashed(HashedIdentity identity, std::index_sequence<Positions...>) {
+				FilePointer file = nullptr;
+				(void)(((file = retry_from(std::get<Positions>(dataland), identity)) != nullptr) || ...);
+				return file;
+			}
+
+			/// Calls a mount's own hashed `get_file` if it can find more than its string one.
+			template<typename Mount>
+			static FilePointer retry_from(Mount& mount, HashedIdentity identity) {
+				if (!mount.Mount::resolves_unlisted_hashes()) {
+					return nullptr;
+				}
+				return get_from(mount, identity);
+			}
+
+			/// Enumerates dataland from the top, stopping at a mount which cannot.
+			template<size_t... Positions>
+			bool enumerate_dataland(const EnumerationFunction& callback, std::index_sequence<Positions...>) {
+				return (std::get<Positions>(dataland).enumerate(callback) && ...);
+			}
+
+			/// Offers `hash_function` to every dataland mount.
+			template<size_t... Positions>
+			void offer_dataland(std::index_sequence<Positions...>) {
+				(std::get<Positions>(dataland).offer_hash_function(hash_function), ...);
+			}
+
+		public:
+			/**
+			 * @brief Constructs the server and its mounts.
+			 * @param[in] userland_path  Path to valid userland.
+			 * @param[in] arguments      One constructor argument per dataland mount (top first).
+			 */
+			template<typename... Arguments>
+			explicit StaticStorageServer(const std::filesystem::path& userland_path, Arguments&&... arguments)
+				: userland(userland_path), dataland(std::forward<Arguments>(arguments)...) {
+				static_assert(sizeof...(Arguments) == sizeof...(Dataland),
+					"one argument per dataland mount");
+			}
+
+			StaticStorageServer(const StaticStorageServer&) = delete;
+			StaticStorageServer& operator=(const StaticStorageServer&) = delete;
+
+			/**
+			 * @brief Sets the hash function, offering it to every dataland mount.
+			 * @param[in] function  Hash function (nullptr disables the hashed fallback).
+			 *
+			 * Call before looking anything up (this is not synchronised).
+			 */
+			void set_hash_function(HashFunction function) {
+				hash_function = std::move(function);
+				if (hash_function != nullptr) {
+					offer_dataland(std::index_sequence_for<Dataland...>());
+				}
+			}
+
+			/// Returns the userland path.
+			std::filesystem::path get_path() const {
+				return userland.get_path();
+			}
+
+			/// Gets the userland filesystem.
+			Userland& get_userland() {
+				return userland;
+			}
+
+			/// Gets a dataland mount (0 is the top).
+			template<size_t Position>
+			auto& get_mount() {
+				return std::get<Position>(dataland);
+			}
+
+			/// Number of mounts in dataland.
+			static constexpr size_t mount_count() {
+				return sizeof...(Dataland);
+			}
+
+			/**
+			 * @brief Fetch a file from the dataland (only).
+			 * @param[in] identity  Identity to be found.
+			 * @return Pointer to a file (or nullptr on failure).
+			 */
+			FilePointer get_dataland_file(HashedIdentity identity) {
+				return walk_dataland(identity, std::index_sequence_for<Dataland...>());
+			}
+
+			/**
+			 * @brief Fetch a file from the dataland (only).
+			 * @param[in] identity  Identity to be found.
+			 * @return Pointer to a file (or nullptr on failure).
+			 *
+			 * Falls back to the hashed identity on mounts with hashed-only
+			 * entries, as `StorageServer` does.
+			 */
+			FilePointer get_dataland_file(StringIdentity identity) {
+				auto file = walk_dataland(identity, std::index_sequence_for<Dataland...>());
+				if (file != nullptr || hash_function == nullptr) {
+					return file;
+				}
+				return retry_hashed(hash_function(identity), std::index_sequence_for<Dataland...>());
+			}
+
+			/**
+			 * @brief Fetch a file from the userland (only).
+			 * @param[in] identity   Identity to be used.
+			 * @param[in] access     Access to be used.
+			 * @return  Pointer to a file (or nullptr on failure).
+			 */
+			FilePointer get_userland_file(StringIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read) {
+				return get_from(userland, identity, access);
+			}
+
+			/**
+			 * @brief Gets a file (dataland only, as hashed identities have no userland).
+			 * @param[in] identity  Hashed identity of the file.
+			 * @return Pointer to a file, or nullptr if look-up fails.
+			 */
+			FilePointer get_file(HashedIdentity identity) {
+				return get_dataland_file(identity);
+			}
+
+			/**
+			 * @brief Gets a file: userland first, followed by dataland.
+			 * @param[in] identity  Identity of the file.
+			 * @param[in] access    Access type (applies to userland).
+			 * @return Pointer to a file, or nullptr if look-up fails.
+			 */
+			FilePointer get_file(StringIdentity identity,
+				storage::FileAccess access = storage::FileAccess::Read) {
+				auto file = get_userland_file(identity, access);
+				if (file != nullptr) {
+					return file;
+				}
+				return get_dataland_file(identity);
+			}
+
+			/**
+			 * @brief Enumerates userland and dataland (once per identity).
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if a mount cannot be enumerated.
+			 */
+			bool enumerate(const EnumerationFunction& callback) {
+				IdentityMap<bool> seen;
+				EnumerationFunction unique = [&seen, &callback](StringIdentity name) {
+					if (seen.count(name) == 0) {
+						seen[name] = true;
+						callback(name);
+					}
+				};
+				return userland.enumerate(unique) &&
+					enumerate_dataland(unique, std::index_sequence_for<Dataland...>());
+			}
+		};
+	}
+}
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_STATICSTORAGESERVER_HPP
@@ -17,11 +17,34 @@
 #include <ReversingSpace/GameFileSystem/Directory.hpp>
 #include <ReversingSpace/GameFileSystem/File.hpp>
 #include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+#include <ReversingSpace/GameFileSystem/MountIndex.hpp>
+#include <ReversingSpace/GameFileSystem/SealedTable.hpp>
+#include <ReversingSpace/GameFileSystem/Snapshot.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+// std::find (index repairs)
+#include <algorithm>
+
+// std::atomic (cache capacity)
+#include <atomic>
+
+// std::condition_variable (parallel probing)
+#include <condition_variable>
+
+// std::unique_lock
+#include <mutex>
+
+// std::shared_mutex
+#include <shared_mutex>
+
+// std::unordered_map (look-up cache)
+#include <unordered_map>
 
 namespace reversingspace {
 	namespace gfs {
 		// Require PlatformFile here as a default.
-		class REVSPACE_GAMEFILESYSTEM_API PlatformFile;
+		class PlatformFile;
 
 		/**
 		 * @brief Simple storage server system.
@@ -34,13 +57,73 @@ namespace reversingspace {
 		class StorageServer : public FileSystem {
 		private:
 			/**
-			 * @brief 'Stack' of data mounts.
-			 *
-			 * This is a vector of read-only mounts.
+			 * @brief Mount table (immutable once published).
+			 */
+			struct MountTable {
+				/**
+				 * @brief 'Stack' of data mounts.
+				 *
+				 * This is a vector of read-only mounts.
+				 *
+				 * This is processed backwards (using a reverse iterator).
+				 */
+				std::vector<FileSystemPointer> dataland;
+
+				/**
+				 * @brief Merged index over the dataland stack.
+				 *
+				 * Only used (and maintained) once `build_index` is called.
+				 */
+				MountIndex index;
+
+				/// Whether `index` is in use.
+				bool indexed = false;
+
+				/**
+				 * @brief Per-mount identity filters (parallel to `dataland`).
+				 *
+				 * Empty unless mount filters are enabled; a nullptr filter
+				 * means the mount could not build one (always probed).
+				 */
+				std::vector<IdentityFilterPointer> filters;
+
+				/// Whether mount filters are in use.
+				bool filtered = false;
+
+				/**
+				 * @brief Returns false if mount `position` cannot hold `identity`.
+				 */
+				template<typename Key>
+				bool may_contain(size_t position, const Key& identity) const {
+					if (position >= filters.size() || filters[position] == nullptr) {
+						return true;
+					}
+					return filters[position]->may_contain(identity);
+				}
+
+				/// Pool used to probe mounts in parallel (nullptr probes serially).
+				WorkerPoolPointer probe_pool;
+
+				/// Finds the position of a mount (or `dataland.size()`).
+				size_t position_of(const FileSystem* mountable) const {
+					size_t position = 0;
+					while (position < dataland.size() && dataland[position].get() != mountable) {
+						++position;
+					}
+					return position;
+				}
+			};
+
+			/**
+			 * @brief Published mount table.
 			 *
-			 * This is processed backwards (using a reverse iterator).
+			 * Look-ups pin the current table without locking; `mount` and
+			 * `unmount` (and the index calls) publish a modified copy, so
+			 * mounts can be changed while other threads resolve files.
+			 * Copies share the index's storage (see `MountIndex`), so a
+			 * change costs what it touches, not the size of the index.
 			 */
-			std::vector<FileSystemPointer> dataland;
+			Snapshot<MountTable> mounts;
 
 			/**
 			 * @brief Userland storage space.
@@ -51,9 +134,395 @@ namespace reversingspace {
 
 			/**
 			 * @brief Pointer to a hash function.
+			 *
+			 * Offered to every mount (see `FileSystem::offer_hash_function`);
+			 * a `Directory` adopting it scans its whole tree on its first
+			 * hashed look-up.  String look-ups which miss are retried hashed
+			 * on mounts with hashed-only entries.
 			 */
 			HashFunction hash_function;
 
+			/**
+			 * @brief Dataland resolution cache (string identities).
+			 *
+			 * Maps an identity to the mount which answered it.  A nullptr
+			 * mount is a negative entry (no mount could resolve it).
+			 * Keyed by view, so a hit does not allocate.
+			 */
+			IdentityMap<FileSystemPointer> resolution_cache;
+
+			/**
+			 * @brief Dataland resolution cache (hashed identities).
+			 *
+			 * See `resolution_cache`.
+			 */
+			std::unordered_map<HashedIdentity, FileSystemPointer> hashed_resolution_cache;
+
+			/**
+			 * @brief Guards both resolution caches.
+			 *
+			 * Look-ups are expected to come from multiple threads, so the
+			 * cache cannot be left unguarded.  (This is the only lock on the
+			 * look-up path, and only once the cache is enabled.)
+			 */
+			mutable std::shared_mutex cache_mutex;
+
+			/**
+			 * @brief Cache generation.
+			 *
+			 * Bumped whenever cached resolutions may have gone stale (mount
+			 * changes, invalidation).  A look-up notes it before resolving and
+			 * only stores its result if it is unchanged, so a resolution made
+			 * against stale state is never cached.
+			 */
+			std::uint64_t cache_generation = 0;
+
+			/// Serialises watch state changes (never held by watcher callbacks).
+			std::mutex watch_mutex;
+
+			/// Whether mounts are watched for changes (guarded by `watch_mutex`).
+			bool watching = false;
+
+			/// Maximum number of entries (per cache); zero disables caching.
+			std::atomic<size_t> cache_capacity{ 0 };
+
+			/**
+			 * @brief Index entries look-ups found stale, awaiting removal.
+			 *
+			 * Identity -> mounts confirmed not to have it (see
+			 * `FileSystem::lacks`).  Look-ups only queue these; they are
+			 * applied by the next published change (or `repair_index`), so
+			 * the read path never copies or publishes a mount table.
+			 */
+			IdentityMap<std::vector<FileSystemPointer>> repairs;
+
+			/// Guards `repairs`.
+			std::mutex repair_mutex;
+
+			/// Table built by `seal` (holds what `sealed` points at).
+			SealedTablePointer sealed_table;
+
+			/// The sealed table, or nullptr until sealed (set once, never cleared).
+			std::atomic<const SealedTable*> sealed{ nullptr };
+
+			/**
+			 * @brief Resolves an identity against the cache.
+			 * @param[in] cache     Cache to test.
+			 * @param[in] identity  Identity to be found.
+			 * @param[out] mount    Mount recorded in the cache (nullptr on a miss).
+			 * @param[out] ticket   Cache generation, for `store_cached`.
+			 * @return true if the identity is cached (positive or negative).
+			 */
+			template<typename Cache, typename Key>
+			bool find_cached(const Cache& cache, const Key& identity,
+				FileSystemPointer& mount, std::uint64_t& ticket) const {
+				std::shared_lock lock(cache_mutex);
+				ticket = cache_generation;
+				auto entry = cache.find(identity);
+				if (entry == cache.end()) {
+					return false;
+				}
+				mount = entry->second;
+				return true;
+			}
+
+			/**
+			 * @brief Records a resolution in the cache.
+			 * @param[in] cache     Cache to update.
+			 * @param[in] identity  Identity which was resolved.
+			 * @param[in] mount     Winning mount (nullptr for a miss).
+			 * @param[in] ticket    Cache generation noted before resolving.
+			 *
+			 * The cache is flushed when it reaches capacity; this keeps the
+			 * negative entries from growing without bound.  Resolutions made
+			 * before an invalidation are dropped.
+			 */
+			template<typename Cache, typename Key>
+			void store_cached(Cache& cache, const Key& identity,
+				FileSystemPointer mount, std::uint64_t ticket) {
+				std::unique_lock lock(cache_mutex);
+				if (cache_capacity == 0 || ticket != cache_generation) {
+					return;
+				}
+				if (cache.size() >= cache_capacity) {
+					cache.clear();
+				}
+				cache[identity] = mount;
+			}
+
+			/**
+			 * @brief State shared by the probes of one parallel look-up.
+			 * @tparam Key  Owned identity type (probes may outlive the caller).
+			 *
+			 * Mounts are held in rank order (highest priority first).  Each
+			 * probe is claimed exactly once, by a pool thread or by the caller;
+			 * once a rank hits, probes of lower priority which have not yet
+			 * started are skipped.
+			 */
+			template<typename Key>
+			struct ProbeState {
+				/// Probe states.
+				enum : int { PENDING, RUNNING, DONE };
+
+				/// Identity being resolved.
+				Key identity;
+
+				/// Mounts, highest priority first.
+				std::vector<FileSystemPointer> mounts;
+
+				/// Per-rank results (valid once the rank is `DONE`).
+				std::vector<FilePointer> results;
+
+				/// Per-rank probe states.
+				std::unique_ptr<std::atomic<int>[]> states;
+
+				/// Ranks above this are cancelled.
+				std::atomic<size_t> cutoff;
+
+				/// Guards `results`; `finished` waits on it.
+				std::mutex mutex;
+
+				/// Signalled as each probe completes.
+				std::condition_variable finished;
+
+				ProbeState(const Key& identity, const MountTable& table) :
+					identity(identity) {
+					// Mounts whose filter rules the identity out are left out.
+					auto& dataland = table.dataland;
+					mounts.reserve(dataland.size());
+					for (size_t position = dataland.size(); position-- > 0; ) {
+						if (table.may_contain(position, identity)) {
+							mounts.push_back(dataland[position]);
+						}
+					}
+					results.resize(mounts.size());
+					states.reset(new std::atomic<int>[mounts.size()]);
+					cutoff = mounts.size();
+					for (size_t rank = 0; rank < mounts.size(); ++rank) {
+						states[rank] = PENDING;
+					}
+				}
+
+				/// Runs the probe for `rank`, unless it has already been claimed.
+				void probe(size_t rank) {
+					int expected = PENDING;
+					if (!states[rank].compare_exchange_strong(expected, RUNNING)) {
+						return;
+					}
+					FilePointer file = nullptr;
+					if (rank < cutoff) {
+						file = mounts[rank]->get_file(identity);
+					}
+					if (file != nullptr) {
+						// Lower the cutoff (never raise it).
+						auto current = cutoff.load();
+						while (rank < current && !cutoff.compare_exchange_weak(current, rank)) {}
+					}
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						results[rank] = file;
+						states[rank] = DONE;
+					}
+					finished.notify_all();
+				}
+
+				/// Waits for `rank` to complete (running it here if unclaimed).
+				FilePointer await(size_t rank) {
+					probe(rank);
+					std::unique_lock<std::mutex> lock(mutex);
+					finished.wait(lock, [this, rank]() {
+						return states[rank] == DONE;
+					});
+					return results[rank];
+				}
+			};
+
+			/**
+			 * @brief Probes every mount concurrently.
+			 * @tparam Key      Owned identity type.
+			 * @param[in] table     Mount table (with a probe pool).
+			 * @param[in] identity  Identity to be found.
+			 * @param[out] owner    Mount which resolved the identity.
+			 * @return Pointer to a file (or nullptr on failure).
+			 *
+			 * The result is the one a serial walk would return: ranks are
+			 * settled in priority order, and a hit is only returned once
+			 * every higher-priority probe has missed.  The caller probes the
+			 * top mount itself (and any rank no pool thread has claimed yet),
+			 * so this cannot stall when the pool is busy.
+			 */
+			template<typename Key>
+			static FilePointer probe_dataland(const MountTable& table,
+				const Key& identity, FileSystemPointer& owner) {
+				auto state = std::make_shared<ProbeState<Key>>(identity, table);
+				for (size_t rank = 1; rank < state->mounts.size(); ++rank) {
+					table.probe_pool->submit([state, rank]() {
+						state->probe(rank);
+					});
+				}
+				for (size_t rank = 0; rank < state->mounts.size(); ++rank) {
+					auto file = state->await(rank);
+					if (file != nullptr) {
+						owner = state->mounts[rank];
+						return file;
+					}
+				}
+				owner = nullptr;
+				return nullptr;
+			}
+
+			/**
+			 * @brief Walks the dataland stack (top to bottom).
+			 * @param[in] table     Mount table to walk.
+			 * @param[in] identity  Identity to be found.
+			 * @param[out] owner    Mount which resolved the identity.
+			 * @param[out] stale    If given, receives indexed providers which no longer had the file.
+			 * @return Pointer to a file (or nullptr on failure).
+			 */
+			static FilePointer walk_dataland(const MountTable& table,
+				StringIdentity identity, FileSystemPointer& owner,
+				std::vector<FileSystemPointer>* stale = nullptr) {
+				if (table.indexed) {
+					return table.index.resolve(table.dataland, identity, owner, stale);
+				}
+				if (table.probe_pool != nullptr && table.dataland.size() > 1) {
+					return probe_dataland(table, std::string(identity), owner);
+				}
+				auto& dataland = table.dataland;
+				for (size_t position = dataland.size(); position-- > 0; ) {
+					if (!table.may_contain(position, identity)) {
+						continue;
+					}
+					auto file = dataland[position]->get_file(identity);
+					if (file != nullptr) {
+						owner = dataland[position];
+						return file;
+					}
+				}
+				owner = nullptr;
+				return nullptr;
+			}
+
+			/**
+			 * @brief Walks the dataland stack (top to bottom).
+			 * @param[in] table     Mount table to walk.
+			 * @param[in] identity  Identity to be found.
+			 * @param[out] owner    Mount which resolved the identity.
+			 * @param[out] stale    Unused.
+			 * @return Pointer to a file (or nullptr on failure).
+			 *
+			 * Hashed identities are not indexed, so this always probes.
+			 */
+			static FilePointer walk_dataland(const MountTable& table,
+				HashedIdentity identity, FileSystemPointer& owner,
+				std::vector<FileSystemPointer>* /*stale*/ = nullptr) {
+				if (table.probe_pool != nullptr && table.dataland.size() > 1) {
+					return probe_dataland(table, identity, owner);
+				}
+				auto& dataland = table.dataland;
+				for (size_t position = dataland.size(); position-- > 0; ) {
+					if (!table.may_contain(position, identity)) {
+						continue;
+					}
+					auto file = dataland[position]->get_file(identity);
+					if (file != nullptr) {
+						owner = dataland[position];
+						return file;
+					}
+				}
+				owner = nullptr;
+				return nullptr;
+			}
+
+			/**
+			 * @brief Resolves an identity using (and maintaining) a cache.
+			 * @param[in] cache     Cache for the identity type.
+			 * @param[in] identity  Identity to be found.
+			 * @return Pointer to a file (or nullptr on failure).
+			 *
+			 * A positive entry only probes the recorded mount; should that
+			 * probe fail (the file was removed) the stack is walked again.
+			 */
+			template<typename Cache, typename Key>
+			FilePointer resolve_dataland(Cache& cache, const Key& identity) {
+				FileSystemPointer owner = nullptr;
+				std::vector<FileSystemPointer> stale;
+				if (cache_capacity == 0) {
+					auto file = walk_dataland(*mounts.read(), identity, owner, &stale);
+					if (!stale.empty()) {
+						queue_repairs(identity, stale);
+					}
+					return file;
+				}
+				// The ticket is taken before the table is pinned: a change
+				// published in between then bumps the generation after it.
+				std::uint64_t ticket = 0;
+				if (find_cached(cache, identity, owner, ticket)) {
+					if (owner == nullptr) {
+						return nullptr;
+					}
+					auto file = owner->get_file(identity);
+					if (file != nullptr) {
+						return file;
+					}
+				}
+				auto file = walk_dataland(*mounts.read(), identity, owner, &stale);
+				if (!stale.empty()) {
+					queue_repairs(identity, stale);
+				}
+				store_cached(cache, identity, owner, ticket);
+				return file;
+			}
+
+			/**
+			 * @brief Queues index entries a look-up found to be stale.
+			 * @param[in] identity  Identity looked up.
+			 * @param[in] stale     Providers listed for it which confirmed it gone.
+			 *
+			 * Cached results were found by probing, so they are still right
+			 * until the repairs are applied.
+			 */
+			void queue_repairs(StringIdentity identity, const std::vector<FileSystemPointer>& stale) {
+				std::lock_guard<std::mutex> lock(repair_mutex);
+				auto& queued = repairs[identity];
+				for (auto& mount : stale) {
+					if (std::find(queued.begin(), queued.end(), mount) == queued.end()) {
+						queued.push_back(mount);
+					}
+				}
+			}
+
+			/// Hashed identities are not indexed (nothing to repair).
+			void queue_repairs(HashedIdentity, const std::vector<FileSystemPointer>&) {}
+
+			/**
+			 * @brief Applies (and clears) queued repairs to a table about to be published.
+			 * @param[in] table  Table being changed.
+			 *
+			 * Each entry is confirmed gone again first, as the file may have
+			 * come back since it was queued.  Called under the writer lock.
+			 */
+			void apply_repairs(MountTable& table) {
+				IdentityMap<std::vector<FileSystemPointer>> taken;
+				{
+					std::lock_guard<std::mutex> lock(repair_mutex);
+					if (repairs.empty()) {
+						return;
+					}
+					std::swap(taken, repairs);
+				}
+				if (!table.indexed) {
+					return;
+				}
+				for (auto& repair : taken) {
+					for (auto& mount : repair.second) {
+						if (table.position_of(mount.get()) < table.dataland.size() && mount->lacks(repair.first)) {
+							table.index.remove(repair.first, mount);
+						}
+					}
+				}
+			}
+
 		public:
 
 			/**
@@ -83,7 +552,10 @@ namespace reversingspace {
 			/**
 			 * @brief Virtual deconstructor.
 			 */
-			virtual ~StorageServer() {}
+			virtual ~StorageServer() {
+				// Watchers call back into this server; stop them first.
+				disable_watching();
+			}
 
 			/**
 			 * @brief Gets the userland directory pointer.
@@ -103,19 +575,36 @@ namespace reversingspace {
 			 * the value is pushed to the end.
 			 *
 			 * If the `mountable` argument is not valid (for the purposes of
-			 * being used as a `FileSystemPointer` in this context), the
-			 * insert will be aborted and false will be returned.
+			 * being used as a `FileSystemPointer` in this context), or the
+			 * server is sealed, the insert will be aborted and false will be
+			 * returned.
+			 *
+			 * The server's hash function (if any) is offered to the mount.
 			 */
 			bool mount(FileSystemPointer mountable, unsigned int position = -1) {
-				if (mountable == nullptr) {
+				if (mountable == nullptr || is_sealed()) {
 					return false;
 				}
-				if (position > dataland.size()) {
-					dataland.push_back(mountable);
-					return true;
+				if (hash_function != nullptr) {
+					mountable->offer_hash_function(hash_function);
 				}
-				dataland.insert(dataland.begin() + position, mountable);
-				return true;
+				std::lock_guard<std::mutex> guard(watch_mutex);
+				if (watching) {
+					watch_mount(mountable);
+				}
+				return publish([&mountable, position](MountTable& table) {
+					auto& dataland = table.dataland;
+					size_t slot = (position > dataland.size()) ? dataland.size() : position;
+					dataland.insert(dataland.begin() + slot, mountable);
+					if (table.filtered) {
+						table.filters.insert(table.filters.begin() + slot,
+							mountable->build_identity_filter());
+					}
+					if (table.indexed) {
+						table.index.insert(dataland, mountable);
+					}
+					return true;
+				});
 			}
 
 			/**
@@ -123,13 +612,7 @@ namespace reversingspace {
 			 * @param[in] mountable    Shared pointer to the mountable.
 			 */
 			void unmount(FileSystemPointer mountable) {
-				auto mountable_path = mountable->get_path();
-				for (auto mount = dataland.begin(); mount != dataland.end(); ++mount) {
-					if ((*mount)->get_path() == mountable_path) {
-						dataland.erase(mount);
-						return;
-					}
-				}
+				unmount(mountable->get_path());
 			}
 
 			/**
@@ -137,12 +620,469 @@ namespace reversingspace {
 			 * @param[in] mountable    Path to a mountable.
 			 */
 			void unmount(const std::filesystem::path& mountable_path) {
-				for (auto mount = dataland.begin(); mount != dataland.end(); ++mount) {
-					if ((*mount)->get_path() == mountable_path) {
-						dataland.erase(mount);
-						return;
+				std::lock_guard<std::mutex> guard(watch_mutex);
+				FileSystemPointer removed = nullptr;
+				publish([&mountable_path, &removed](MountTable& table) {
+					auto& dataland = table.dataland;
+					for (auto mount = dataland.begin(); mount != dataland.end(); ++mount) {
+						if ((*mount)->get_path() == mountable_path) {
+							removed = *mount;
+							if (table.filtered) {
+								table.filters.erase(table.filters.begin() + (mount - dataland.begin()));
+							}
+							dataland.erase(mount);
+							if (table.indexed) {
+								table.index.erase(removed);
+							}
+							return true;
+						}
+					}
+					return false;
+				});
+				// (Outside `publish`: stopping waits for the watcher's callback.)
+				if (watching && removed != nullptr) {
+					removed->unwatch();
+				}
+			}
+
+			/// Number of mounts in dataland.
+			size_t mount_count() const {
+				return mounts.read()->dataland.size();
+			}
+
+		private:
+			/**
+			 * @brief Publishes a modified mount table.
+			 * @param[in] change  Applied to a copy of the table; returns false to abandon it.
+			 * @return Result of `change` (false once sealed).
+			 *
+			 * Every published change invalidates the look-up cache, and
+			 * carries any queued index repairs.
+			 */
+			template<typename Function>
+			bool publish(Function&& change) {
+				bool changed = mounts.update([this, &change](MountTable& table) {
+					if (sealed.load() != nullptr || !change(table)) {
+						return false;
+					}
+					apply_repairs(table);
+					return true;
+				});
+				if (changed) {
+					invalidate_cache();
+				}
+				return changed;
+			}
+
+			/**
+			 * @brief Watches a mount, routing its changes to `apply_changes`.
+			 * @param[in] mountable  Mount to watch.
+			 * @return true if the mount can be watched.
+			 *
+			 * The caller holds `watch_mutex`.
+			 */
+			bool watch_mount(const FileSystemPointer& mountable) {
+				const FileSystem* key = mountable.get();
+				return mountable->watch([this, key](const DirectoryChanges& changes) {
+					apply_changes(key, changes);
+				});
+			}
+
+			/**
+			 * @brief Applies a batch of changes reported by a mount.
+			 * @param[in] key      Mount which changed.
+			 * @param[in] changes  Changes (coalesced).
+			 *
+			 * The merged index is updated per identity, the mount's filter is
+			 * rebuilt if identities appeared, and only the changed identities
+			 * are dropped from the look-up cache.
+			 */
+			void apply_changes(const FileSystem* key, const DirectoryChanges& changes) {
+				bool rescan = false;
+				bool added = false;
+				for (auto& change : changes) {
+					rescan = rescan || (change.kind == DirectoryChange::Kind::Rescan);
+					added = added || (change.kind == DirectoryChange::Kind::Added);
+				}
+
+				FileSystemPointer mountable = nullptr;
+				bool indexed = false;
+				bool filtered = false;
+				{
+					auto table = mounts.read();
+					auto position = table->position_of(key);
+					if (position < table->dataland.size()) {
+						mountable = table->dataland[position];
+						indexed = table->indexed;
+						filtered = table->filtered;
+					}
+				}
+
+				if (mountable != nullptr && (indexed || (filtered && (added || rescan)))) {
+					// Built outside the update, as it enumerates the mount.
+					IdentityFilterPointer filter = nullptr;
+					if (filtered && (added || rescan)) {
+						filter = mountable->build_identity_filter();
+					}
+					mounts.update([&](MountTable& table) {
+						if (sealed.load() != nullptr) {
+							return false;
+						}
+						auto position = table.position_of(key);
+						if (position == table.dataland.size()) {
+							return false; // Unmounted meanwhile.
+						}
+						if (table.filtered && (added || rescan)) {
+							table.filters[position] = filter;
+						}
+						if (table.indexed) {
+							if (rescan) {
+								table.index.erase(mountable);
+								table.index.insert(table.dataland, mountable);
+							} else {
+								for (auto& change : changes) {
+									if (change.kind == DirectoryChange::Kind::Added) {
+										table.index.add(table.dataland, change.identity, mountable);
+									} else if (change.kind == DirectoryChange::Kind::Removed) {
+										table.index.remove(change.identity, mountable);
+									}
+								}
+							}
+						}
+						apply_repairs(table);
+						return true;
+					});
+				}
+
+				// After the table: resolutions begun before this are dropped.
+				if (rescan) {
+					invalidate_cache();
+					return;
+				}
+				std::unique_lock lock(cache_mutex);
+				++cache_generation;
+				for (auto& change : changes) {
+					if (change.kind == DirectoryChange::Kind::Modified) {
+						continue; // Still resolves to the same mount.
+					}
+					resolution_cache.erase(change.identity);
+					if (hash_function != nullptr) {
+						hashed_resolution_cache.erase(hash_function(change.identity));
+					}
+				}
+			}
+
+			/**
+			 * @brief Runs a query on userland and every mount, merged by priority.
+			 * @param[in] query     Runs the query on one filesystem.
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if a filesystem cannot answer.
+			 */
+			template<typename Query>
+			bool query_mounts(const Query& query, const EnumerationFunction& callback) {
+				IdentityMap<bool> seen;
+				EnumerationFunction unique = [&seen, &callback](StringIdentity name) {
+					if (seen.count(name) == 0) {
+						seen[name] = true;
+						callback(name);
+					}
+				};
+				if (userland != nullptr && !query(*userland, unique)) {
+					return false;
+				}
+				auto table = mounts.read();
+				auto& dataland = table->dataland;
+				for (auto mount = dataland.rbegin(); mount != dataland.rend(); ++mount) {
+					if (!query(**mount, unique)) {
+						return false;
 					}
 				}
+				return true;
+			}
+
+		public: // Merged index
+			/**
+			 * @brief Builds a merged index over the dataland stack.
+			 *
+			 * Every mount is enumerated once; string look-ups then go straight
+			 * to the mount(s) providing the identity rather than probing each
+			 * mount in turn.  Mounts which cannot be enumerated are still
+			 * probed in place, so priority is unchanged.
+			 *
+			 * Once built, the index is updated incrementally by `mount` and
+			 * `unmount`.  Like the look-up cache it does not notice changes
+			 * on disk (short of watching); call `build_index` again to
+			 * refresh it.  Entries for files removed meanwhile are queued
+			 * for removal as look-ups miss them (see `repair_index`).
+			 */
+			void build_index() {
+				publish([](MountTable& table) {
+					table.index.build(table.dataland);
+					table.indexed = true;
+					return true;
+				});
+			}
+
+			/// Drops the merged index (returning to probing every mount).
+			void drop_index() {
+				publish([](MountTable& table) {
+					table.index.clear();
+					table.indexed = false;
+					return true;
+				});
+			}
+
+			/// Returns true if the merged index is in use.
+			bool is_indexed() const {
+				return mounts.read()->indexed;
+			}
+
+			/**
+			 * @brief Applies the index repairs look-ups have queued.
+			 * @return false if none were queued (or the server is sealed).
+			 *
+			 * A look-up which finds an indexed file confirmed gone (removed
+			 * while its mount was not watched) queues the entry for removal
+			 * rather than publishing a table from the read path.  Queued
+			 * repairs are applied by the next change to the mounts, or here.
+			 */
+			bool repair_index() {
+				{
+					std::lock_guard<std::mutex> lock(repair_mutex);
+					if (repairs.empty()) {
+						return false;
+					}
+				}
+				return publish([](MountTable&) {
+					return true;
+				});
+			}
+
+			/// Default name of the saved index (in userland).
+			static constexpr const char* DEFAULT_INDEX_NAME = "mounts.index";
+
+			/**
+			 * @brief Saves the merged index to userland.
+			 * @param[in] name  File name (in userland).
+			 * @return false if there is no index or userland, or writing failed.
+			 *
+			 * Load it on a later start (`load_index`) to skip enumerating
+			 * every mount.
+			 */
+			bool save_index(const std::string& name = DEFAULT_INDEX_NAME) {
+				if (userland == nullptr) {
+					return false;
+				}
+				auto table = mounts.read();
+				if (!table->indexed) {
+					return false;
+				}
+				return table->index.save(table->dataland, userland->get_path() / name);
+			}
+
+			/**
+			 * @brief Loads a merged index saved by `save_index`.
+			 * @param[in] name  File name (in userland).
+			 * @return false if the file is missing or malformed, or was saved for other mounts.
+			 *
+			 * The file is mapped and used in place, so look-ups work at once.
+			 * Mounts are only checked against their saved stamps (for a
+			 * directory, the modification times of its directories); one
+			 * which changed is probed in place, as if it could not be
+			 * enumerated, until `build_index` is called again.  Entries found
+			 * stale by a look-up are dropped as they are met.
+			 */
+			bool load_index(const std::string& name = DEFAULT_INDEX_NAME) {
+				if (userland == nullptr) {
+					return false;
+				}
+				auto file = MountIndexFile::open(userland->get_path() / name);
+				if (file == nullptr) {
+					return false;
+				}
+				// Stamps are checked before publishing (the writer lock is not held).
+				std::vector<FileSystemPointer> dataland = mounts.read()->dataland;
+				MountIndex loaded;
+				if (!loaded.load(dataland, file)) {
+					return false;
+				}
+				return publish([&dataland, &loaded](MountTable& table) {
+					if (table.dataland != dataland) {
+						return false;
+					}
+					table.index = std::move(loaded);
+					table.indexed = true;
+					return true;
+				});
+			}
+
+		public: // Mount filters
+			/**
+			 * @brief Builds an identity filter for every mount.
+			 *
+			 * Each mount is asked for a filter (`build_identity_filter`: 10
+			 * bits per identity, 20 for a mount which also covers hashed
+			 * identities, such as a `Directory` offered the server's hash
+			 * function); look-ups then skip mounts which definitely
+			 * lack the identity instead of calling `get_file` on them.  Mounts
+			 * added later get a filter as they are mounted.  Mounts which
+			 * cannot build one are always probed.
+			 *
+			 * Like the merged index, filters do not notice files appearing
+			 * on disk; call `build_mount_filters` again to refresh them.
+			 */
+			void build_mount_filters() {
+				publish([](MountTable& table) {
+					table.filters.clear();
+					for (auto& mount : table.dataland) {
+						table.filters.push_back(mount->build_identity_filter());
+					}
+					table.filtered = true;
+					return true;
+				});
+			}
+
+			/// Drops the mount filters (probing every mount again).
+			void drop_mount_filters() {
+				publish([](MountTable& table) {
+					table.filters.clear();
+					table.filtered = false;
+					return true;
+				});
+			}
+
+			/// Returns true if mount filters are in use.
+			bool is_filtered() const {
+				return mounts.read()->filtered;
+			}
+
+		public: // Change notifications
+			/**
+			 * @brief Watches every mount for changes.
+			 * @return false if no mount could be watched.
+			 *
+			 * Mounts which support it (`Directory`, on Linux) report batches
+			 * of changes from a background thread; the merged index, mount
+			 * filters and look-up cache are then updated incrementally, so
+			 * they stay valid without rescans.  Mounts added later are
+			 * watched as they are mounted.
+			 *
+			 * Intended for development builds, where content changes under a
+			 * running game.  A mount reports to one owner at a time.  A sealed
+			 * server does not watch.
+			 */
+			bool enable_watching() {
+				if (is_sealed()) {
+					return false;
+				}
+				std::lock_guard<std::mutex> guard(watch_mutex);
+				watching = true;
+				bool any = false;
+				// Copied: (re)watching waits on callbacks, which publish changes.
+				auto dataland = mounts.read()->dataland;
+				for (auto& mount : dataland) {
+					any = watch_mount(mount) || any;
+				}
+				return any;
+			}
+
+			/// Stops watching mounts.
+			void disable_watching() {
+				std::lock_guard<std::mutex> guard(watch_mutex);
+				if (!watching) {
+					return;
+				}
+				watching = false;
+				// Copied: unwatching waits on callbacks, which publish changes.
+				auto dataland = mounts.read()->dataland;
+				for (auto& mount : dataland) {
+					mount->unwatch();
+				}
+			}
+
+			/// Returns true if mounts are watched for changes.
+			bool is_watching() {
+				std::lock_guard<std::mutex> guard(watch_mutex);
+				return watching;
+			}
+
+		public: // Sealing
+			/**
+			 * @brief Freezes dataland into one flat look-up table.
+			 * @return false if already sealed, or a mount cannot be enumerated.
+			 *
+			 * For shipping builds, where the mounts never change after boot.
+			 * Every mount is enumerated once (top down) into a `SealedTable`,
+			 * which string look-ups then use instead of the mount table: no
+			 * snapshot is pinned, no cache is consulted, and only the owning
+			 * mount is asked for the file.  Userland is unaffected.
+			 *
+			 * Sealing is final.  Afterwards every change to dataland is
+			 * rejected: `mount` returns false, `unmount` and the index,
+			 * filter and probing calls do nothing, and watching cannot be
+			 * enabled.  (Disable watching before sealing; changes it reports
+			 * are ignored.)  Content is assumed not to change on disk: an
+			 * identity resolves only from the mount which listed it.  Hashed
+			 * look-ups still probe, as hashed identities cannot be listed.
+			 */
+			bool seal() {
+				// Under the writer lock, so no change slips in mid-build;
+				// the mount table itself is left as it is (and not copied).
+				return mounts.exclusive([this](const MountTable& table) {
+					if (sealed.load() != nullptr) {
+						return false;
+					}
+					auto table_built = SealedTable::build(table.dataland);
+					if (table_built == nullptr) {
+						return false;
+					}
+					sealed_table = table_built;
+					sealed.store(table_built.get());
+					return true;
+				});
+			}
+
+			/// Returns true once the server is sealed.
+			bool is_sealed() const {
+				return sealed.load() != nullptr;
+			}
+
+		public: // Parallel probing
+			/**
+			 * @brief Probes mounts concurrently on (cold) look-ups.
+			 * @param[in] pool  Pool to run probes on (nullptr creates one).
+			 *
+			 * Without the merged index a miss walks every mount in turn, so
+			 * on a slow disk its latency is the sum of every probe.  With
+			 * this enabled the probes overlap; the winning mount is exactly
+			 * the one the serial walk would pick.  Indexed string look-ups
+			 * are unaffected (they already go to the providing mount).
+			 *
+			 * Each parallel look-up costs a few allocations and a hand-off to
+			 * the pool, so this pays off on slow storage and deep stacks, and
+			 * pairs well with the look-up cache.
+			 */
+			void enable_parallel_probing(WorkerPoolPointer pool = nullptr) {
+				if (pool == nullptr) {
+					pool = WorkerPool::create();
+				}
+				publish([&pool](MountTable& table) {
+					table.probe_pool = pool;
+					return true;
+				});
+			}
+
+			/// Returns to probing mounts one at a time.
+			void disable_parallel_probing() {
+				publish([](MountTable& table) {
+					table.probe_pool = nullptr;
+					return true;
+				});
+			}
+
+			/// Returns true if mounts are probed in parallel.
+			bool is_probing_in_parallel() const {
+				return mounts.read()->probe_pool != nullptr;
 			}
 
 			/**
@@ -155,14 +1095,7 @@ namespace reversingspace {
 			 * it will fail, regardless of whether it exists there or not.
 			 */
 			virtual FilePointer get_dataland_file(HashedIdentity identity) {
-				FilePointer file = nullptr;
-				for (auto mount = dataland.rbegin(); mount != dataland.rend(); ++mount) {
-					file = (*mount)->get_file(identity);
-					if (file != nullptr) {
-						break;
-					}
-				}
-				return file;
+				return resolve_dataland(hashed_resolution_cache, identity);
 			}
 
 			/**
@@ -175,17 +1108,30 @@ namespace reversingspace {
 			 * it will fail, regardless of whether it exists there or not.
 			 */
 			virtual FilePointer get_dataland_file(StringIdentity identity) {
-				FilePointer file = nullptr;
-				for (auto mount = dataland.rbegin(); mount != dataland.rend(); ++mount) {
-					file = (*mount)->get_file(identity);
+				auto table = sealed.load(std::memory_order_acquire);
+				auto file = (table != nullptr)
+					? table->get_file(identity)
+					: resolve_dataland(resolution_cache, identity);
+				if (file != nullptr || hash_function == nullptr) {
+					return file;
+				}
+
+				// Retried hashed, on the mounts whose hashed look-ups can
+				// find more than their string ones (not `Directory`, whose
+				// hash index would be built just to miss again).
+				auto hashed_identity = hash_function(identity);
+				auto mounted = mounts.read();
+				auto& dataland = mounted->dataland;
+				for (size_t position = dataland.size(); position-- > 0; ) {
+					if (!dataland[position]->resolves_unlisted_hashes() ||
+						!mounted->may_contain(position, hashed_identity)) {
+						continue;
+					}
+					file = dataland[position]->get_file(hashed_identity);
 					if (file != nullptr) {
 						return file;
 					}
 				}
-				if (hash_function != nullptr) {
-					auto hashed_identity = hash_function(identity);
-					return get_dataland_file(hashed_identity);
-				}
 				return nullptr;
 			}
 
@@ -204,7 +1150,138 @@ namespace reversingspace {
 				return userland->get_file(identity, access);
 			}
 
+		public: // Look-up cache
+			/// Default number of entries kept by the look-up cache.
+			static const size_t DEFAULT_CACHE_CAPACITY = 64 * 1024;
+
+			/**
+			 * @brief Enables (or disables) the dataland look-up cache.
+			 * @param[in] capacity  Maximum entries per cache (zero disables it).
+			 *
+			 * The cache maps identities to the mount which resolved them,
+			 * including misses (negative entries), so repeated look-ups stop
+			 * walking every mount.  It is disabled by default as it will not
+			 * notice files appearing on disk; call `invalidate_cache` when
+			 * the underlying content changes.
+			 *
+			 * Mounting and unmounting always invalidate the cache.
+			 */
+			void enable_cache(size_t capacity = DEFAULT_CACHE_CAPACITY) {
+				std::unique_lock lock(cache_mutex);
+				++cache_generation;
+				cache_capacity = capacity;
+				resolution_cache.clear();
+				hashed_resolution_cache.clear();
+			}
+
+			/// Disables the dataland look-up cache (dropping its contents).
+			void disable_cache() {
+				enable_cache(0);
+			}
+
+			/**
+			 * @brief Drops every cached resolution.
+			 */
+			void invalidate_cache() {
+				std::unique_lock lock(cache_mutex);
+				++cache_generation;
+				resolution_cache.clear();
+				hashed_resolution_cache.clear();
+			}
+
+			/**
+			 * @brief Drops the cached resolution of a single identity.
+			 * @param[in] identity  Identity which has changed on disk.
+			 *
+			 * This is intended to be driven by change notifications.  The
+			 * hashed entry is dropped too (when a hash function is present).
+			 */
+			void invalidate_cache(StringIdentity identity) {
+				std::unique_lock lock(cache_mutex);
+				++cache_generation;
+				resolution_cache.erase(identity);
+				if (hash_function != nullptr) {
+					hashed_resolution_cache.erase(hash_function(identity));
+				}
+			}
+
+			/**
+			 * @brief Drops the cached resolution of a single hashed identity.
+			 * @param[in] identity  Identity which has changed.
+			 */
+			void invalidate_cache(HashedIdentity identity) {
+				std::unique_lock lock(cache_mutex);
+				++cache_generation;
+				hashed_resolution_cache.erase(identity);
+			}
+
 		public: // FileSystem
+			/**
+			 * @brief Enumerates userland and dataland (once per identity).
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if a mount cannot be enumerated.
+			 */
+			bool enumerate(const EnumerationFunction& callback) {
+				IdentityMap<bool> seen;
+				auto unique = [&seen, &callback](StringIdentity name) {
+					if (seen.count(name) == 0) {
+						seen[name] = true;
+						callback(name);
+					}
+				};
+				if (userland != nullptr && !userland->enumerate(unique)) {
+					return false;
+				}
+				if (auto sealed_view = sealed.load(std::memory_order_acquire)) {
+					sealed_view->for_each(unique);
+					return true;
+				}
+				auto table = mounts.read();
+				if (table->indexed) {
+					return table->index.enumerate(unique);
+				}
+				auto& dataland = table->dataland;
+				for (auto mount = dataland.rbegin(); mount != dataland.rend(); ++mount) {
+					if (!(*mount)->enumerate(unique)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/**
+			 * @brief Enumerates the identities starting with `prefix`, across every mount.
+			 * @param[in] prefix    Prefix (e.g. "shaders/").
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if a mount cannot be enumerated.
+			 *
+			 * Each mount answers from its own index where it keeps one (see
+			 * `Directory::enumerate_prefix`), so this does not touch the disk
+			 * once those are built.  Identities are reported in priority
+			 * order: userland, then dataland from the top mount down (each
+			 * mount's in sorted order), an identity only for the mount which
+			 * would resolve it.
+			 */
+			bool enumerate_prefix(StringIdentity prefix, const EnumerationFunction& callback) {
+				return query_mounts([prefix](FileSystem& mount, const EnumerationFunction& unique) {
+					return mount.enumerate_prefix(prefix, unique);
+				}, callback);
+			}
+
+			/**
+			 * @brief Enumerates the identities matching a glob pattern, across every mount.
+			 * @param[in] pattern   Pattern (see `GlobPattern`), e.g. "**.lua".
+			 * @param[in] callback  Function called once per identity.
+			 * @return false if a mount cannot be enumerated.
+			 *
+			 * See `enumerate_prefix`.
+			 */
+			bool enumerate_glob(StringIdentity pattern, const EnumerationFunction& callback) {
+				return query_mounts([pattern](FileSystem& mount, const EnumerationFunction& unique) {
+					return mount.enumerate_glob(pattern, unique);
+				}, callback);
+			}
+
 			/**
 			 * @brief Gets a file from the underlying filesystem.
 			 * @param[in] identity  Hashed identity of the file.
@@ -236,15 +1313,8 @@ namespace reversingspace {
 				if (file != nullptr) {
 					return file;
 				}
-				file = get_dataland_file(identity);
-				if (file != nullptr) {
-					return file;
-				}
-				if (hash_function != nullptr) {
-					auto hashed_identity = hash_function(identity);
-					file = get_dataland_file(hashed_identity);
-				}
-				return file;
+				// This falls back to the hashed identity internally.
+				return get_dataland_file(identity);
 			}
 
 		public: // Helper
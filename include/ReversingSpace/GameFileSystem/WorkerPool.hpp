@@ -0,0 +1,166 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#ifndef REVERSINGSPACE_GAMEFILESYSTEM_WORKERPOOL_HPP
+#define REVERSINGSPACE_GAMEFILESYSTEM_WORKERPOOL_HPP
+
+#include <ReversingSpace/GameFileSystem/Core.hpp>
+
+// std::atomic
+#include <atomic>
+
+// std::condition_variable
+#include <condition_variable>
+
+// std::deque
+#include <deque>
+
+// std::function
+#include <functional>
+
+// std::mutex
+#include <mutex>
+
+// std::thread
+#include <thread>
+
+// std::vector
+#include <vector>
+
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable: 4251)
+#endif//defined(_MSC_VER)
+
+namespace reversingspace {
+	namespace gfs {
+		// Forward for `WorkerPool`.
+		class WorkerPool;
+
+		/// Shared pointer type for `WorkerPool`.
+		using WorkerPoolPointer = std::shared_ptr<WorkerPool>;
+
+		/**
+		 * @brief Fixed set of threads running queued tasks.
+		 *
+		 * Tasks run in submission order (first in, first out).  Callers
+		 * which wait on their own tasks should be prepared to run them
+		 * inline if they have not started, as a pool thread may itself be
+		 * the caller.
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API WorkerPool {
+		private:
+			/// Worker threads.
+			std::vector<std::thread> threads;
+
+			/// Pending tasks.
+			std::deque<std::function<void()>> tasks;
+
+			/// Guards `tasks` and `stopping`.
+			std::mutex mutex;
+
+			/// Signalled when a task is queued (or the pool stops).
+			std::condition_variable available;
+
+			/// Set by the destructor.
+			bool stopping = false;
+
+			/// Worker thread body.
+			void run();
+
+		public:
+			/**
+			 * @brief Starts a pool.
+			 * @param[in] thread_count  Number of threads (zero picks one per hardware thread).
+			 */
+			explicit WorkerPool(size_t thread_count = 0);
+
+			/// Runs the remaining tasks, then joins every thread.
+			~WorkerPool();
+
+			WorkerPool(const WorkerPool&) = delete;
+			WorkerPool& operator=(const WorkerPool&) = delete;
+
+			/**
+			 * @brief Queues a task.
+			 * @param[in] task  Task to be run on a pool thread.
+			 */
+			void submit(std::function<void()> task);
+
+			/// Number of threads in the pool.
+			size_t size() const {
+				return threads.size();
+			}
+
+			/**
+			 * @brief Helper to construct a pool.
+			 * @param[in] thread_count  Number of threads (zero picks one per hardware thread).
+			 */
+			inline static WorkerPoolPointer create(size_t thread_count = 0) {
+				return std::make_shared<WorkerPool>(thread_count);
+			}
+		};
+
+		/**
+		 * @brief Runs `task(i)` for every `i` below `count`, on a pool and the caller.
+		 *
+		 * Helpers start on construction, and iterations are claimed one at
+		 * a time, so uneven iterations balance themselves; `finish` has
+		 * the caller take its share and waits for helpers still running.
+		 * Helpers which start after that find the loop closed and leave,
+		 * so the caller never waits for one which has not been scheduled
+		 * (and a pool thread may run a loop of its own).
+		 */
+		class REVSPACE_GAMEFILESYSTEM_API ParallelLoop {
+		private:
+			/// Shared with the helpers (which may outlive the loop).
+			struct State {
+				std::function<void(size_t)> task;
+				size_t count = 0;
+				std::atomic<size_t> next{ 0 };
+				std::mutex mutex;
+				std::condition_variable idle;
+				size_t active = 0;
+				bool closed = false;
+
+				/// Runs iterations until none are left.
+				void work();
+			};
+
+			std::shared_ptr<State> state;
+
+		public:
+			/**
+			 * @brief Starts a loop.
+			 * @param[in] pool   Pool to help on (nullptr: the caller runs every iteration).
+			 * @param[in] count  Number of iterations.
+			 * @param[in] task   Iteration body (called concurrently).
+			 */
+			ParallelLoop(WorkerPool* pool, size_t count, std::function<void(size_t)> task);
+
+			/// Finishes the loop.
+			~ParallelLoop();
+
+			ParallelLoop(const ParallelLoop&) = delete;
+			ParallelLoop& operator=(const ParallelLoop&) = delete;
+
+			/// Runs the remaining iterations and waits for the helpers.
+			void finish();
+		};
+	}
+}
+
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif//defined(_MSC_VER)
+
+#endif//REVERSINGSPACE_GAMEFILESYSTEM_WORKERPOOL_HPP
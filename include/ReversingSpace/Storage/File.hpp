@@ -21,6 +21,9 @@
 // API
 #include <ReversingSpace/Storage/Core.hpp>
 
+// std::unique_lock
+#include <mutex>
+
 // std::shared_mutex
 #include <shared_mutex>
 
@@ -109,6 +112,18 @@ namespace reversingspace {
 			 */
 			bool flush();
 
+			/**
+			 * @brief Asks the system to start reading part of the view in.
+			 * @param[in] offset  Offset within the view.
+			 * @param[in] size    Number of bytes (clamped to the view).
+			 * @return false if the hint could not be given (it is only a hint).
+			 *
+			 * Returns at once: the pages are read in the background, so a
+			 * caller can work on data already resident while the next
+			 * range arrives.
+			 */
+			bool prefetch(StorageSize offset, StorageSize size);
+
 			/**
 			 * Sets the cursor position.
 			 *
@@ -314,16 +329,54 @@ namespace reversingspace {
 			 */
 			FileAccess access;
 
+			/**
+			 * @brief Size at open (read-only files only; see `size_cached`).
+			 *
+			 * A read-only file cannot be resized through this object, so the
+			 * size found when validating the open is kept.
+			 */
+			StorageSize cached_size = 0;
+
+			/**
+			 * @brief Whether `cached_size` is used by `get_size`.
+			 */
+			bool size_cached = false;
+
 		private:
 			/**
 			 * @brief Internal, platform-specific, open code.
 			 *
+			 * This is a single open of `path`, validated on the handle:
+			 * read-only opens fail unless it is a regular file (and cache its
+			 * size), and creating opens make missing parent directories.
+			 *
 			 * Delete the file object if you no longer need it rather than
 			 * hacking access to `open` and `closed`; messing with open state
 			 * while it is mapped will lead to madness.
 			 */
 			bool open();
 
+			/**
+			 * @brief Internal, platform-specific, check of a fresh handle.
+			 * @return false (closing the handle) if the open failed or is unusable.
+			 */
+			bool validate_open();
+
+			/**
+			 * @brief Internal, platform-specific, size query on the handle.
+			 */
+			StorageSize query_size() const;
+
+			/**
+			 * @brief Internal, platform-specific, open relative to a directory.
+			 * @param[in] directory  Handle on an open directory.
+			 * @param[in] name       Path relative to `directory`.
+			 *
+			 * Validated as `open` is (but parent directories are not made).
+			 * Not supported on Windows (always fails).
+			 */
+			bool open_at(PlatformFileHandle directory, const char* name);
+
 			/**
 			 * @brief Internal, platform-specific, shutdown/deconstruction code.
 			 *
@@ -353,10 +406,9 @@ namespace reversingspace {
 			/**
 			 * @brief Gets the size of the underlying file object.
 			 *
-			 * At this time this uses std::filesystem to achieve its task;
-			 * this could likely be updated to use platform specific code
-			 * though the need for the performance gain here is questionable
-			 * at best.
+			 * Read-only files report the size found at open; others ask the
+			 * open handle, so this does not depend on the path still naming
+			 * the file.
 			 **/
 			StorageSize get_size() const;
 
@@ -379,9 +431,27 @@ namespace reversingspace {
 			 * @brief Creates a `File` object.
 			 *
 			 * This is not a constructor as the creation of the code
+			 *
+			 * The path is kept by the `File`; it is moved in, so callers
+			 * which built it for this call should pass an rvalue.
 			 */
-			static FilePointer create(const std::filesystem::path& path,
+			static FilePointer create(std::filesystem::path path,
 				FileAccess access = FileAccess::Read);
+
+			/**
+			 * @brief Creates a `File` object relative to an open directory.
+			 * @param[in] directory  Handle on an open directory.
+			 * @param[in] name       Path relative to `directory` (null terminated).
+			 * @param[in] path       Full path of the file (moved in on success, for `get_path`; untouched on failure).
+			 * @param[in] access     Access mode.
+			 * @return Pointer to the file, or nullptr on failure.
+			 *
+			 * Only the components of `name` are resolved by the kernel, and
+			 * missing parent directories are not created.  Not supported on
+			 * Windows (always nullptr).
+			 */
+			static FilePointer create_at(PlatformFileHandle directory, const char* name,
+				std::filesystem::path&& path, FileAccess access = FileAccess::Read);
         };
     }
 }
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the Linux (getdents64) listing.
+#if defined(__linux__)
+
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+
+#include <cerrno>
+#include <cstddef>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Kernel record returned by `getdents64` (glibc does not declare it).
+			struct linux_dirent64 {
+				std::uint64_t d_ino;
+				std::int64_t d_off;
+				unsigned short d_reclen;
+				unsigned char d_type;
+				char d_name[256];
+			};
+
+			/// Maps a `st_mode`/`stx_mode` to an entry type.
+			EntryType type_of_mode(unsigned mode) {
+				switch (mode & S_IFMT) {
+					case S_IFREG: return EntryType::File;
+					case S_IFDIR: return EntryType::Directory;
+					default: return EntryType::Other;
+				}
+			}
+
+			/**
+			 * @brief Stats an entry relative to its directory (following links).
+			 * @return false if the entry could not be stat'd.
+			 */
+			bool stat_entry(int directory, const char* name, EntryType& type,
+				std::uint64_t& size, std::int64_t& modified) {
+#if defined(STATX_TYPE)
+				struct statx status;
+				if (::statx(directory, name, AT_STATX_DONT_SYNC,
+					STATX_TYPE | STATX_SIZE | STATX_MTIME, &status) != 0) {
+					return false;
+				}
+				type = type_of_mode(status.stx_mode);
+				size = status.stx_size;
+				modified = (std::int64_t)status.stx_mtime.tv_sec * 1000000000 + status.stx_mtime.tv_nsec;
+#else
+				struct stat status;
+				if (::fstatat(directory, name, &status, 0) != 0) {
+					return false;
+				}
+				type = type_of_mode(status.st_mode);
+				size = (std::uint64_t)status.st_size;
+				modified = (std::int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif//defined(STATX_TYPE)
+				return true;
+			}
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_directory(const std::filesystem::path& path) {
+			int directory = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			return (directory == -1) ? INVALID_DIRECTORY : (DirectoryHandle)directory;
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_child(DirectoryHandle parent, const char* name) {
+			int directory = ::openat((int)parent, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			return (directory == -1) ? INVALID_DIRECTORY : (DirectoryHandle)directory;
+		}
+
+		void DirectoryListing::close_directory(DirectoryHandle directory) {
+			::close((int)directory);
+		}
+
+		bool DirectoryListing::identify(DirectoryHandle directory, const std::filesystem::path& path,
+			const std::string& prefix, DirectoryId& id) {
+			(void)path;
+			(void)prefix;
+			struct stat status;
+			if (::fstat((int)directory, &status) != 0) {
+				return false;
+			}
+			id.device = (std::uint64_t)status.st_dev;
+			id.inode = (std::uint64_t)status.st_ino;
+			return true;
+		}
+
+		bool DirectoryListing::read(DirectoryHandle handle, const std::filesystem::path& path,
+			const std::string& prefix, bool metadata) {
+			// Everything is read through (and stat'd relative to) the handle.
+			(void)path;
+			int directory = (int)handle;
+
+			// Large enough for several hundred entries per call.
+			alignas(struct linux_dirent64) char buffer[32 * 1024];
+			for (;;) {
+				long length = ::syscall(SYS_getdents64, directory, buffer, sizeof(buffer));
+				if (length < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return false;
+				}
+				if (length == 0) {
+					break;
+				}
+				for (long offset = 0; offset < length; ) {
+					auto record = (const struct linux_dirent64*)(buffer + offset);
+					offset += record->d_reclen;
+
+					const char* name = record->d_name;
+					if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+						continue;
+					}
+
+					EntryType type = EntryType::Unknown;
+					switch (record->d_type) {
+						case DT_REG: type = EntryType::File; break;
+						case DT_DIR: type = EntryType::Directory; break;
+						case DT_LNK: case DT_UNKNOWN: break; // Needs a stat.
+						default: type = EntryType::Other; break;
+					}
+
+					std::uint64_t size = 0;
+					std::int64_t modified = 0;
+					if (metadata || type == EntryType::Unknown) {
+						EntryType stat_type;
+						if (stat_entry(directory, name, stat_type, size, modified)) {
+							type = stat_type;
+						}
+					}
+					add(prefix, name, type, size, modified);
+				}
+			}
+			return true;
+		}
+	}
+}
+
+#endif//defined(__linux__)
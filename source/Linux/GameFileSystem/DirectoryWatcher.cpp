@@ -0,0 +1,267 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the Linux (inotify) watcher.
+#if defined(__linux__)
+
+#include <ReversingSpace/GameFileSystem/DirectoryWatcher.hpp>
+
+#include <cerrno>
+#include <unordered_map>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Events watched on every directory.
+			const std::uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_CLOSE_WRITE
+				| IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+		}
+
+		struct DirectoryWatcher::Platform {
+			/// inotify descriptor.
+			int inotify = -1;
+
+			/// eventfd used to stop the background thread.
+			int wake = -1;
+
+			/// Watch descriptor -> relative prefix ("" for the root, else "a/b/").
+			std::unordered_map<int, std::string> prefixes;
+
+			/// Pending changes (coalesced) and the order they first appeared in.
+			std::unordered_map<std::string, DirectoryChange::Kind> pending;
+			std::vector<std::string> order;
+
+			~Platform() {
+				if (inotify != -1) {
+					::close(inotify);
+				}
+				if (wake != -1) {
+					::close(wake);
+				}
+			}
+
+			/**
+			 * @brief Records a change, merging it with a pending one.
+			 *
+			 * The latest kind wins, except that a modification does not hide
+			 * an appearance (or a reappearance) within the same batch.
+			 */
+			void record(DirectoryChange::Kind kind, const std::string& identity) {
+				auto entry = pending.find(identity);
+				if (entry == pending.end()) {
+					pending.emplace(identity, kind);
+					order.push_back(identity);
+					return;
+				}
+				if (kind == DirectoryChange::Kind::Modified &&
+					entry->second != DirectoryChange::Kind::Modified) {
+					if (entry->second == DirectoryChange::Kind::Removed) {
+						entry->second = DirectoryChange::Kind::Added;
+					}
+					return;
+				}
+				entry->second = kind;
+			}
+
+			/**
+			 * @brief Watches a directory and every directory below it.
+			 * @param[in] prefix    Relative prefix of `path` ("" or ending in '/').
+			 * @param[in] path      Full path of the directory.
+			 * @param[in] announce  Report the files found as `Added`.
+			 * @return false if `path` itself could not be watched.
+			 *
+			 * Files created before a new directory's watch existed would be
+			 * missed, so new directories are scanned (`announce`) after their
+			 * watches are in place.
+			 */
+			bool add_tree(const std::string& prefix, const std::filesystem::path& path, bool announce) {
+				int wd = inotify_add_watch(inotify, path.c_str(), WATCH_MASK);
+				if (wd < 0) {
+					return false;
+				}
+				prefixes[wd] = prefix;
+
+				// Symlinked directories are not followed: a link back into
+				// the tree would get an existing watch (and rename it).
+				std::error_code error;
+				std::filesystem::recursive_directory_iterator entry(path,
+					std::filesystem::directory_options::skip_permission_denied, error);
+				for (; !error && entry != std::filesystem::recursive_directory_iterator(); entry.increment(error)) {
+					std::error_code status_error;
+					auto relative = prefix + entry->path().lexically_relative(path).generic_string();
+					if (entry->is_symlink(status_error) && entry->is_directory(status_error)) {
+						continue;
+					}
+					if (entry->is_directory(status_error)) {
+						int child = inotify_add_watch(inotify, entry->path().c_str(), WATCH_MASK);
+						if (child >= 0) {
+							prefixes[child] = relative + "/";
+						}
+					} else if (announce && entry->is_regular_file(status_error)) {
+						record(DirectoryChange::Kind::Added, relative);
+					}
+				}
+				return true;
+			}
+
+			/// Applies a buffer of inotify events.
+			void apply(const std::filesystem::path& root, const char* buffer, ssize_t length) {
+				for (ssize_t offset = 0; offset < length; ) {
+					auto event = (const struct inotify_event*)(buffer + offset);
+					offset += sizeof(struct inotify_event) + event->len;
+
+					if (event->mask & IN_Q_OVERFLOW) {
+						record(DirectoryChange::Kind::Rescan, std::string());
+						continue;
+					}
+					if (event->mask & IN_IGNORED) {
+						prefixes.erase(event->wd);
+						continue;
+					}
+					auto prefix = prefixes.find(event->wd);
+					if (prefix == prefixes.end()) {
+						continue;
+					}
+					if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+						// Subdirectories are reported by their parent; losing
+						// the root loses everything.
+						if (prefix->second.empty()) {
+							record(DirectoryChange::Kind::Rescan, std::string());
+						}
+						continue;
+					}
+					std::string name = prefix->second + ((event->len != 0) ? event->name : "");
+
+					if (event->mask & IN_ISDIR) {
+						if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+							add_tree(name + "/", root / name, true);
+						} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+							// The files it held are unknown here.
+							record(DirectoryChange::Kind::Rescan, std::string());
+						}
+						continue;
+					}
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						record(DirectoryChange::Kind::Added, name);
+					} else if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+						record(DirectoryChange::Kind::Removed, name);
+					} else if (event->mask & IN_CLOSE_WRITE) {
+						record(DirectoryChange::Kind::Modified, name);
+					}
+				}
+			}
+
+			/// Takes the pending changes as a batch.
+			DirectoryChanges take() {
+				DirectoryChanges changes;
+				changes.reserve(order.size());
+				for (auto& identity : order) {
+					changes.push_back(DirectoryChange{ pending[identity], identity });
+				}
+				pending.clear();
+				order.clear();
+				return changes;
+			}
+		};
+
+		DirectoryWatcher::DirectoryWatcher() {}
+
+		DirectoryWatcher::~DirectoryWatcher() {
+			if (thread.joinable()) {
+				std::uint64_t one = 1;
+				if (::write(platform->wake, &one, sizeof(one)) < 0) {
+					// eventfd writes only fail on counter overflow.
+				}
+				thread.join();
+			}
+		}
+
+		void DirectoryWatcher::run() {
+			// Large enough for many events per read.
+			alignas(struct inotify_event) char buffer[64 * 1024];
+
+			bool batching = false;
+			auto deadline = std::chrono::steady_clock::now();
+			for (;;) {
+				int timeout = -1;
+				if (batching) {
+					auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+						deadline - std::chrono::steady_clock::now()).count();
+					timeout = (remaining > 0) ? (int)remaining : 0;
+				}
+
+				struct pollfd descriptors[2] = {
+					{ platform->inotify, POLLIN, 0 },
+					{ platform->wake, POLLIN, 0 },
+				};
+				int ready = ::poll(descriptors, 2, timeout);
+				if (ready < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					return;
+				}
+				if (descriptors[1].revents != 0) {
+					return; // Stopping; the pending batch is dropped.
+				}
+				if (descriptors[0].revents & POLLIN) {
+					for (;;) {
+						auto length = ::read(platform->inotify, buffer, sizeof(buffer));
+						if (length <= 0) {
+							break;
+						}
+						platform->apply(root, buffer, length);
+					}
+					if (!batching && !platform->pending.empty()) {
+						batching = true;
+						deadline = std::chrono::steady_clock::now() + latency;
+					}
+				}
+				if (batching && std::chrono::steady_clock::now() >= deadline) {
+					batching = false;
+					callback(platform->take());
+				}
+			}
+		}
+
+		DirectoryWatcherPointer DirectoryWatcher::create(const std::filesystem::path& root,
+			DirectoryChangeFunction callback, std::chrono::milliseconds latency) {
+			if (callback == nullptr) {
+				return nullptr;
+			}
+			DirectoryWatcherPointer watcher(new DirectoryWatcher());
+			watcher->root = root;
+			watcher->callback = callback;
+			watcher->latency = latency;
+			watcher->platform.reset(new Platform());
+
+			auto& platform = *watcher->platform;
+			platform.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+			platform.wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (platform.inotify == -1 || platform.wake == -1) {
+				return nullptr;
+			}
+			if (!platform.add_tree(std::string(), root, false)) {
+				return nullptr;
+			}
+			watcher->thread = std::thread(&DirectoryWatcher::run, watcher.get());
+			return watcher;
+		}
+	}
+}
+
+#endif//defined(__linux__)
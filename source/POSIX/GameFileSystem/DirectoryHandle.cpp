@@ -0,0 +1,49 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the POSIX directory handle.
+#if defined(__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <unistd.h>
+#if defined(_POSIX_VERSION)
+
+#include <ReversingSpace/GameFileSystem/DirectoryHandle.hpp>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace reversingspace {
+	namespace gfs {
+		DirectoryHandle::Descriptor::~Descriptor() {
+			::close(handle);
+		}
+
+		storage::PlatformFileHandle DirectoryHandle::open_directory(storage::PlatformFileHandle parent,
+			const char* name) {
+#if defined(O_PATH)
+			// Only used as the base of `openat`.
+			const int flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+#else
+			const int flags = O_RDONLY | O_DIRECTORY | O_CLOEXEC;
+#endif//defined(O_PATH)
+			return ::openat((parent == storage::PLATFORM_INVALID_FILE_HANDLE) ? AT_FDCWD : parent,
+				name, flags);
+		}
+
+		bool DirectoryHandle::is_deleted(storage::PlatformFileHandle directory) {
+			struct stat status;
+			return ::fstat(directory, &status) != 0 || status.st_nlink == 0;
+		}
+	}
+}
+
+#endif//defined(_POSIX_VERSION)
+#endif//defined(__unix__) || (defined (__APPLE__) && defined (__MACH__))
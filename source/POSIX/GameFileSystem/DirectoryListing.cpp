@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the POSIX (readdir) listing; Linux has its own.
+#if (defined(__unix__) || (defined (__APPLE__) && defined (__MACH__))) && !defined(__linux__)
+#include <unistd.h>
+#if defined(_POSIX_VERSION)
+
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Maps a `st_mode` to an entry type.
+			EntryType type_of_mode(mode_t mode) {
+				if (S_ISREG(mode)) {
+					return EntryType::File;
+				}
+				if (S_ISDIR(mode)) {
+					return EntryType::Directory;
+				}
+				return EntryType::Other;
+			}
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_directory(const std::filesystem::path& path) {
+			int directory = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			return (directory == -1) ? INVALID_DIRECTORY : (DirectoryHandle)directory;
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_child(DirectoryHandle parent, const char* name) {
+			int directory = ::openat((int)parent, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			return (directory == -1) ? INVALID_DIRECTORY : (DirectoryHandle)directory;
+		}
+
+		void DirectoryListing::close_directory(DirectoryHandle directory) {
+			::close((int)directory);
+		}
+
+		bool DirectoryListing::identify(DirectoryHandle directory, const std::filesystem::path& path,
+			const std::string& prefix, DirectoryId& id) {
+			(void)path;
+			(void)prefix;
+			struct stat status;
+			if (::fstat((int)directory, &status) != 0) {
+				return false;
+			}
+			id.device = (std::uint64_t)status.st_dev;
+			id.inode = (std::uint64_t)status.st_ino;
+			return true;
+		}
+
+		bool DirectoryListing::read(DirectoryHandle handle, const std::filesystem::path& path,
+			const std::string& prefix, bool metadata) {
+			// Everything is read through (and stat'd relative to) the handle.
+			(void)path;
+			int directory = (int)handle;
+
+			// The stream owns (and closes) its descriptor; the handle stays
+			// open for opening children, so the stream gets a duplicate.
+			int duplicate = ::fcntl(directory, F_DUPFD_CLOEXEC, 0);
+			if (duplicate == -1) {
+				return false;
+			}
+			DIR* stream = ::fdopendir(duplicate);
+			if (stream == nullptr) {
+				::close(duplicate);
+				return false;
+			}
+
+			while (struct dirent* record = ::readdir(stream)) {
+				const char* name = record->d_name;
+				if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+					continue;
+				}
+
+				EntryType type = EntryType::Unknown;
+#if defined(DT_UNKNOWN)
+				switch (record->d_type) {
+					case DT_REG: type = EntryType::File; break;
+					case DT_DIR: type = EntryType::Directory; break;
+					case DT_LNK: case DT_UNKNOWN: break; // Needs a stat.
+					default: type = EntryType::Other; break;
+				}
+#endif//defined(DT_UNKNOWN)
+
+				std::uint64_t size = 0;
+				std::int64_t modified = 0;
+				if (metadata || type == EntryType::Unknown) {
+					struct stat status;
+					if (::fstatat(directory, name, &status, 0) == 0) {
+						type = type_of_mode(status.st_mode);
+						size = (std::uint64_t)status.st_size;
+#if defined(__APPLE__)
+						modified = (std::int64_t)status.st_mtimespec.tv_sec * 1000000000 + status.st_mtimespec.tv_nsec;
+#else
+						modified = (std::int64_t)status.st_mtim.tv_sec * 1000000000 + status.st_mtim.tv_nsec;
+#endif//defined(__APPLE__)
+					}
+				}
+				add(prefix, name, type, size, modified);
+			}
+			::closedir(stream);
+			return true;
+		}
+	}
+}
+
+#endif//defined(_POSIX_VERSION)
+#endif//POSIX, not Linux
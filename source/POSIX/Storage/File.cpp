@@ -16,6 +16,7 @@
 #if defined(_POSIX_VERSION)
 
 #include <ReversingSpace/Storage/File.hpp>
+#include <cerrno>
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/mman.h>
@@ -39,58 +40,122 @@ namespace reversingspace {
 #endif
 
 	namespace storage {
-		bool File::open() {
-			int flags = 0;
-			mode_t mode = 0;
+		namespace {
+			/// Open flags and creation mode for an access mode.
+			void access_flags(FileAccess access, int& flags, mode_t& mode) {
+				flags = 0;
+				mode = 0;
 
-			const mode_t R_MODE = S_IRUSR | S_IRGRP | S_IROTH;
-			const mode_t W_MODE = S_IWUSR;
-			const mode_t E_MODE = S_IXUSR;
+				const mode_t R_MODE = S_IRUSR | S_IRGRP | S_IROTH;
+				const mode_t W_MODE = S_IWUSR;
+				const mode_t E_MODE = S_IXUSR;
 
-			// This needs more testing, as does the Win32 version.
-			switch (access) {
-				case FileAccess::Read: {
-					flags = O_RDONLY;
-					mode = R_MODE;
-				} break;
-				case FileAccess::Write: {
-					// flags = O_WRONLY | O_CREAT;
-					//  mode = O_RDWR;
+				// This needs more testing, as does the Win32 version.
+				//
+				// Read-only opens are non-blocking so that a FIFO (or device)
+				// cannot stall the open before `validate_open` rejects it;
+				// the flag is cleared again once the file is known regular.
+				switch (access) {
+					case FileAccess::Read: {
+						flags = O_RDONLY | O_NONBLOCK;
+						mode = R_MODE;
+					} break;
+					case FileAccess::Write: {
+						// flags = O_WRONLY | O_CREAT;
+						//  mode = O_RDWR;
 
-					// Not all platforms are trustworthy here,
-					// which, given this is POSIX, is weird.
-					//
-					// Read is required to prevent platforms that do a 'test read'
-					// somewhere from freaking out.  This isn't ideal, but for
-					// some reason cursor work freaks it out in some tests.
-					flags = O_RDWR | O_CREAT;
-					mode = R_MODE | W_MODE;
-				} break;
-				case FileAccess::ReadWrite: {
-					flags = O_RDWR | O_CREAT;
-					mode = R_MODE | W_MODE;
-				} break;
-				case FileAccess::ReadExecute: {
-					flags = O_RDONLY;
-					mode = R_MODE | E_MODE;
-				} break;
-				case FileAccess::Execute: {
-					flags = O_RDONLY;
-					// Enable read to prevent some weird edge cases in testing.
-					mode = R_MODE | E_MODE;
-				} break;
-				case FileAccess::ReadWriteExecute: {
-					flags = O_RDWR | O_CREAT;
-					mode = R_MODE | E_MODE | W_MODE;
-				} break;
+						// Not all platforms are trustworthy here,
+						// which, given this is POSIX, is weird.
+						//
+						// Read is required to prevent platforms that do a 'test read'
+						// somewhere from freaking out.  This isn't ideal, but for
+						// some reason cursor work freaks it out in some tests.
+						flags = O_RDWR | O_CREAT;
+						mode = R_MODE | W_MODE;
+					} break;
+					case FileAccess::ReadWrite: {
+						flags = O_RDWR | O_CREAT;
+						mode = R_MODE | W_MODE;
+					} break;
+					case FileAccess::ReadExecute: {
+						flags = O_RDONLY | O_NONBLOCK;
+						mode = R_MODE | E_MODE;
+					} break;
+					case FileAccess::Execute: {
+						flags = O_RDONLY | O_NONBLOCK;
+						// Enable read to prevent some weird edge cases in testing.
+						mode = R_MODE | E_MODE;
+					} break;
+					case FileAccess::ReadWriteExecute: {
+						flags = O_RDWR | O_CREAT;
+						mode = R_MODE | E_MODE | W_MODE;
+					} break;
+				}
 			}
+		}
+
+		bool File::open() {
+			int flags;
+			mode_t mode;
+			access_flags(access, flags, mode);
 
 			file_handle = ::open(
-				path.string().c_str(),
-				flags,
+				path.c_str(),
+				flags | O_CLOEXEC,
 				mode
 			);
-			return file_handle != PLATFORM_INVALID_FILE_HANDLE;
+			if (file_handle == PLATFORM_INVALID_FILE_HANDLE && errno == ENOENT && (flags & O_CREAT)) {
+				// Force creation for write: make the parent, then retry.
+				std::error_code error;
+				std::filesystem::create_directories(path.parent_path(), error);
+				if (!error) {
+					file_handle = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+				}
+			}
+			return validate_open();
+		}
+
+		bool File::open_at(PlatformFileHandle directory, const char* name) {
+			int flags;
+			mode_t mode;
+			access_flags(access, flags, mode);
+
+			file_handle = ::openat(directory, name, flags | O_CLOEXEC, mode);
+			return validate_open();
+		}
+
+		bool File::validate_open() {
+			if (file_handle == PLATFORM_INVALID_FILE_HANDLE) {
+				return false;
+			}
+			if (!((int)access & (int)FileAccess::Write)) {
+				// Only regular files can be read (and mapped); symlinks were
+				// followed by the open.  The size cannot change through us.
+				struct stat status;
+				if (::fstat(file_handle, &status) != 0 || !S_ISREG(status.st_mode)) {
+					::close(file_handle);
+					file_handle = PLATFORM_INVALID_FILE_HANDLE;
+					return false;
+				}
+				int status_flags = ::fcntl(file_handle, F_GETFL);
+				if (status_flags == -1 || ::fcntl(file_handle, F_SETFL, status_flags & ~O_NONBLOCK) == -1) {
+					::close(file_handle);
+					file_handle = PLATFORM_INVALID_FILE_HANDLE;
+					return false;
+				}
+				cached_size = (StorageSize)status.st_size;
+				size_cached = true;
+			}
+			return true;
+		}
+
+		StorageSize File::query_size() const {
+			// From the descriptor, so it holds even if the path has gone.
+			struct stat status;
+			if (::fstat(file_handle, &status) != 0) {
+				return 0;
+			}
+			return (StorageSize)status.st_size;
 		}
 
 		// Platform-specific terminate.
@@ -113,6 +113,20 @@ namespace reversingspace {
 			return result == 0;
 		}
 
+		bool View::prefetch(StorageSize offset, StorageSize size) {
+			if (view_pointer == nullptr || offset >= view_length) {
+				return false;
+			}
+			if (size > view_length - offset) {
+				size = view_length - offset;
+			}
+			// madvise wants a page-aligned start.
+			std::uint64_t page = (std::uint64_t)sysconf(_SC_PAGESIZE);
+			char* start = (char*)view_pointer + offset;
+			char* aligned = (char*)((std::uintptr_t)start & ~(std::uintptr_t)(page - 1));
+			return ::madvise(aligned, (size_t)(size + (start - aligned)), MADV_WILLNEED) == 0;
+		}
+
 		View::~View() {
 			/*
 			if (file != nullptr) {
@@ -0,0 +1,37 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the WINDOWS directory handle (unsupported).
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <ReversingSpace/GameFileSystem/DirectoryHandle.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		DirectoryHandle::Descriptor::~Descriptor() {}
+
+		storage::PlatformFileHandle DirectoryHandle::open_directory(storage::PlatformFileHandle parent,
+			const char* name) {
+			// There is no `openat` equivalent in Win32, so `create` fails.
+			(void)parent;
+			(void)name;
+			return storage::PLATFORM_INVALID_FILE_HANDLE;
+		}
+
+		bool DirectoryHandle::is_deleted(storage::PlatformFileHandle directory) {
+			(void)directory;
+			return true;
+		}
+	}
+}
+
+#endif//defined(_WIN32) || defined(_WIN64)
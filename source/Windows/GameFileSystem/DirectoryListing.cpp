@@ -0,0 +1,126 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// This is the WINDOWS listing.
+#if defined(_WIN32) || defined(_WIN64)
+
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+#include <Windows.h>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// 100ns intervals between 1601-01-01 and 1970-01-01.
+			const std::int64_t UNIX_EPOCH_FILETIME = 116444736000000000LL;
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_directory(const std::filesystem::path& path) {
+			// There is no `openat`; directories are found by path.
+			DWORD attributes = GetFileAttributesW(path.c_str());
+			if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+				return INVALID_DIRECTORY;
+			}
+			return 0;
+		}
+
+		DirectoryListing::DirectoryHandle DirectoryListing::open_child(DirectoryHandle parent, const char* name) {
+			// Found by path in `read` (which fails if it is gone).
+			(void)parent;
+			(void)name;
+			return 0;
+		}
+
+		void DirectoryListing::close_directory(DirectoryHandle directory) {
+			(void)directory;
+		}
+
+		bool DirectoryListing::identify(DirectoryHandle directory, const std::filesystem::path& path,
+			const std::string& prefix, DirectoryId& id) {
+			(void)directory;
+			auto target = prefix.empty() ? path : path / std::filesystem::u8path(prefix);
+			// Backup semantics are needed to open a directory; links are followed.
+			HANDLE handle = CreateFileW(target.c_str(), 0,
+				FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+				OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+			if (handle == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			BY_HANDLE_FILE_INFORMATION information;
+			BOOL identified = GetFileInformationByHandle(handle, &information);
+			CloseHandle(handle);
+			if (!identified) {
+				return false;
+			}
+			id.device = information.dwVolumeSerialNumber;
+			id.inode = ((std::uint64_t)information.nFileIndexHigh << 32) | information.nFileIndexLow;
+			return true;
+		}
+
+		bool DirectoryListing::read(DirectoryHandle handle, const std::filesystem::path& path,
+			const std::string& prefix, bool metadata) {
+			// Sizes and times come with every record, so `metadata` is free here.
+			(void)handle;
+			(void)metadata;
+
+			auto directory = prefix.empty() ? path : path / std::filesystem::u8path(prefix);
+			auto pattern = (directory / "*").wstring();
+			WIN32_FIND_DATAW record;
+			HANDLE search = FindFirstFileExW(pattern.c_str(), FindExInfoBasic, &record,
+				FindExSearchNameMatch, nullptr, FIND_FIRST_EX_LARGE_FETCH);
+			if (search == INVALID_HANDLE_VALUE) {
+				// An empty directory still has "." and "..", so this is an error.
+				return false;
+			}
+
+			std::string name;
+			do {
+				const wchar_t* wide = record.cFileName;
+				if (wide[0] == L'.' && (wide[1] == L'\0' || (wide[1] == L'.' && wide[2] == L'\0'))) {
+					continue;
+				}
+
+				// Identities are UTF-8.
+				int length = WideCharToMultiByte(CP_UTF8, 0, wide, -1, nullptr, 0, nullptr, nullptr);
+				if (length <= 1) {
+					continue;
+				}
+				name.resize((size_t)length);
+				WideCharToMultiByte(CP_UTF8, 0, wide, -1, &name[0], length, nullptr, nullptr);
+				name.resize((size_t)length - 1);
+
+				EntryType type = (record.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+					? EntryType::Directory : EntryType::File;
+				if (record.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+					// Links report their target.
+					std::error_code error;
+					auto status = std::filesystem::status(directory / wide, error);
+					type = error ? EntryType::Unknown
+						: std::filesystem::is_directory(status) ? EntryType::Directory
+						: std::filesystem::is_regular_file(status) ? EntryType::File
+						: EntryType::Other;
+				}
+
+				std::uint64_t size = ((std::uint64_t)record.nFileSizeHigh << 32) | record.nFileSizeLow;
+				std::int64_t modified = (((std::int64_t)record.ftLastWriteTime.dwHighDateTime << 32)
+					| record.ftLastWriteTime.dwLowDateTime);
+				modified = (modified - UNIX_EPOCH_FILETIME) * 100;
+				add(prefix, name, type, (type == EntryType::File) ? size : 0, modified);
+			} while (FindNextFileW(search, &record));
+
+			bool complete = (GetLastError() == ERROR_NO_MORE_FILES);
+			FindClose(search);
+			return complete;
+		}
+	}
+}
+
+#endif//defined(_WIN32) || defined(_WIN64)
@@ -67,10 +67,17 @@ namespace reversingspace {
 				} break;
 			}
 
+			// Without write access nothing may be created.
+			bool writing = ((int)access & (int)FileAccess::Write) != 0;
+			if (!writing) {
+				dwCreationDisposition = OPEN_EXISTING;
+			}
+
 			// This creates (or opens) the file.  Naming is somewhat obvious,
 			// but the arguments are kind of weird to anyone used to `fopen`.
+			auto wide_path = path.wstring();
 			file_handle = ::CreateFileW(
-				path.wstring().c_str(),
+				wide_path.c_str(),
 				dwDesiredAccess,
 				dwShareMode,
 				NULL,
@@ -78,6 +85,15 @@ namespace reversingspace {
 				dwFlagsAndAttributes,
 				NULL
 			);
+			if (file_handle == INVALID_HANDLE_VALUE && writing && GetLastError() == ERROR_PATH_NOT_FOUND) {
+				// Force creation for write: make the parent, then retry.
+				std::error_code error;
+				std::filesystem::create_directories(path.parent_path(), error);
+				if (!error) {
+					file_handle = ::CreateFileW(wide_path.c_str(), dwDesiredAccess, dwShareMode,
+						NULL, dwCreationDisposition, dwFlagsAndAttributes, NULL);
+				}
+			}
 
 			if (file_handle == INVALID_HANDLE_VALUE) {
 #if defined(_DEBUG)
@@ -86,9 +102,44 @@ namespace reversingspace {
 #endif
 				return false;
 			}
+			return validate_open();
+		}
+
+		bool File::validate_open() {
+			if (file_handle == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+			if (!((int)access & (int)FileAccess::Write)) {
+				// Only regular (disk) files can be read and mapped.  The size
+				// cannot change through us.
+				LARGE_INTEGER size;
+				if (::GetFileType(file_handle) != FILE_TYPE_DISK || !::GetFileSizeEx(file_handle, &size)) {
+					::CloseHandle(file_handle);
+					file_handle = PLATFORM_INVALID_FILE_HANDLE;
+					return false;
+				}
+				cached_size = (StorageSize)size.QuadPart;
+				size_cached = true;
+			}
 			return true;
 		}
 
+		bool File::open_at(PlatformFileHandle directory, const char* name) {
+			// There is no `openat` equivalent in Win32.
+			(void)directory;
+			(void)name;
+			return false;
+		}
+
+		StorageSize File::query_size() const {
+			// From the handle, so it holds even if the path has gone.
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(file_handle, &size)) {
+				return 0;
+			}
+			return (StorageSize)size.QuadPart;
+		}
+
 		// Platform-specific terminate.
 		void File::close() {
 			::CloseHandle(file_handle);
@@ -122,6 +122,19 @@ namespace reversingspace {
 			return FlushFileBuffers(file->file_handle) != 0;
 		}
 
+		bool View::prefetch(StorageSize offset, StorageSize size) {
+			if (view_pointer == nullptr || offset >= view_length) {
+				return false;
+			}
+			if (size > view_length - offset) {
+				size = view_length - offset;
+			}
+			WIN32_MEMORY_RANGE_ENTRY range;
+			range.VirtualAddress = (char*)view_pointer + offset;
+			range.NumberOfBytes = (SIZE_T)size;
+			return ::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0) != 0;
+		}
+
 		View::~View() {
 			/*
 			if (file != nullptr) {
@@ -0,0 +1,41 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/ArchiveEntryFile.hpp>
+
+#include <cstring>
+
+namespace reversingspace {
+	namespace gfs {
+		ArchiveEntryFilePointer ArchiveEntryFile::create(storage::ViewPointer view,
+			storage::StorageSize offset, storage::StorageSize size) {
+			if (view == nullptr) {
+				return nullptr;
+			}
+			auto limit = view->get_size();
+			if (offset > limit || size > limit - offset) {
+				return nullptr;
+			}
+			auto begin = (const char*)view->get_data_pointer() + offset;
+			return std::make_shared<ArchiveEntryFile>(std::move(view), begin, size);
+		}
+
+		storage::StorageSize ArchiveEntryFile::read_from(storage::StorageOffset offset,
+			char* data, storage::StorageSize requested) {
+			auto count = allowance(offset, requested);
+			if (count != 0) {
+				memcpy(data, begin + offset, (size_t)count);
+			}
+			return count;
+		}
+	}
+}
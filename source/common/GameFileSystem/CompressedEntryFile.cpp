@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/CompressedEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/Compression.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Blocks prefetched ahead of the one being decompressed (plus one per pool thread).
+			const storage::StorageSize PREFETCH_BLOCKS = 4;
+		}
+
+		CompressedEntryFile::CompressedEntryFile(storage::ViewPointer view, const char* begin,
+			storage::StorageSize stored_size, storage::StorageSize size, std::uint32_t block_size)
+			: ReadOnlyFile(size), view(std::move(view)), begin(begin), stored_size(stored_size),
+			block_size(block_size), block_count((size + block_size - 1) / block_size),
+			cached_block((size + block_size - 1) / block_size) {}
+
+		CompressedEntryFilePointer CompressedEntryFile::create(storage::ViewPointer view,
+			storage::StorageSize offset, storage::StorageSize stored_size,
+			storage::StorageSize size, std::uint32_t block_size) {
+			if (view == nullptr || block_size == 0) {
+				return nullptr;
+			}
+			auto limit = view->get_size();
+			if (offset > limit || stored_size > limit - offset) {
+				return nullptr;
+			}
+			auto block_count = (size + block_size - 1) / block_size;
+			if (block_count > stored_size / sizeof(std::uint64_t)) {
+				return nullptr;
+			}
+			auto begin = (const char*)view->get_data_pointer() + offset;
+			return std::make_shared<CompressedEntryFile>(std::move(view), begin, stored_size, size, block_size);
+		}
+
+		void CompressedEntryFile::compress_blocks(const char* data, storage::StorageSize size,
+			std::uint32_t block_size, storage::StorageSize base,
+			std::vector<char>& blocks, std::vector<std::uint64_t>& ends) {
+			std::vector<char> scratch(lz_compress_bound(block_size));
+			for (storage::StorageSize at = 0; at < size; at += block_size) {
+				auto length = (size_t)std::min<storage::StorageSize>(block_size, size - at);
+				auto packed = lz_compress(data + at, length, scratch.data(), scratch.size());
+				if (packed != 0 && packed < length) {
+					blocks.insert(blocks.end(), scratch.data(), scratch.data() + packed);
+				} else {
+					// Not worth it: stored as-is (recognised by its size).
+					blocks.insert(blocks.end(), data + at, data + at + length);
+				}
+				ends.push_back(base + blocks.size());
+			}
+		}
+
+		void CompressedEntryFile::compress(const char* data, storage::StorageSize size,
+			std::uint32_t block_size, std::vector<char>& stored) {
+			auto block_count = (size + block_size - 1) / block_size;
+			auto table_size = block_count * sizeof(std::uint64_t);
+			std::vector<char> blocks;
+			std::vector<std::uint64_t> ends;
+			ends.reserve((size_t)block_count);
+			compress_blocks(data, size, block_size, table_size, blocks, ends);
+			stored.resize((size_t)table_size);
+			if (table_size != 0) {
+				memcpy(stored.data(), ends.data(), (size_t)table_size);
+			}
+			stored.insert(stored.end(), blocks.begin(), blocks.end());
+		}
+
+		bool CompressedEntryFile::read_block(storage::StorageSize block, char* out) const {
+			if (block >= block_count) {
+				return false;
+			}
+			std::uint64_t start = block_count * sizeof(std::uint64_t);
+			if (block != 0) {
+				memcpy(&start, begin + (block - 1) * sizeof(std::uint64_t), sizeof(start));
+			}
+			std::uint64_t end;
+			memcpy(&end, begin + block * sizeof(std::uint64_t), sizeof(end));
+			if (start > end || end > stored_size) {
+				return false;
+			}
+			auto length = std::min<storage::StorageSize>(block_size, size - block * block_size);
+			if (end - start == length) {
+				memcpy(out, begin + start, (size_t)length);
+				return true;
+			}
+			return lz_decompress(begin + start, (size_t)(end - start), out, (size_t)length);
+		}
+
+		void CompressedEntryFile::prefetch_blocks(storage::StorageSize first,
+			storage::StorageSize count) const {
+			if (first >= block_count || count == 0) {
+				return;
+			}
+			auto last = std::min(first + count, block_count) - 1;
+			std::uint64_t start = block_count * sizeof(std::uint64_t);
+			if (first != 0) {
+				memcpy(&start, begin + (first - 1) * sizeof(std::uint64_t), sizeof(start));
+			}
+			std::uint64_t end;
+			memcpy(&end, begin + last * sizeof(std::uint64_t), sizeof(end));
+			if (start < end && end <= stored_size) {
+				auto base = (const char*)view->get_data_pointer();
+				view->prefetch((storage::StorageSize)(begin - base) + start, end - start);
+			}
+		}
+
+		storage::StorageSize CompressedEntryFile::read_blocks(storage::StorageSize first,
+			storage::StorageSize count, char* out) const {
+			auto lookahead = PREFETCH_BLOCKS + ((pool == nullptr) ? 0 : pool->size());
+			prefetch_blocks(first, std::min(count, lookahead));
+			if (pool == nullptr || count < 2) {
+				for (storage::StorageSize i = 0; i < count; ++i) {
+					if (i + lookahead < count) {
+						prefetch_blocks(first + i + lookahead, 1);
+					}
+					if (!read_block(first + i, out + i * block_size)) {
+						return i;
+					}
+				}
+				return count;
+			}
+
+			// Blocks are claimed in order, so prefetching `lookahead` on
+			// keeps reads ahead of every thread.
+			std::vector<char> damaged((size_t)count, 0);
+			ParallelLoop loop(pool.get(), (size_t)count, [this, first, count, lookahead, out, &damaged](size_t i) {
+				if (i + lookahead < count) {
+					prefetch_blocks(first + i + lookahead, 1);
+				}
+				if (!read_block(first + i, out + i * block_size)) {
+					damaged[i] = 1;
+				}
+			});
+			loop.finish();
+			return (storage::StorageSize)(std::find(damaged.begin(), damaged.end(), 1) - damaged.begin());
+		}
+
+		storage::StorageSize CompressedEntryFile::read_from(storage::StorageOffset offset,
+			char* data, storage::StorageSize requested) {
+			auto count = allowance(offset, requested);
+			if (count == 0) {
+				return 0;
+			}
+			auto position = (storage::StorageSize)offset;
+			auto end = position + count;
+			while (position < end) {
+				auto block = position / block_size;
+				auto block_start = block * block_size;
+				auto block_length = std::min<storage::StorageSize>(block_size, size - block_start);
+				auto within = position - block_start;
+				auto length = std::min(block_length - within, end - position);
+				if (within == 0 && length == block_length) {
+					// Whole blocks (every one to the end if the read reaches
+					// it): straight into the caller's buffer.
+					auto run = (end == size) ? block_count - block : (end - position) / block_size;
+					auto done = read_blocks(block, run, data);
+					auto advance = std::min(done * block_size, size - position);
+					data += advance;
+					position += advance;
+					if (done != run) {
+						break;
+					}
+					continue;
+				} else {
+					std::lock_guard<std::mutex> lock(cache_mutex);
+					if (cached_block != block) {
+						cache.resize(block_size);
+						if (!read_block(block, cache.data())) {
+							cached_block = block_count;
+							break;
+						}
+						cached_block = block;
+					}
+					memcpy(data, cache.data() + within, (size_t)length);
+				}
+				data += length;
+				position += length;
+			}
+			return position - (storage::StorageSize)offset;
+		}
+	}
+}
@@ -0,0 +1,188 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/Compression.hpp>
+
+#include <cstring>
+#include <vector>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Shortest match worth encoding.
+			const size_t MIN_MATCH = 4;
+
+			/// Furthest a match may reach back (16-bit offsets).
+			const size_t MAX_OFFSET = 0xffff;
+
+			/// Bits of the match-finder's hash table.
+			const unsigned HASH_BITS = 14;
+
+			/// Marks an empty hash table slot.
+			const std::uint32_t NO_POSITION = 0xffffffff;
+
+			/// Reads four bytes (unaligned).
+			std::uint32_t load32(const char* data) {
+				std::uint32_t value;
+				memcpy(&value, data, sizeof(value));
+				return value;
+			}
+
+			/// Hashes four bytes into the table.
+			std::uint32_t hash32(std::uint32_t value) {
+				return (value * 2654435761u) >> (32 - HASH_BITS);
+			}
+
+			/// Writes the extension bytes of a length (255s, then the rest).
+			bool put_length(char* target, size_t capacity, size_t& out, size_t length) {
+				for (; length >= 255; length -= 255) {
+					if (out >= capacity) {
+						return false;
+					}
+					target[out++] = (char)255;
+				}
+				if (out >= capacity) {
+					return false;
+				}
+				target[out++] = (char)length;
+				return true;
+			}
+
+			/// Reads the extension bytes of a length.
+			bool get_length(const unsigned char* source, size_t size, size_t& in, size_t& length) {
+				unsigned char byte;
+				do {
+					if (in >= size) {
+						return false;
+					}
+					byte = source[in++];
+					length += byte;
+				} while (byte == 255);
+				return true;
+			}
+
+			/**
+			 * @brief Writes one sequence: literals, then (unless `match` is 0) a match.
+			 * @return false if it does not fit.
+			 */
+			bool put_sequence(const char* literals, size_t literal_length, size_t offset,
+				size_t match, char* target, size_t capacity, size_t& out) {
+				size_t match_code = (match == 0) ? 0 : match - MIN_MATCH;
+				if (out >= capacity) {
+					return false;
+				}
+				target[out++] = (char)(((literal_length < 15 ? literal_length : 15) << 4) |
+					(match_code < 15 ? match_code : 15));
+				if (literal_length >= 15 && !put_length(target, capacity, out, literal_length - 15)) {
+					return false;
+				}
+				if (literal_length > capacity - out) {
+					return false;
+				}
+				memcpy(target + out, literals, literal_length);
+				out += literal_length;
+				if (match == 0) {
+					return true;
+				}
+				if (capacity - out < 2) {
+					return false;
+				}
+				target[out++] = (char)(offset & 0xff);
+				target[out++] = (char)(offset >> 8);
+				return match_code < 15 || put_length(target, capacity, out, match_code - 15);
+			}
+		}
+
+		size_t lz_compress(const char* source, size_t size, char* target, size_t capacity) {
+			std::vector<std::uint32_t> table((size_t)1 << HASH_BITS, NO_POSITION);
+			size_t out = 0;
+			size_t anchor = 0;
+			size_t position = 0;
+			while (size >= MIN_MATCH && position <= size - MIN_MATCH) {
+				auto sequence = load32(source + position);
+				auto& slot = table[hash32(sequence)];
+				size_t candidate = slot;
+				slot = (std::uint32_t)position;
+				if (candidate == NO_POSITION || position - candidate > MAX_OFFSET ||
+					load32(source + candidate) != sequence) {
+					// Skip faster through data which does not match.
+					position += 1 + ((position - anchor) >> 6);
+					continue;
+				}
+				size_t match = MIN_MATCH;
+				while (position + match < size && source[candidate + match] == source[position + match]) {
+					++match;
+				}
+				if (!put_sequence(source + anchor, position - anchor, position - candidate, match,
+					target, capacity, out)) {
+					return 0;
+				}
+				position += match;
+				anchor = position;
+			}
+			if (!put_sequence(source + anchor, size - anchor, 0, 0, target, capacity, out)) {
+				return 0;
+			}
+			return out;
+		}
+
+		bool lz_decompress(const char* source, size_t size, char* target, size_t target_size) {
+			auto input = (const unsigned char*)source;
+			size_t in = 0;
+			size_t out = 0;
+			for (;;) {
+				if (in >= size) {
+					return false;
+				}
+				unsigned token = input[in++];
+				size_t literal_length = token >> 4;
+				if (literal_length == 15 && !get_length(input, size, in, literal_length)) {
+					return false;
+				}
+				if (literal_length > size - in || literal_length > target_size - out) {
+					return false;
+				}
+				memcpy(target + out, source + in, literal_length);
+				in += literal_length;
+				out += literal_length;
+				if (in == size) {
+					return out == target_size;
+				}
+
+				if (size - in < 2) {
+					return false;
+				}
+				size_t offset = (size_t)input[in] | ((size_t)input[in + 1] << 8);
+				in += 2;
+				size_t match = token & 15;
+				if (match == 15 && !get_length(input, size, in, match)) {
+					return false;
+				}
+				match += MIN_MATCH;
+				if (offset == 0 || offset > out || match > target_size - out) {
+					return false;
+				}
+				char* to = target + out;
+				const char* from = to - offset;
+				if (offset >= match) {
+					memcpy(to, from, match);
+				} else {
+					// Overlapping (a repeating pattern): byte by byte.
+					for (size_t i = 0; i < match; ++i) {
+						to[i] = from[i];
+					}
+				}
+				out += match;
+			}
+		}
+	}
+}
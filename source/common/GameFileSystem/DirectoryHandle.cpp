@@ -0,0 +1,117 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/DirectoryHandle.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		DirectoryHandle::DescriptorPointer DirectoryHandle::subdirectory(StringIdentity relative, bool& cached) {
+			auto tick = clock.fetch_add(1, std::memory_order_relaxed) + 1;
+			{
+				std::shared_lock lock(mutex);
+				auto entry = subdirectories.find(relative);
+				if (entry != subdirectories.end()) {
+					entry->second->last_used.store(tick, std::memory_order_relaxed);
+					cached = true;
+					return entry->second;
+				}
+			}
+			cached = false;
+
+			// Opened outside the lock; a racing thread's copy is dropped.
+			std::string name(relative);
+			auto handle = open_directory(root->handle, name.c_str());
+			if (handle == storage::PLATFORM_INVALID_FILE_HANDLE) {
+				return nullptr;
+			}
+			auto descriptor = std::make_shared<Descriptor>(handle);
+			descriptor->last_used.store(tick, std::memory_order_relaxed);
+			if (capacity == 0) {
+				return descriptor;
+			}
+
+			std::unique_lock lock(mutex);
+			auto entry = subdirectories.find(relative);
+			if (entry != subdirectories.end()) {
+				return entry->second;
+			}
+			if (subdirectories.size() >= capacity) {
+				// Evict the least recently used (this only happens on a miss).
+				auto oldest = subdirectories.begin();
+				for (auto candidate = subdirectories.begin(); candidate != subdirectories.end(); ++candidate) {
+					if (candidate->second->last_used.load(std::memory_order_relaxed) <
+						oldest->second->last_used.load(std::memory_order_relaxed)) {
+						oldest = candidate;
+					}
+				}
+				subdirectories.erase(oldest);
+				subdirectories.shrink();
+			}
+			subdirectories[relative] = descriptor;
+			return descriptor;
+		}
+
+		void DirectoryHandle::forget(StringIdentity relative) {
+			std::unique_lock lock(mutex);
+			subdirectories.erase(relative);
+		}
+
+		void DirectoryHandle::forget() {
+			std::unique_lock lock(mutex);
+			subdirectories.clear();
+		}
+
+		size_t DirectoryHandle::cached_count() const {
+			std::shared_lock lock(mutex);
+			return subdirectories.size();
+		}
+
+		storage::FilePointer DirectoryHandle::open(StringIdentity identity, std::filesystem::path path,
+			storage::FileAccess access) {
+			auto slash = identity.rfind('/');
+			if (slash == StringIdentity::npos) {
+				std::string name(identity);
+				return storage::File::create_at(root->handle, name.c_str(), std::move(path), access);
+			}
+
+			auto relative = identity.substr(0, slash);
+			std::string name(identity.substr(slash + 1));
+			bool cached;
+			auto directory = subdirectory(relative, cached);
+			if (directory == nullptr) {
+				return nullptr;
+			}
+			auto file = storage::File::create_at(directory->handle, name.c_str(), std::move(path), access);
+			if (file == nullptr && cached && is_deleted(directory->handle)) {
+				// The cached directory was deleted (and may have been recreated).
+				forget(relative);
+				directory = subdirectory(relative, cached);
+				if (directory == nullptr) {
+					return nullptr;
+				}
+				file = storage::File::create_at(directory->handle, name.c_str(), std::move(path), access);
+			}
+			return file;
+		}
+
+		DirectoryHandlePointer DirectoryHandle::create(const std::filesystem::path& path, size_t capacity) {
+			auto handle = open_directory(storage::PLATFORM_INVALID_FILE_HANDLE, path.string().c_str());
+			if (handle == storage::PLATFORM_INVALID_FILE_HANDLE) {
+				return nullptr;
+			}
+			auto directory = std::make_shared<DirectoryHandle>();
+			directory->root = std::make_shared<Descriptor>(handle);
+			directory->capacity = capacity;
+			return directory;
+		}
+	}
+}
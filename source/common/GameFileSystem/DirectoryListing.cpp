@@ -0,0 +1,272 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+
+namespace reversingspace {
+	namespace gfs {
+		/**
+		 * Directories waiting to be read are shared by the caller and any
+		 * helpers on the pool: whoever is free takes the next one, so a
+		 * deep branch does not hold up the rest of the tree.  Each read
+		 * produces its own part (no locking while reading); the parts are
+		 * merged and sorted once the tree is done.
+		 *
+		 * Each directory is opened from its parent's handle, which is
+		 * kept open (shared by the queued children) until the last child
+		 * has been opened.  Since opening from a handle never fails with
+		 * `ELOOP`, a symlinked directory which leads back into one of its
+		 * ancestors is caught by identity and not read again.
+		 *
+		 * Helpers hold the state by `shared_ptr` and leave as soon as they
+		 * find nothing to do, so the caller never waits for a helper which
+		 * has not been scheduled yet.
+		 */
+		struct DirectoryListing::Scan {
+			/// Identities of a directory and its ancestors (outlives their handles).
+			struct Lineage {
+				DirectoryId id;
+				std::shared_ptr<const Lineage> parent;
+
+				/// Whether a directory is this one or an ancestor.
+				bool contains(const DirectoryId& other) const {
+					for (auto node = this; node != nullptr; node = node->parent.get()) {
+						if (node->id == other) {
+							return true;
+						}
+					}
+					return false;
+				}
+			};
+
+			/// Open directory (closed once the last reference goes).
+			struct Opened {
+				DirectoryHandle handle;
+
+				/// Relative path ("" for the root, else ending in '/').
+				std::string prefix;
+
+				/// This directory and its ancestors.
+				std::shared_ptr<const Lineage> lineage;
+
+				Opened(DirectoryHandle handle, std::string prefix, std::shared_ptr<const Lineage> lineage)
+					: handle(handle), prefix(std::move(prefix)), lineage(std::move(lineage)) {}
+
+				~Opened() {
+					close_directory(handle);
+				}
+			};
+
+			/// Directory waiting to be read.
+			struct Pending {
+				/// Parent it is opened from.
+				std::shared_ptr<Opened> parent;
+
+				/// Relative path (without the trailing '/').
+				std::string relative;
+			};
+
+			/// Path of the root.
+			std::filesystem::path path;
+
+			/// Fill in sizes and modification times.
+			bool metadata;
+
+			/**
+			 * @brief Pool for helpers (may be nullptr).
+			 *
+			 * Not owned: a helper holding the last reference would destroy
+			 * the pool on one of its own threads.  Only used while reads
+			 * are in progress, when the caller still holds it.
+			 */
+			WorkerPool* pool = nullptr;
+
+			std::mutex mutex;
+
+			/// Signalled when work is queued or the last read finishes.
+			std::condition_variable changed;
+
+			/// Directories waiting to be read.
+			std::vector<Pending> pending;
+
+			/// Reads in progress.
+			size_t reading = 0;
+
+			/// Helpers submitted to the pool and not yet finished.
+			size_t helpers = 0;
+
+			/// Finished reads.
+			std::vector<DirectoryListing> parts;
+
+			/**
+			 * @brief Takes ownership of an opened directory, unless it loops.
+			 * @param[in] handle     Handle on the directory (closed if it is not kept).
+			 * @param[in] prefix     Relative path of the directory.
+			 * @param[in] ancestors  Lineage of its parent (nullptr for the root).
+			 * @return Opened directory, or nullptr if it is unidentified or one of its ancestors.
+			 */
+			std::shared_ptr<Opened> open(DirectoryHandle handle, std::string prefix,
+				std::shared_ptr<const Lineage> ancestors) const {
+				DirectoryId id;
+				if (!identify(handle, path, prefix, id) || (ancestors != nullptr && ancestors->contains(id))) {
+					close_directory(handle);
+					return nullptr;
+				}
+				auto lineage = std::make_shared<const Lineage>(Lineage{ id, std::move(ancestors) });
+				return std::make_shared<Opened>(handle, std::move(prefix), std::move(lineage));
+			}
+
+			/// Collects the subdirectories of a read directory.
+			static void children(const DirectoryListing& part, const std::shared_ptr<Opened>& opened,
+				std::vector<Pending>& found) {
+				for (auto& entry : part.entries) {
+					if (entry.type == EntryType::Directory) {
+						found.push_back(Pending{ opened, std::string(entry.name) });
+					}
+				}
+			}
+
+			/// Adds helpers for queued work (locked).
+			void recruit(const std::shared_ptr<Scan>& self) {
+				if (pool == nullptr) {
+					return;
+				}
+				while (helpers < pool->size() && helpers < pending.size()) {
+					++helpers;
+					pool->submit([self]() {
+						self->work(false, self);
+						std::lock_guard<std::mutex> lock(self->mutex);
+						--self->helpers;
+					});
+				}
+			}
+
+			/**
+			 * @brief Reads queued directories until none are left.
+			 * @param[in] caller  Wait for other reads (which may queue more work) before returning.
+			 * @param[in] self    Owner of this state (kept alive by helpers).
+			 */
+			void work(bool caller, const std::shared_ptr<Scan>& self) {
+				std::unique_lock<std::mutex> lock(mutex);
+				for (;;) {
+					if (!pending.empty()) {
+						Pending next = std::move(pending.back());
+						pending.pop_back();
+						++reading;
+						lock.unlock();
+
+						// The parent is closed (outside the lock) once its last child is open.
+						DirectoryHandle handle = open_child(next.parent->handle,
+							next.relative.c_str() + next.parent->prefix.size());
+						auto ancestors = next.parent->lineage;
+						next.parent.reset();
+
+						DirectoryListing part;
+						std::vector<Pending> found;
+						if (handle != INVALID_DIRECTORY) {
+							auto opened = open(handle, std::move(next.relative) + '/', ancestors);
+							if (opened != nullptr) {
+								part.read(handle, path, opened->prefix, metadata);
+								children(part, opened, found);
+							}
+						}
+
+						lock.lock();
+						for (auto& child : found) {
+							pending.push_back(std::move(child));
+						}
+						parts.push_back(std::move(part));
+						--reading;
+						recruit(self);
+						changed.notify_all();
+						continue;
+					}
+					if (!caller || reading == 0) {
+						return;
+					}
+					changed.wait(lock);
+				}
+			}
+		};
+
+		DirectoryListingPointer DirectoryListing::create(const std::filesystem::path& path, bool metadata) {
+			DirectoryHandle directory = open_directory(path);
+			if (directory == INVALID_DIRECTORY) {
+				return nullptr;
+			}
+			auto listing = std::make_shared<DirectoryListing>();
+			bool read = listing->read(directory, path, std::string(), metadata);
+			close_directory(directory);
+			if (!read) {
+				return nullptr;
+			}
+			return listing;
+		}
+
+		DirectoryListingPointer DirectoryListing::scan(const std::filesystem::path& path,
+			bool metadata, WorkerPoolPointer pool) {
+			auto state = std::make_shared<Scan>();
+			state->path = path;
+			state->metadata = metadata;
+			DirectoryHandle handle = open_directory(path);
+			if (handle == INVALID_DIRECTORY) {
+				return nullptr;
+			}
+			auto root = state->open(handle, std::string(), nullptr);
+			if (root == nullptr) {
+				return nullptr;
+			}
+
+			// The root is read up front, so an unreadable root fails.
+			auto listing = std::make_shared<DirectoryListing>();
+			if (!listing->read(handle, path, root->prefix, metadata)) {
+				return nullptr;
+			}
+			state->pool = pool.get();
+			Scan::children(*listing, root, state->pending);
+			root.reset();
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->recruit(state);
+			}
+			state->work(true, state);
+
+			// Every read is done (and every handle closed); helpers may
+			// still be leaving, but touch nothing but the lock and their count.
+			std::vector<DirectoryListing> parts;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				parts = std::move(state->parts);
+			}
+
+			// Merge (taking the parts' arenas, so names are not copied) and sort.
+			size_t total = listing->entries.size();
+			for (auto& part : parts) {
+				total += part.entries.size();
+			}
+			listing->entries.reserve(total);
+			for (auto& part : parts) {
+				listing->entries.insert(listing->entries.end(), part.entries.begin(), part.entries.end());
+				listing->names.adopt(std::move(part.names));
+			}
+			std::sort(listing->entries.begin(), listing->entries.end(),
+				[](const DirectoryEntry& left, const DirectoryEntry& right) {
+					return left.name < right.name;
+				});
+			return listing;
+		}
+	}
+}
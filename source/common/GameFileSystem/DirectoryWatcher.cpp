@@ -0,0 +1,37 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+// Fallback for platforms without a watcher implementation (see
+// `source/Linux/GameFileSystem/DirectoryWatcher.cpp`).
+#if !defined(__linux__)
+
+#include <ReversingSpace/GameFileSystem/DirectoryWatcher.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		struct DirectoryWatcher::Platform {};
+
+		DirectoryWatcher::DirectoryWatcher() {}
+
+		DirectoryWatcher::~DirectoryWatcher() {}
+
+		void DirectoryWatcher::run() {}
+
+		DirectoryWatcherPointer DirectoryWatcher::create(const std::filesystem::path& root,
+			DirectoryChangeFunction callback, std::chrono::milliseconds latency) {
+			// Unsupported: callers fall back to explicit invalidation.
+			return nullptr;
+		}
+	}
+}
+
+#endif//!defined(__linux__)
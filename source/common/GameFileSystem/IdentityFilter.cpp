@@ -0,0 +1,114 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/IdentityFilter.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Keeps string and hashed keys apart (they share the bit array).
+			const std::uint64_t STRING_SEED = 0x9e3779b97f4a7c15ULL;
+			const std::uint64_t HASHED_SEED = 0xc2b2ae3d27d4eb4fULL;
+
+			/// 64-bit finaliser (splitmix64); spreads weak hashes over every bit.
+			std::uint64_t mix(std::uint64_t key) {
+				key ^= key >> 30;
+				key *= 0xbf58476d1ce4e5b9ULL;
+				key ^= key >> 27;
+				key *= 0x94d049bb133111ebULL;
+				key ^= key >> 31;
+				return key;
+			}
+
+			std::uint64_t string_key(StringIdentity identity) {
+				return mix(fnv1a(identity.data(), identity.size()) ^ STRING_SEED);
+			}
+
+			std::uint64_t hashed_key(HashedIdentity identity) {
+				return mix(identity ^ HASHED_SEED);
+			}
+		}
+
+		IdentityFilter::IdentityFilter(size_t expected_entries, bool covers_hashed) :
+			hashed(covers_hashed) {
+			std::uint64_t words = ((std::uint64_t)expected_entries * BITS_PER_ENTRY + 63) / 64;
+			if (words == 0) {
+				words = 1;
+			}
+			bits.assign((size_t)words, 0);
+			bit_count = words * 64;
+		}
+
+		void IdentityFilter::insert_key(std::uint64_t key) {
+			// Double hashing: probe i lands on (a + i * b) mod m.
+			std::uint64_t a = key & 0xffffffffULL;
+			std::uint64_t b = (key >> 32) | 1;
+			for (unsigned i = 0; i < PROBES; ++i) {
+				auto bit = (a + i * b) % bit_count;
+				bits[bit >> 6] |= 1ULL << (bit & 63);
+			}
+		}
+
+		bool IdentityFilter::test_key(std::uint64_t key) const {
+			std::uint64_t a = key & 0xffffffffULL;
+			std::uint64_t b = (key >> 32) | 1;
+			for (unsigned i = 0; i < PROBES; ++i) {
+				auto bit = (a + i * b) % bit_count;
+				if ((bits[bit >> 6] & (1ULL << (bit & 63))) == 0) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void IdentityFilter::insert(StringIdentity identity) {
+			insert_key(string_key(identity));
+		}
+
+		void IdentityFilter::insert(HashedIdentity identity) {
+			insert_key(hashed_key(identity));
+		}
+
+		bool IdentityFilter::may_contain(StringIdentity identity) const {
+			return test_key(string_key(identity));
+		}
+
+		bool IdentityFilter::may_contain(HashedIdentity identity) const {
+			if (!hashed) {
+				return true;
+			}
+			return test_key(hashed_key(identity));
+		}
+
+		IdentityFilterPointer IdentityFilter::build(FileSystem& filesystem,
+			const HashFunction& function) {
+			// Keys are collected first, as the filter is sized by the count.
+			std::vector<std::uint64_t> keys;
+			bool enumerated = filesystem.enumerate([&keys, &function](StringIdentity name) {
+				keys.push_back(string_key(name));
+				if (function != nullptr) {
+					keys.push_back(hashed_key(function(name)));
+				}
+			});
+			if (!enumerated) {
+				return nullptr;
+			}
+			auto filter = std::make_shared<IdentityFilter>(keys.size(), function != nullptr);
+			for (auto key : keys) {
+				filter->insert_key(key);
+			}
+			return filter;
+		}
+	}
+}
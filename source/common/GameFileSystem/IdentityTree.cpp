@@ -0,0 +1,291 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/IdentityTree.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+
+#include <algorithm>
+
+namespace reversingspace {
+	namespace gfs {
+		GlobPattern::GlobPattern(StringIdentity pattern) {
+			for (size_t i = 0; i < pattern.size(); ) {
+				char c = pattern[i];
+				if (c == '*') {
+					if (i + 1 < pattern.size() && pattern[i + 1] == '*') {
+						if (i + 2 < pattern.size() && pattern[i + 2] == '/') {
+							// (`**` then '/'), or nothing.
+							elements.push_back(Element{ Token::DeepDirectory, 0 });
+							elements.push_back(Element{ Token::DeepStar, 0 });
+							elements.push_back(Element{ Token::Literal, '/' });
+							i += 3;
+						} else {
+							elements.push_back(Element{ Token::DeepStar, 0 });
+							i += 2;
+						}
+					} else {
+						elements.push_back(Element{ Token::Star, 0 });
+						i += 1;
+					}
+				} else if (c == '?') {
+					elements.push_back(Element{ Token::One, 0 });
+					i += 1;
+				} else {
+					elements.push_back(Element{ Token::Literal, c });
+					i += 1;
+				}
+			}
+			literal_prefix.assign(pattern.substr(0, pattern.find_first_of("*?")));
+		}
+
+		void GlobPattern::close(State& state) const {
+			// Positions only move forward, so one pass in order suffices.
+			for (size_t i = 0; i < elements.size(); ++i) {
+				if (state[i] == 0) {
+					continue;
+				}
+				switch (elements[i].token) {
+					case Token::Star:
+					case Token::DeepStar: {
+						state[i + 1] = 1;
+					} break;
+					case Token::DeepDirectory: {
+						// Into the `**`, or past it and the '/'.
+						state[i + 1] = 1;
+						state[i + 3] = 1;
+					} break;
+					default: break;
+				}
+			}
+		}
+
+		GlobPattern::State GlobPattern::start() const {
+			State state(elements.size() + 1, 0);
+			state[0] = 1;
+			close(state);
+			return state;
+		}
+
+		bool GlobPattern::advance(const State& from, char c, State& to) const {
+			to.assign(elements.size() + 1, 0);
+			for (size_t i = 0; i < elements.size(); ++i) {
+				if (from[i] == 0) {
+					continue;
+				}
+				switch (elements[i].token) {
+					case Token::Literal: {
+						if (c == elements[i].literal) {
+							to[i + 1] = 1;
+						}
+					} break;
+					case Token::One: {
+						if (c != '/') {
+							to[i + 1] = 1;
+						}
+					} break;
+					case Token::Star: {
+						if (c != '/') {
+							to[i] = 1;
+						}
+					} break;
+					case Token::DeepStar: {
+						to[i] = 1;
+					} break;
+					case Token::DeepDirectory: {
+						// Consumes nothing (see `close`).
+					} break;
+				}
+			}
+			close(to);
+			return std::find(to.begin(), to.end(), 1) != to.end();
+		}
+
+		bool GlobPattern::matches(StringIdentity name) const {
+			auto state = start();
+			State next;
+			for (char c : name) {
+				if (!advance(state, c, next)) {
+					return false;
+				}
+				state.swap(next);
+			}
+			return accepts(state);
+		}
+
+		void IdentityTree::build_below(const std::vector<StringIdentity>& names, size_t node,
+			size_t first, size_t last, size_t depth) {
+			// Only the shortest name can end here (they are sorted and unique).
+			if (first < last && names[first].size() == depth) {
+				nodes[node].terminal = true;
+				++first;
+			}
+
+			// Group the rest by their next byte; each group becomes a child.
+			std::vector<std::pair<size_t, size_t>> groups;
+			for (size_t i = first; i < last; ) {
+				auto byte = (unsigned char)names[i][depth];
+				auto end = std::partition_point(names.begin() + i, names.begin() + last,
+					[depth, byte](StringIdentity name) {
+						return (unsigned char)name[depth] <= byte;
+					});
+				groups.emplace_back(i, (size_t)(end - names.begin()));
+				i = groups.back().second;
+			}
+
+			size_t child = nodes.size();
+			nodes[node].first_child = (std::uint32_t)child;
+			nodes[node].child_count = (std::uint32_t)groups.size();
+			nodes.resize(child + groups.size());
+			for (size_t k = 0; k < groups.size(); ++k) {
+				// The group's common prefix is that of its first and last names.
+				auto low = names[groups[k].first];
+				auto high = names[groups[k].second - 1];
+				size_t end = depth + 1;
+				size_t limit = std::min(low.size(), high.size());
+				while (end < limit && low[end] == high[end]) {
+					++end;
+				}
+				auto& entry = nodes[child + k];
+				entry.label_offset = (std::uint32_t)labels.size();
+				entry.label_length = (std::uint32_t)(end - depth);
+				entry.first_child = 0;
+				entry.child_count = 0;
+				entry.terminal = false;
+				labels.append(low.substr(depth, end - depth));
+				build_below(names, child + k, groups[k].first, groups[k].second, end);
+			}
+		}
+
+		bool IdentityTree::descend(StringIdentity prefix, size_t& node, std::string& path) const {
+			node = 0;
+			path.clear();
+			while (path.size() < prefix.size()) {
+				auto& parent = nodes[node];
+				auto byte = (unsigned char)prefix[path.size()];
+				auto begin = nodes.begin() + parent.first_child;
+				auto end = begin + parent.child_count;
+				auto child = std::lower_bound(begin, end, byte,
+					[this](const Node& candidate, unsigned char byte) {
+						return (unsigned char)labels[candidate.label_offset] < byte;
+					});
+				if (child == end || (unsigned char)labels[child->label_offset] != byte) {
+					return false;
+				}
+				auto edge = label(*child);
+				auto rest = prefix.substr(path.size());
+				auto common = std::min(edge.size(), rest.size());
+				if (edge.substr(0, common) != rest.substr(0, common)) {
+					return false;
+				}
+				path.append(edge);
+				node = (size_t)(child - nodes.begin());
+			}
+			return true;
+		}
+
+		void IdentityTree::list(size_t node, std::string& path,
+			const EnumerationFunction& callback) const {
+			auto& current = nodes[node];
+			if (current.terminal) {
+				callback(path);
+			}
+			auto length = path.size();
+			for (size_t child = current.first_child; child < current.first_child + current.child_count; ++child) {
+				path.append(label(nodes[child]));
+				list(child, path, callback);
+				path.resize(length);
+			}
+		}
+
+		void IdentityTree::match(size_t node, std::string& path, const GlobPattern::State& state,
+			const GlobPattern& pattern, const EnumerationFunction& callback) const {
+			auto& current = nodes[node];
+			if (current.terminal && pattern.accepts(state)) {
+				callback(path);
+			}
+			auto length = path.size();
+			GlobPattern::State next;
+			GlobPattern::State scratch;
+			for (size_t child = current.first_child; child < current.first_child + current.child_count; ++child) {
+				// Skip the whole branch once no pattern position survives.
+				auto edge = label(nodes[child]);
+				next = state;
+				bool alive = true;
+				for (char c : edge) {
+					if (!pattern.advance(next, c, scratch)) {
+						alive = false;
+						break;
+					}
+					next.swap(scratch);
+				}
+				if (!alive) {
+					continue;
+				}
+				path.append(edge);
+				match(child, path, next, pattern, callback);
+				path.resize(length);
+			}
+		}
+
+		void IdentityTree::find_prefix(StringIdentity prefix, const EnumerationFunction& callback) const {
+			size_t node = 0;
+			std::string path;
+			if (descend(prefix, node, path)) {
+				list(node, path, callback);
+			}
+		}
+
+		void IdentityTree::find_glob(const GlobPattern& pattern, const EnumerationFunction& callback) const {
+			size_t node = 0;
+			std::string path;
+			if (!descend(pattern.get_literal_prefix(), node, path)) {
+				return;
+			}
+			// `path` may run past the literal prefix (into a wildcard).
+			auto state = pattern.start();
+			GlobPattern::State next;
+			for (char c : path) {
+				if (!pattern.advance(state, c, next)) {
+					return;
+				}
+				state.swap(next);
+			}
+			match(node, path, state, pattern, callback);
+		}
+
+		IdentityTreePointer IdentityTree::create(std::vector<StringIdentity> names) {
+			std::sort(names.begin(), names.end());
+			names.erase(std::unique(names.begin(), names.end()), names.end());
+
+			auto tree = std::make_shared<IdentityTree>();
+			tree->identity_count = names.size();
+			tree->nodes.push_back(Node{ 0, 0, 0, 0, false });
+			tree->build_below(names, 0, 0, names.size(), 0);
+			tree->nodes.shrink_to_fit();
+			tree->labels.shrink_to_fit();
+			return tree;
+		}
+
+		IdentityTreePointer IdentityTree::build(FileSystem& filesystem) {
+			NameArena arena;
+			std::vector<StringIdentity> names;
+			bool enumerated = filesystem.enumerate([&arena, &names](StringIdentity name) {
+				names.push_back(arena.store(name));
+			});
+			if (!enumerated) {
+				return nullptr;
+			}
+			return create(std::move(names));
+		}
+	}
+}
@@ -0,0 +1,431 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/MountIndex.hpp>
+
+#include <algorithm>
+#include <functional>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Maps each mount to its position in the stack.
+			std::unordered_map<const FileSystem*, size_t> rank_stack(
+				const std::vector<FileSystemPointer>& stack) {
+				std::unordered_map<const FileSystem*, size_t> ranks;
+				for (size_t i = 0; i < stack.size(); ++i) {
+					ranks[stack[i].get()] = i;
+				}
+				return ranks;
+			}
+		}
+
+		void MountIndex::merge(const FileSystemPointer& mountable,
+			const std::unordered_map<const FileSystem*, size_t>& ranks) {
+			// Stamped first: whatever changes during or after enumeration
+			// then fails the stamp check when the saved index is loaded.
+			std::string stamp;
+			bool stamped = mountable->get_stamp(stamp);
+
+			// Collect first: a failed enumeration must not leave partial entries.
+			// (Names are packed into one arena rather than a string each.)
+			NameArena arena;
+			std::vector<StringIdentity> names;
+			bool enumerated = mountable->enumerate([&arena, &names](StringIdentity name) {
+				names.push_back(arena.store(name));
+			});
+			if (!enumerated) {
+				opaque.insert(mountable.get());
+				return;
+			}
+			if (stamped) {
+				stamps[mountable.get()] = std::make_shared<const std::string>(std::move(stamp));
+			}
+
+			for (auto name : names) {
+				place(name, mountable, ranks);
+			}
+		}
+
+		void MountIndex::place(StringIdentity identity, const FileSystemPointer& mountable,
+			const std::unordered_map<const FileSystem*, size_t>& ranks) {
+			auto rank = ranks.at(mountable.get());
+			auto& list = modify(identity);
+
+			// Keep the list ordered by priority (highest first).
+			auto position = list.begin();
+			while (position != list.end() && ranks.at(position->get()) > rank) {
+				++position;
+			}
+			if (position != list.end() && *position == mountable) {
+				return; // Duplicate name from the same mount.
+			}
+			list.insert(position, mountable);
+		}
+
+		void MountIndex::build(const std::vector<FileSystemPointer>& stack) {
+			clear();
+			auto ranks = rank_stack(stack);
+			for (auto& mountable : stack) {
+				merge(mountable, ranks);
+			}
+		}
+
+		void MountIndex::insert(const std::vector<FileSystemPointer>& stack,
+			const FileSystemPointer& mountable) {
+			merge(mountable, rank_stack(stack));
+		}
+
+		void MountIndex::erase(const FileSystemPointer& mountable) {
+			for (auto& mount : mapped_mounts) {
+				if (mount == mountable) {
+					mount = nullptr;
+				}
+			}
+			stamps.erase(mountable.get());
+			if (opaque.erase(mountable.get()) != 0) {
+				return;
+			}
+			const std::uint32_t* positions = nullptr;
+			size_t count = 0;
+			for (size_t shard = 0; shard < providers.size(); ++shard) {
+				// Shards the mount provides nothing in stay shared.
+				bool affected = false;
+				if (providers[shard] != nullptr) {
+					for (auto& entry : *providers[shard]) {
+						auto& list = entry.second;
+						if (std::find(list.begin(), list.end(), mountable) != list.end()) {
+							affected = true;
+							break;
+						}
+					}
+				}
+				if (!affected) {
+					continue;
+				}
+				auto& map = writable(shard);
+				for (auto entry = map.begin(); entry != map.end(); ) {
+					auto& list = entry->second;
+					for (auto provider = list.begin(); provider != list.end(); ++provider) {
+						if (*provider == mountable) {
+							list.erase(provider);
+							break;
+						}
+					}
+					bool hides_mapped = (mapped != nullptr) && mapped->find(entry->first, positions, count);
+					if (list.empty() && !hides_mapped) {
+						entry = map.erase(entry);
+					} else {
+						++entry;
+					}
+				}
+				map.shrink();
+			}
+		}
+
+		void MountIndex::add(const std::vector<FileSystemPointer>& stack,
+			StringIdentity identity, const FileSystemPointer& mountable) {
+			if (opaque.count(mountable.get()) != 0) {
+				return;
+			}
+			place(identity, mountable, rank_stack(stack));
+		}
+
+		void MountIndex::remove(StringIdentity identity, const FileSystemPointer& mountable) {
+			auto& list = modify(identity);
+			for (auto provider = list.begin(); provider != list.end(); ++provider) {
+				if (*provider == mountable) {
+					list.erase(provider);
+					break;
+				}
+			}
+			drop_if_empty(identity);
+		}
+
+		void MountIndex::clear() {
+			providers.clear();
+			opaque.clear();
+			stamps.clear();
+			mapped = nullptr;
+			mapped_mounts.clear();
+		}
+
+		size_t MountIndex::shard_of(StringIdentity identity) {
+			return std::hash<StringIdentity>()(identity) % SHARD_COUNT;
+		}
+
+		const std::vector<FileSystemPointer>* MountIndex::find_providers(StringIdentity identity) const {
+			if (providers.empty()) {
+				return nullptr;
+			}
+			auto& shard = providers[shard_of(identity)];
+			if (shard == nullptr) {
+				return nullptr;
+			}
+			auto entry = shard->find(identity);
+			return (entry == shard->end()) ? nullptr : &entry->second;
+		}
+
+		MountIndex::ProviderMap& MountIndex::writable(size_t shard) {
+			if (providers.empty()) {
+				providers.resize(SHARD_COUNT);
+			}
+			auto& map = providers[shard];
+			if (map == nullptr) {
+				map = std::make_shared<ProviderMap>();
+			} else if (map.use_count() > 1) {
+				map = std::make_shared<ProviderMap>(*map);
+			}
+			return *map;
+		}
+
+		bool MountIndex::mapped_providers(StringIdentity identity,
+			std::vector<FileSystemPointer>& list) const {
+			list.clear();
+			const std::uint32_t* positions = nullptr;
+			size_t count = 0;
+			if (mapped == nullptr || !mapped->find(identity, positions, count)) {
+				return false;
+			}
+			for (size_t i = 0; i < count; ++i) {
+				if (mapped_mounts[positions[i]] != nullptr) {
+					list.push_back(mapped_mounts[positions[i]]);
+				}
+			}
+			return true;
+		}
+
+		std::vector<FileSystemPointer>& MountIndex::modify(StringIdentity identity) {
+			auto& map = writable(shard_of(identity));
+			auto entry = map.find(identity);
+			if (entry != map.end()) {
+				return entry->second;
+			}
+			auto& list = map[identity];
+			mapped_providers(identity, list);
+			return list;
+		}
+
+		void MountIndex::drop_if_empty(StringIdentity identity) {
+			auto list = find_providers(identity);
+			if (list == nullptr || !list->empty()) {
+				return;
+			}
+			// An empty list still hides the file's entry.
+			const std::uint32_t* positions = nullptr;
+			size_t count = 0;
+			if (mapped != nullptr && mapped->find(identity, positions, count)) {
+				return;
+			}
+			auto& map = writable(shard_of(identity));
+			map.erase(identity);
+			map.shrink();
+		}
+
+		size_t MountIndex::size() const {
+			size_t total = 0;
+			for (auto& shard : providers) {
+				if (shard == nullptr) {
+					continue;
+				}
+				for (auto& entry : *shard) {
+					total += entry.second.empty() ? 0 : 1;
+				}
+			}
+			if (mapped != nullptr) {
+				mapped->for_each([this, &total](StringIdentity identity,
+					const std::uint32_t* positions, size_t count) {
+					if (find_providers(identity) != nullptr) {
+						return;
+					}
+					for (size_t i = 0; i < count; ++i) {
+						if (mapped_mounts[positions[i]] != nullptr) {
+							++total;
+							return;
+						}
+					}
+				});
+			}
+			return total;
+		}
+
+		bool MountIndex::save(const std::vector<FileSystemPointer>& stack,
+			const std::filesystem::path& path) const {
+			auto ranks = rank_stack(stack);
+			std::vector<MountIndexFile::MountRecord> records(stack.size());
+			for (size_t i = 0; i < stack.size(); ++i) {
+				records[i].path = stack[i]->get_path().generic_string();
+				auto stamp = stamps.find(stack[i].get());
+				records[i].indexed = (opaque.count(stack[i].get()) == 0) && stamp != stamps.end();
+				if (records[i].indexed) {
+					records[i].stamp = *stamp->second;
+				}
+			}
+
+			// Only providers whose mount was stamped are saved.
+			std::vector<MountIndexFile::Entry> entries;
+			auto save_entry = [&ranks, &records, &entries](StringIdentity identity,
+				const std::vector<FileSystemPointer>& list) {
+				MountIndexFile::Entry entry{ identity, {} };
+				for (auto& provider : list) {
+					auto rank = ranks.find(provider.get());
+					if (rank != ranks.end() && records[rank->second].indexed) {
+						entry.positions.push_back((std::uint32_t)rank->second);
+					}
+				}
+				if (!entry.positions.empty()) {
+					entries.push_back(std::move(entry));
+				}
+			};
+			for (auto& shard : providers) {
+				if (shard == nullptr) {
+					continue;
+				}
+				for (auto& entry : *shard) {
+					save_entry(entry.first, entry.second);
+				}
+			}
+			if (mapped != nullptr) {
+				std::vector<FileSystemPointer> list;
+				mapped->for_each([this, &list, &save_entry](StringIdentity identity,
+					const std::uint32_t*, size_t) {
+					if (find_providers(identity) != nullptr) {
+						return;
+					}
+					mapped_providers(identity, list);
+					save_entry(identity, list);
+				});
+			}
+			return MountIndexFile::write(path, records, entries);
+		}
+
+		bool MountIndex::load(const std::vector<FileSystemPointer>& stack,
+			const MountIndexFilePointer& file) {
+			if (file == nullptr || file->mount_count() != stack.size()) {
+				return false;
+			}
+			for (size_t i = 0; i < stack.size(); ++i) {
+				if (file->mount_path(i) != stack[i]->get_path().generic_string()) {
+					return false;
+				}
+			}
+			clear();
+			mapped = file;
+			mapped_mounts.assign(stack.size(), nullptr);
+			for (size_t i = 0; i < stack.size(); ++i) {
+				if (file->mount_indexed(i) && stack[i]->check_stamp(file->mount_stamp(i))) {
+					mapped_mounts[i] = stack[i];
+					stamps[stack[i].get()] = std::make_shared<const std::string>(file->mount_stamp(i));
+				} else {
+					opaque.insert(stack[i].get());
+				}
+			}
+			return true;
+		}
+
+		FilePointer MountIndex::resolve(const std::vector<FileSystemPointer>& stack,
+			StringIdentity identity, FileSystemPointer& owner,
+			std::vector<FileSystemPointer>* stale) const {
+			owner = nullptr;
+			auto probe = [&identity, &owner, stale](const FileSystemPointer& mount, bool listed) {
+				auto file = mount->get_file(identity);
+				if (file != nullptr) {
+					owner = mount;
+				} else if (listed && stale != nullptr && mount->lacks(identity)) {
+					stale->push_back(mount);
+				}
+				return file;
+			};
+			auto list = find_providers(identity);
+
+			// Fast path: every mount is indexed, so only providers matter.
+			if (opaque.empty()) {
+				if (list != nullptr) {
+					for (auto& provider : *list) {
+						if (auto file = probe(provider, true)) {
+							return file;
+						}
+					}
+					return nullptr;
+				}
+				// Straight from the loaded file (no copy of the list).
+				const std::uint32_t* positions = nullptr;
+				size_t count = 0;
+				if (mapped != nullptr && mapped->find(identity, positions, count)) {
+					for (size_t i = 0; i < count; ++i) {
+						auto& provider = mapped_mounts[positions[i]];
+						if (provider == nullptr) {
+							continue;
+						}
+						if (auto file = probe(provider, true)) {
+							return file;
+						}
+					}
+				}
+				return nullptr;
+			}
+
+			// Slow path: opaque mounts interleave with the providers.
+			// The provider list is in stack order, so it is consumed in step.
+			std::vector<FileSystemPointer> loaded;
+			if (list == nullptr && mapped_providers(identity, loaded)) {
+				list = &loaded;
+			}
+			size_t next = 0;
+			for (auto mount = stack.rbegin(); mount != stack.rend(); ++mount) {
+				bool listed = false;
+				if (list != nullptr && next < list->size() && (*list)[next] == *mount) {
+					listed = true;
+					++next;
+				}
+				if (!listed && opaque.count(mount->get()) == 0) {
+					continue;
+				}
+				if (auto file = probe(*mount, listed)) {
+					return file;
+				}
+			}
+			return nullptr;
+		}
+
+		bool MountIndex::enumerate(const EnumerationFunction& callback) const {
+			if (!opaque.empty()) {
+				return false;
+			}
+			for (auto& shard : providers) {
+				if (shard == nullptr) {
+					continue;
+				}
+				for (auto& entry : *shard) {
+					if (!entry.second.empty()) {
+						callback(entry.first);
+					}
+				}
+			}
+			if (mapped != nullptr) {
+				mapped->for_each([this, &callback](StringIdentity identity,
+					const std::uint32_t* positions, size_t count) {
+					if (find_providers(identity) != nullptr) {
+						return;
+					}
+					for (size_t i = 0; i < count; ++i) {
+						if (mapped_mounts[positions[i]] != nullptr) {
+							callback(identity);
+							return;
+						}
+					}
+				});
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/MountIndexFile.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+
+#include <cstring>
+#include <fstream>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// File signature.
+			const char MAGIC[8] = { 'R', 'S', 'G', 'F', 'S', 'M', 'I', 'X' };
+
+			/// Written as-is; read back differently on another byte order.
+			const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+			/// Marks an empty slot (`Slot::identity_length`).
+			const std::uint32_t EMPTY_SLOT = 0xffffffff;
+
+			/// File header.
+			struct Header {
+				char magic[8];
+				std::uint32_t version;
+				std::uint32_t byte_order;
+				std::uint64_t file_size;
+				std::uint32_t mount_count;
+				std::uint32_t slot_count;
+				std::uint64_t identity_count;
+				std::uint64_t mounts_offset;
+				std::uint64_t slots_offset;
+				std::uint64_t providers_offset;
+				std::uint64_t provider_count;
+				std::uint64_t strings_offset;
+				std::uint64_t strings_size;
+			};
+
+			/// Saved mount.
+			struct Mount {
+				std::uint64_t path_offset;
+				std::uint64_t stamp_offset;
+				std::uint32_t path_length;
+				std::uint32_t stamp_length;
+				std::uint32_t indexed;
+				std::uint32_t reserved;
+			};
+
+			/**
+			 * @brief Identity slot.
+			 *
+			 * `providers` indexes the provider section, where a count is
+			 * followed by that many mount positions.
+			 */
+			struct Slot {
+				std::uint64_t hash;
+				std::uint64_t identity_offset;
+				std::uint32_t identity_length;
+				std::uint32_t providers;
+			};
+
+			/// Rounds up to a multiple of 8 (sections stay aligned).
+			std::uint64_t align(std::uint64_t offset) {
+				return (offset + 7) & ~(std::uint64_t)7;
+			}
+
+			/// Whether [offset, offset + size) lies within `limit`.
+			bool within(std::uint64_t offset, std::uint64_t size, std::uint64_t limit) {
+				return offset <= limit && size <= limit - offset;
+			}
+		}
+
+		StringIdentity MountIndexFile::read_string(std::uint64_t offset, std::uint64_t length) const {
+			if (!within(offset, length, string_total)) {
+				return StringIdentity();
+			}
+			return StringIdentity(strings + offset, (size_t)length);
+		}
+
+		StringIdentity MountIndexFile::mount_path(size_t position) const {
+			Mount mount;
+			memcpy(&mount, mounts + position * sizeof(Mount), sizeof(Mount));
+			return read_string(mount.path_offset, mount.path_length);
+		}
+
+		StringIdentity MountIndexFile::mount_stamp(size_t position) const {
+			Mount mount;
+			memcpy(&mount, mounts + position * sizeof(Mount), sizeof(Mount));
+			return read_string(mount.stamp_offset, mount.stamp_length);
+		}
+
+		bool MountIndexFile::mount_indexed(size_t position) const {
+			Mount mount;
+			memcpy(&mount, mounts + position * sizeof(Mount), sizeof(Mount));
+			return mount.indexed != 0;
+		}
+
+		bool MountIndexFile::read_slot(std::uint32_t slot, StringIdentity& identity,
+			const std::uint32_t*& positions, size_t& count) const {
+			auto entry = (const Slot*)(slots + (size_t)slot * sizeof(Slot));
+			if (entry->identity_length == EMPTY_SLOT ||
+				!within(entry->identity_offset, entry->identity_length, string_total) ||
+				entry->providers >= provider_total) {
+				return false;
+			}
+			std::uint64_t total = providers[entry->providers];
+			if (!within(entry->providers + 1, total, provider_total)) {
+				return false;
+			}
+			identity = StringIdentity(strings + entry->identity_offset, entry->identity_length);
+			positions = providers + entry->providers + 1;
+			count = (size_t)total;
+			for (size_t i = 0; i < count; ++i) {
+				if (positions[i] >= mount_total) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		bool MountIndexFile::find(StringIdentity identity, const std::uint32_t*& positions,
+			size_t& count) const {
+			if (slot_total == 0) {
+				return false;
+			}
+			auto hash = fnv1a(identity.data(), identity.size());
+			auto mask = slot_total - 1;
+			for (std::uint32_t probe = 0, slot = (std::uint32_t)hash & mask; probe < slot_total;
+				++probe, slot = (slot + 1) & mask) {
+				auto entry = (const Slot*)(slots + (size_t)slot * sizeof(Slot));
+				if (entry->identity_length == EMPTY_SLOT) {
+					return false;
+				}
+				if (entry->hash != hash || entry->identity_length != identity.size()) {
+					continue;
+				}
+				StringIdentity saved;
+				if (read_slot(slot, saved, positions, count) && saved == identity) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void MountIndexFile::for_each(const EntryFunction& callback) const {
+			StringIdentity identity;
+			const std::uint32_t* positions = nullptr;
+			size_t count = 0;
+			for (std::uint32_t slot = 0; slot < slot_total; ++slot) {
+				if (read_slot(slot, identity, positions, count)) {
+					callback(identity, positions, count);
+				}
+			}
+		}
+
+		MountIndexFilePointer MountIndexFile::open(const std::filesystem::path& path) {
+			auto file = storage::File::create(path);
+			if (file == nullptr || file->get_size() < sizeof(Header)) {
+				return nullptr;
+			}
+			std::uint64_t size = file->get_size();
+			auto view = file->get_view(0, size);
+			if (view == nullptr) {
+				return nullptr;
+			}
+			auto data = (const char*)view->get_data_pointer();
+
+			// Header and section bounds only; entries are checked as read.
+			Header header;
+			memcpy(&header, data, sizeof(Header));
+			if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+				header.version != FORMAT_VERSION ||
+				header.byte_order != BYTE_ORDER_MARK ||
+				header.file_size != size) {
+				return nullptr;
+			}
+			if ((header.slot_count & (header.slot_count - 1)) != 0 ||
+				header.identity_count > header.slot_count ||
+				(header.mounts_offset | header.slots_offset | header.providers_offset) % 8 != 0 ||
+				!within(header.mounts_offset, (std::uint64_t)header.mount_count * sizeof(Mount), size) ||
+				!within(header.slots_offset, (std::uint64_t)header.slot_count * sizeof(Slot), size) ||
+				header.provider_count > size / sizeof(std::uint32_t) ||
+				!within(header.providers_offset, header.provider_count * sizeof(std::uint32_t), size) ||
+				!within(header.strings_offset, header.strings_size, size)) {
+				return nullptr;
+			}
+
+			auto index = std::make_shared<MountIndexFile>();
+			index->file = file;
+			index->view = view;
+			index->data = data;
+			index->mounts = data + header.mounts_offset;
+			index->slots = data + header.slots_offset;
+			index->providers = (const std::uint32_t*)(data + header.providers_offset);
+			index->strings = data + header.strings_offset;
+			index->mount_total = header.mount_count;
+			index->slot_total = header.slot_count;
+			index->provider_total = header.provider_count;
+			index->string_total = header.strings_size;
+			index->identity_total = header.identity_count;
+			return index;
+		}
+
+		bool MountIndexFile::write(const std::filesystem::path& path,
+			const std::vector<MountRecord>& mount_records, const std::vector<Entry>& entries) {
+			// Strings and provider lists first; their offsets go in the records.
+			std::string string_section;
+			std::vector<std::uint32_t> provider_section;
+			std::vector<Mount> mount_section;
+			mount_section.reserve(mount_records.size());
+			for (auto& record : mount_records) {
+				Mount mount = {};
+				mount.path_offset = string_section.size();
+				mount.path_length = (std::uint32_t)record.path.size();
+				string_section.append(record.path);
+				mount.stamp_offset = string_section.size();
+				mount.stamp_length = (std::uint32_t)record.stamp.size();
+				string_section.append(record.stamp);
+				mount.indexed = record.indexed ? 1 : 0;
+				mount_section.push_back(mount);
+			}
+
+			// At most half full, so probe sequences stay short.
+			std::uint32_t slot_count = 2;
+			while (slot_count < entries.size() * 2) {
+				slot_count *= 2;
+			}
+			Slot empty = {};
+			empty.identity_length = EMPTY_SLOT;
+			std::vector<Slot> slot_section(slot_count, empty);
+			for (auto& entry : entries) {
+				Slot slot = {};
+				slot.hash = fnv1a(entry.identity.data(), entry.identity.size());
+				slot.identity_offset = string_section.size();
+				slot.identity_length = (std::uint32_t)entry.identity.size();
+				string_section.append(entry.identity);
+				slot.providers = (std::uint32_t)provider_section.size();
+				provider_section.push_back((std::uint32_t)entry.positions.size());
+				provider_section.insert(provider_section.end(), entry.positions.begin(), entry.positions.end());
+
+				auto position = (std::uint32_t)slot.hash & (slot_count - 1);
+				while (slot_section[position].identity_length != EMPTY_SLOT) {
+					position = (position + 1) & (slot_count - 1);
+				}
+				slot_section[position] = slot;
+			}
+
+			Header header = {};
+			memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = FORMAT_VERSION;
+			header.byte_order = BYTE_ORDER_MARK;
+			header.mount_count = (std::uint32_t)mount_section.size();
+			header.slot_count = slot_count;
+			header.identity_count = entries.size();
+			header.mounts_offset = align(sizeof(Header));
+			header.slots_offset = align(header.mounts_offset + mount_section.size() * sizeof(Mount));
+			header.providers_offset = align(header.slots_offset + slot_section.size() * sizeof(Slot));
+			header.provider_count = provider_section.size();
+			header.strings_offset = header.providers_offset + provider_section.size() * sizeof(std::uint32_t);
+			header.strings_size = string_section.size();
+			header.file_size = header.strings_offset + header.strings_size;
+
+			std::vector<char> buffer((size_t)header.file_size, 0);
+			memcpy(buffer.data(), &header, sizeof(Header));
+			if (!mount_section.empty()) {
+				memcpy(buffer.data() + header.mounts_offset, mount_section.data(), mount_section.size() * sizeof(Mount));
+			}
+			memcpy(buffer.data() + header.slots_offset, slot_section.data(), slot_section.size() * sizeof(Slot));
+			if (!provider_section.empty()) {
+				memcpy(buffer.data() + header.providers_offset, provider_section.data(),
+					provider_section.size() * sizeof(std::uint32_t));
+			}
+			if (!string_section.empty()) {
+				memcpy(buffer.data() + header.strings_offset, string_section.data(), string_section.size());
+			}
+
+			// Written aside and renamed over, so readers never see half a file.
+			auto temporary = path;
+			temporary += ".tmp";
+			{
+				std::ofstream strm(temporary, std::ios::binary | std::ios::trunc);
+				if (!strm.write(buffer.data(), (std::streamsize)buffer.size())) {
+					return false;
+				}
+			}
+			std::error_code error;
+			std::filesystem::rename(temporary, path, error);
+			if (error) {
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+			return true;
+		}
+	}
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/PackArchive.hpp>
+#include <ReversingSpace/GameFileSystem/ArchiveEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/CompressedEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityFilter.hpp>
+
+#include <cstring>
+
+namespace reversingspace {
+	namespace gfs {
+		const char PackArchive::MAGIC[8] = { 'R', 'S', 'G', 'F', 'S', 'P', 'A', 'K' };
+
+		namespace {
+			/// Whether [offset, offset + size) lies within `limit`.
+			bool within(std::uint64_t offset, std::uint64_t size, std::uint64_t limit) {
+				return offset <= limit && size <= limit - offset;
+			}
+		}
+
+		const PackArchive::Entry* PackArchive::find_entry(HashedIdentity identity) const {
+			if (entry_total == 0) {
+				return nullptr;
+			}
+			auto seed = seeds[bucket_of(identity, bucket_total)];
+			auto entry = entries + slot_of(identity, seed, entry_total);
+			if (entry->hash != identity || !within(entry->offset, entry->stored_size, data_size)) {
+				return nullptr;
+			}
+			return entry;
+		}
+
+		StringIdentity PackArchive::read_name(const Entry& entry) const {
+			if (!within(entry.name_offset, entry.name_length, name_total)) {
+				return StringIdentity();
+			}
+			return StringIdentity(names + entry.name_offset, entry.name_length);
+		}
+
+		FilePointer PackArchive::open_entry(const Entry& entry) const {
+			if ((entry.flags & ENTRY_COMPRESSED) != 0) {
+				auto file = CompressedEntryFile::create(view, entry.offset, entry.stored_size, entry.size, block_size);
+				if (file != nullptr) {
+					file->set_worker_pool(pool);
+				}
+				return file;
+			}
+			if (entry.stored_size != entry.size) {
+				return nullptr;
+			}
+			return std::make_shared<ArchiveEntryFile>(view, data + entry.offset, entry.size);
+		}
+
+		std::filesystem::path PackArchive::get_path() const {
+			return file->get_path();
+		}
+
+		FilePointer PackArchive::get_file(HashedIdentity identity, storage::FileAccess access) {
+			if (access != storage::FileAccess::Read) {
+				return nullptr;
+			}
+			auto entry = find_entry(identity);
+			return (entry == nullptr) ? nullptr : open_entry(*entry);
+		}
+
+		FilePointer PackArchive::get_file(StringIdentity identity, storage::FileAccess access) {
+			if (access != storage::FileAccess::Read) {
+				return nullptr;
+			}
+			auto entry = find_entry(fnv1a(identity.data(), identity.size()));
+			if (entry == nullptr || read_name(*entry) != identity) {
+				return nullptr;
+			}
+			return open_entry(*entry);
+		}
+
+		bool PackArchive::enumerate(const EnumerationFunction& callback) {
+			for (std::uint32_t slot = 0; slot < entry_total; ++slot) {
+				auto name = read_name(entries[slot]);
+				if (!name.empty()) {
+					callback(name);
+				}
+			}
+			return true;
+		}
+
+		IdentityFilterPointer PackArchive::build_identity_filter() {
+			return IdentityFilter::build(*this, default_hash_function());
+		}
+
+		PackArchivePointer PackArchive::open(const storage::FilePointer& file) {
+			if (file == nullptr || file->get_size() < sizeof(Header)) {
+				return nullptr;
+			}
+			std::uint64_t size = file->get_size();
+			auto view = file->get_view(0, size);
+			if (view == nullptr) {
+				return nullptr;
+			}
+			auto data = (const char*)view->get_data_pointer();
+
+			// Header and section bounds only; entries are checked as read.
+			Header header;
+			memcpy(&header, data, sizeof(Header));
+			if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+				header.version != FORMAT_VERSION ||
+				header.byte_order != BYTE_ORDER_MARK ||
+				header.file_size != size) {
+				return nullptr;
+			}
+			if (header.block_size != 0 && (header.block_size & (header.block_size - 1)) != 0) {
+				return nullptr;
+			}
+			if (header.alignment == 0 || (header.alignment & (header.alignment - 1)) != 0 ||
+				(header.entry_count != 0 && header.bucket_count == 0) ||
+				(header.seeds_offset | header.entries_offset) % 8 != 0 ||
+				!within(header.seeds_offset, (std::uint64_t)header.bucket_count * sizeof(std::uint32_t), size) ||
+				!within(header.entries_offset, (std::uint64_t)header.entry_count * sizeof(Entry), size) ||
+				!within(header.names_offset, header.names_size, size)) {
+				return nullptr;
+			}
+
+			auto archive = std::make_shared<PackArchive>();
+			archive->file = file;
+			archive->view = view;
+			archive->data = data;
+			archive->data_size = size;
+			archive->block_size = header.block_size;
+			archive->seeds = (const std::uint32_t*)(data + header.seeds_offset);
+			archive->entries = (const Entry*)(data + header.entries_offset);
+			archive->names = data + header.names_offset;
+			archive->entry_total = header.entry_count;
+			archive->bucket_total = header.bucket_count;
+			archive->name_total = header.names_size;
+			return archive;
+		}
+
+		PackArchivePointer PackArchive::open(const std::filesystem::path& path) {
+			return open(storage::File::create(path));
+		}
+	}
+}
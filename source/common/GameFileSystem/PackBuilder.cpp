@@ -0,0 +1,623 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/PackBuilder.hpp>
+#include <ReversingSpace/GameFileSystem/DirectoryListing.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+#include <ReversingSpace/GameFileSystem/PackArchive.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+namespace reversingspace {
+	namespace gfs {
+		namespace {
+			/// Average entries per bucket (more: smaller seed table, slower builds).
+			const std::uint32_t ENTRIES_PER_BUCKET = 4;
+
+			/// Seeds tried per bucket before giving up.
+			const std::uint32_t SEED_LIMIT = 1u << 24;
+
+			/// Size of the pieces sources are hashed, compared and streamed in.
+			const std::uint64_t CHUNK_SIZE = 1 << 20;
+
+			/// Most bytes read ahead at once (larger entries are streamed).
+			const std::uint64_t BATCH_SIZE = 32 << 20;
+
+			/// Rounds `offset` up to a multiple of `alignment` (a power of two).
+			std::uint64_t align(std::uint64_t offset, std::uint64_t alignment) {
+				return (offset + alignment - 1) & ~(alignment - 1);
+			}
+
+			/**
+			 * @brief Hashes one chunk of content (a deduplication key, not a name hash).
+			 *
+			 * Four independent lanes over 64-bit words, so the hash keeps up
+			 * with the disk; matches are confirmed byte for byte anyway.
+			 */
+			std::uint64_t hash_chunk(const char* data, size_t size) {
+				std::uint64_t lanes[4] = { FNV1A_OFFSET_BASIS, FNV1A_PRIME, ~FNV1A_OFFSET_BASIS, ~FNV1A_PRIME };
+				size_t position = 0;
+				for (; position + 32 <= size; position += 32) {
+					for (int lane = 0; lane < 4; ++lane) {
+						std::uint64_t word;
+						memcpy(&word, data + position + lane * 8, 8);
+						lanes[lane] = (lanes[lane] ^ word) * 0x9e3779b97f4a7c15ull;
+						lanes[lane] = (lanes[lane] << 31) | (lanes[lane] >> 33);
+					}
+				}
+				std::uint64_t hash = fnv1a_extend(size, data + position, size - position);
+				for (auto lane : lanes) {
+					hash = PackArchive::mix(hash ^ lane);
+				}
+				return hash;
+			}
+
+			/// Reads part of a source (false if it cannot be read whole).
+			bool read_source(const std::filesystem::path& path,
+				const std::vector<std::uint8_t>& bytes, std::ifstream& strm,
+				std::uint64_t offset, char* out, std::uint64_t size) {
+				if (path.empty()) {
+					if (offset > bytes.size() || size > bytes.size() - offset) {
+						return false;
+					}
+					if (size != 0) {
+						memcpy(out, bytes.data() + offset, (size_t)size);
+					}
+					return true;
+				}
+				if (!strm.is_open()) {
+					strm.open(path, std::ios::binary);
+				}
+				strm.seekg((std::streamoff)offset);
+				return (bool)strm.read(out, (std::streamsize)size);
+			}
+
+			/// Writes `count` zero bytes.
+			bool pad(std::ofstream& strm, std::uint64_t count) {
+				static const char zeros[4096] = {};
+				while (count > 0) {
+					auto step = (std::streamsize)std::min<std::uint64_t>(count, sizeof(zeros));
+					if (!strm.write(zeros, step)) {
+						return false;
+					}
+					count -= (std::uint64_t)step;
+				}
+				return true;
+			}
+
+			/**
+			 * @brief Builds the minimal perfect hash (hash and displace).
+			 * @param[in] hashes   Hashed identities (unique).
+			 * @param[out] seeds   Seed per bucket.
+			 * @param[out] slots   Slot per identity.
+			 * @return false if a bucket could not be placed.
+			 *
+			 * Buckets are placed largest first, each trying seeds until
+			 * all of its identities land on free slots.
+			 */
+			bool build_hash(const std::vector<HashedIdentity>& hashes,
+				std::vector<std::uint32_t>& seeds, std::vector<std::uint32_t>& slots) {
+				auto count = (std::uint32_t)hashes.size();
+				auto bucket_count = std::max<std::uint32_t>(1,
+					(count + ENTRIES_PER_BUCKET - 1) / ENTRIES_PER_BUCKET);
+
+				// Members grouped by bucket (counting sort, no per-bucket vectors).
+				std::vector<std::uint32_t> starts(bucket_count + 1, 0);
+				std::vector<std::uint32_t> buckets(count);
+				for (std::uint32_t position = 0; position < count; ++position) {
+					buckets[position] = PackArchive::bucket_of(hashes[position], bucket_count);
+					++starts[buckets[position] + 1];
+				}
+				for (std::uint32_t bucket = 0; bucket < bucket_count; ++bucket) {
+					starts[bucket + 1] += starts[bucket];
+				}
+				std::vector<std::uint32_t> members(count);
+				{
+					auto fill = starts;
+					for (std::uint32_t position = 0; position < count; ++position) {
+						members[fill[buckets[position]]++] = position;
+					}
+				}
+				std::vector<std::uint32_t> order(bucket_count);
+				for (std::uint32_t bucket = 0; bucket < bucket_count; ++bucket) {
+					order[bucket] = bucket;
+				}
+				std::stable_sort(order.begin(), order.end(), [&starts](std::uint32_t a, std::uint32_t b) {
+					return starts[a + 1] - starts[a] > starts[b + 1] - starts[b];
+				});
+
+				seeds.assign(bucket_count, 0);
+				slots.assign(count, 0);
+				std::vector<bool> taken(count, false);
+				std::vector<std::uint32_t> trial;
+				for (auto bucket : order) {
+					auto first = members.begin() + starts[bucket];
+					auto last = members.begin() + starts[bucket + 1];
+					if (first == last) {
+						break;
+					}
+					bool placed = false;
+					for (std::uint32_t seed = 0; seed < SEED_LIMIT && !placed; ++seed) {
+						trial.clear();
+						placed = true;
+						for (auto member = first; member != last; ++member) {
+							auto slot = PackArchive::slot_of(hashes[*member], seed, count);
+							if (taken[slot] || std::find(trial.begin(), trial.end(), slot) != trial.end()) {
+								placed = false;
+								break;
+							}
+							trial.push_back(slot);
+						}
+						if (placed) {
+							seeds[bucket] = seed;
+							for (size_t i = 0; i < trial.size(); ++i) {
+								taken[trial[i]] = true;
+								slots[*(first + i)] = trial[i];
+							}
+						}
+					}
+					if (!placed) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/// Strips a trailing carriage return (manifests written on Windows).
+			void trim_line(std::string& line) {
+				if (!line.empty() && line.back() == '\r') {
+					line.pop_back();
+				}
+			}
+		}
+
+		PackBuilder::PackBuilder(): alignment(PackArchive::DEFAULT_ALIGNMENT),
+			block_size(CompressedEntryFile::DEFAULT_BLOCK_SIZE) {}
+
+		bool PackBuilder::set_alignment(std::uint32_t value) {
+			if (value == 0 || (value & (value - 1)) != 0) {
+				return false;
+			}
+			alignment = value;
+			return true;
+		}
+
+		bool PackBuilder::set_small_entries(std::uint64_t threshold, std::uint32_t value) {
+			if (value == 0 || (value & (value - 1)) != 0) {
+				return false;
+			}
+			small_threshold = threshold;
+			small_alignment = value;
+			return true;
+		}
+
+		bool PackBuilder::set_compression(bool enabled, std::uint32_t value) {
+			if (value < 4096 || value > (1u << 20) || (value & (value - 1)) != 0) {
+				return false;
+			}
+			compress = enabled;
+			block_size = value;
+			return true;
+		}
+
+		void PackBuilder::set_access_trace(std::vector<std::string> names) {
+			access_trace = std::move(names);
+		}
+
+		bool PackBuilder::load_access_trace(const std::filesystem::path& path) {
+			std::ifstream strm(path);
+			if (!strm) {
+				return false;
+			}
+			std::vector<std::string> names;
+			for (std::string line; std::getline(strm, line); ) {
+				trim_line(line);
+				if (!line.empty()) {
+					names.push_back(std::move(line));
+				}
+			}
+			access_trace = std::move(names);
+			return true;
+		}
+
+		void PackBuilder::add(StringIdentity name, const std::filesystem::path& path) {
+			Source source;
+			source.name = std::string(name);
+			source.path = path;
+			sources.push_back(std::move(source));
+		}
+
+		void PackBuilder::add(StringIdentity name, std::vector<std::uint8_t> bytes) {
+			Source source;
+			source.name = std::string(name);
+			source.bytes = std::move(bytes);
+			sources.push_back(std::move(source));
+		}
+
+		bool PackBuilder::add_directory(const std::filesystem::path& path, StringIdentity prefix) {
+			auto listing = DirectoryListing::scan(path, false, pool);
+			if (listing == nullptr) {
+				return false;
+			}
+			for (auto& entry : listing->get_entries()) {
+				if (entry.type == EntryType::File) {
+					auto name = std::string(prefix);
+					name.append(entry.name);
+					add(name, path / std::filesystem::path(std::string(entry.name)));
+				}
+			}
+			return true;
+		}
+
+		bool PackBuilder::add_manifest(const std::filesystem::path& path) {
+			std::ifstream strm(path);
+			if (!strm) {
+				return false;
+			}
+			auto base = path.parent_path();
+			for (std::string line; std::getline(strm, line); ) {
+				trim_line(line);
+				if (line.empty() || line[0] == '#') {
+					continue;
+				}
+				auto tab = line.find('\t');
+				auto name = line.substr(0, tab);
+				std::filesystem::path source = (tab == std::string::npos) ? name : line.substr(tab + 1);
+				add(name, source.is_absolute() ? source : base / source);
+			}
+			return true;
+		}
+
+		bool PackBuilder::write(const std::filesystem::path& path) const {
+			auto count = sources.size();
+			auto workers = pool.get();
+
+			// Content first (on the pool): sizes, and hashes to deduplicate by.
+			std::vector<std::uint64_t> sizes(count, 0);
+			std::vector<std::uint64_t> contents(count, 0);
+			std::vector<char> unreadable(count, 0);
+			ParallelLoop content_loop(workers, count, [this, &sizes, &contents, &unreadable](size_t position) {
+				auto& source = sources[position];
+				if (source.path.empty()) {
+					sizes[position] = source.bytes.size();
+				} else {
+					std::error_code error;
+					sizes[position] = std::filesystem::file_size(source.path, error);
+					if (error) {
+						unreadable[position] = 1;
+						return;
+					}
+				}
+				if (!deduplicate) {
+					return;
+				}
+				std::ifstream strm;
+				std::vector<char> chunk;
+				std::uint64_t hash = sizes[position];
+				for (std::uint64_t offset = 0; offset < sizes[position]; offset += CHUNK_SIZE) {
+					auto step = std::min(CHUNK_SIZE, sizes[position] - offset);
+					chunk.resize((size_t)step);
+					if (!read_source(source.path, source.bytes, strm, offset, chunk.data(), step)) {
+						unreadable[position] = 1;
+						return;
+					}
+					hash = PackArchive::mix(hash ^ hash_chunk(chunk.data(), (size_t)step));
+				}
+				contents[position] = hash;
+			});
+
+			// Names meanwhile (hashed, checked unique, placed by the perfect hash).
+			std::vector<HashedIdentity> hashes(count);
+			for (size_t position = 0; position < count; ++position) {
+				hashes[position] = fnv1a(sources[position].name.data(), sources[position].name.size());
+			}
+			{
+				auto sorted = hashes;
+				std::sort(sorted.begin(), sorted.end());
+				if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+					return false;
+				}
+			}
+			std::vector<std::uint32_t> seeds;
+			std::vector<std::uint32_t> slots;
+			if (!build_hash(hashes, seeds, slots)) {
+				return false;
+			}
+			content_loop.finish();
+			if (std::find(unreadable.begin(), unreadable.end(), 1) != unreadable.end()) {
+				return false;
+			}
+
+			// Data order: the access trace first, then the order added.
+			std::vector<size_t> order;
+			order.reserve(count);
+			{
+				IdentityMap<size_t> positions;
+				for (size_t position = 0; position < count; ++position) {
+					positions[sources[position].name] = position;
+				}
+				std::vector<char> ordered(count, 0);
+				for (auto& name : access_trace) {
+					auto found = positions.find(name);
+					if (found != positions.end() && !ordered[found->second]) {
+						ordered[found->second] = 1;
+						order.push_back(found->second);
+					}
+				}
+				for (size_t position = 0; position < count; ++position) {
+					if (!ordered[position]) {
+						order.push_back(position);
+					}
+				}
+			}
+
+			// Table of contents (in slot order) and names.
+			std::string names;
+			std::vector<PackArchive::Entry> entries(count);
+			for (size_t position = 0; position < count; ++position) {
+				auto& entry = entries[slots[position]];
+				entry.hash = hashes[position];
+				entry.name_offset = (std::uint32_t)names.size();
+				entry.name_length = (std::uint32_t)sources[position].name.size();
+				entry.size = sizes[position];
+				entry.stored_size = sizes[position];
+				names.append(sources[position].name);
+			}
+
+			PackArchive::Header header = {};
+			memcpy(header.magic, PackArchive::MAGIC, sizeof(PackArchive::MAGIC));
+			header.version = PackArchive::FORMAT_VERSION;
+			header.byte_order = PackArchive::BYTE_ORDER_MARK;
+			header.entry_count = (std::uint32_t)entries.size();
+			header.bucket_count = (std::uint32_t)seeds.size();
+			header.alignment = alignment;
+			header.seeds_offset = align(sizeof(header), 8);
+			header.entries_offset = align(header.seeds_offset + seeds.size() * sizeof(std::uint32_t), 8);
+			header.names_offset = header.entries_offset + entries.size() * sizeof(PackArchive::Entry);
+			header.names_size = names.size();
+
+			// Data, each distinct content stored once (matches confirmed byte for byte).
+			Statistics figures;
+			figures.entries = count;
+			std::vector<size_t> stored;
+			std::vector<size_t> twins(count, count);
+			std::unordered_map<std::uint64_t, std::vector<size_t>> by_content;
+			std::vector<char> left_chunk;
+			std::vector<char> right_chunk;
+			auto same = [this, &sizes, &left_chunk, &right_chunk](size_t left, size_t right) {
+				std::ifstream left_strm;
+				std::ifstream right_strm;
+				for (std::uint64_t at = 0; at < sizes[left]; at += CHUNK_SIZE) {
+					auto step = std::min(CHUNK_SIZE, sizes[left] - at);
+					left_chunk.resize((size_t)step);
+					right_chunk.resize((size_t)step);
+					auto& a = sources[left];
+					auto& b = sources[right];
+					if (!read_source(a.path, a.bytes, left_strm, at, left_chunk.data(), step) ||
+						!read_source(b.path, b.bytes, right_strm, at, right_chunk.data(), step) ||
+						memcmp(left_chunk.data(), right_chunk.data(), (size_t)step) != 0) {
+						return false;
+					}
+				}
+				return true;
+			};
+			for (auto position : order) {
+				figures.content_bytes += sizes[position];
+				if (deduplicate) {
+					auto& candidates = by_content[contents[position]];
+					auto match = std::find_if(candidates.begin(), candidates.end(),
+						[&sizes, &same, position](size_t candidate) {
+						return sizes[candidate] == sizes[position] && same(candidate, position);
+					});
+					if (match != candidates.end()) {
+						twins[position] = *match;
+						figures.deduplicated_bytes += sizes[position];
+						continue;
+					}
+					candidates.push_back(position);
+				}
+				stored.push_back(position);
+			}
+			figures.stored = stored.size();
+			if (compress) {
+				header.block_size = block_size;
+			}
+
+			// Written aside and renamed over, so readers never see half a file.
+			// Offsets depend on compressed sizes, so the header and table of
+			// contents are written again once the data is.
+			auto temporary = path;
+			temporary += ".tmp";
+			bool written = false;
+			{
+				std::ofstream strm(temporary, std::ios::binary | std::ios::trunc);
+				written = strm.write((const char*)&header, sizeof(header)) &&
+					pad(strm, header.seeds_offset - sizeof(header)) &&
+					strm.write((const char*)seeds.data(), (std::streamsize)(seeds.size() * sizeof(std::uint32_t))) &&
+					pad(strm, header.entries_offset - header.seeds_offset - seeds.size() * sizeof(std::uint32_t)) &&
+					strm.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PackArchive::Entry))) &&
+					strm.write(names.data(), (std::streamsize)names.size());
+				std::uint64_t written_size = header.names_offset + header.names_size;
+
+				// Batches of stored entries: the next is read (and compressed)
+				// on the pool while this one is written.  Entries too large
+				// for a batch are streamed on their own.
+				struct Batch {
+					size_t first = 0;
+					size_t last = 0;
+					bool streamed = false;
+					std::vector<std::vector<char>> buffers;
+					std::vector<char> failed;
+					std::vector<char> compressed;
+				};
+				auto next_batch = [this, &stored, &sizes](size_t first) {
+					Batch batch;
+					batch.first = first;
+					batch.last = first;
+					if (first < stored.size() && sizes[stored[first]] > BATCH_SIZE) {
+						batch.streamed = true;
+						batch.last = first + 1;
+						return batch;
+					}
+					std::uint64_t total = 0;
+					while (batch.last < stored.size() && sizes[stored[batch.last]] <= BATCH_SIZE &&
+						total + sizes[stored[batch.last]] <= BATCH_SIZE) {
+						total += sizes[stored[batch.last]];
+						++batch.last;
+					}
+					batch.buffers.resize(batch.last - batch.first);
+					batch.failed.assign(batch.last - batch.first, 0);
+					batch.compressed.assign(batch.last - batch.first, 0);
+					return batch;
+				};
+				auto read_batch = [this, &stored, &sizes, workers](Batch& batch) {
+					auto reading = &batch;
+					return std::make_unique<ParallelLoop>(workers, batch.buffers.size(),
+						[this, &stored, &sizes, reading](size_t item) {
+						auto position = stored[reading->first + item];
+						auto& source = sources[position];
+						auto& buffer = reading->buffers[item];
+						buffer.resize((size_t)sizes[position]);
+						std::ifstream strm;
+						if (!read_source(source.path, source.bytes, strm, 0, buffer.data(), sizes[position])) {
+							reading->failed[item] = 1;
+							return;
+						}
+						if (compress) {
+							// Kept only if it saves an eighth (else not worth decompressing).
+							std::vector<char> packed;
+							CompressedEntryFile::compress(buffer.data(), buffer.size(), block_size, packed);
+							if (packed.size() < buffer.size() - buffer.size() / 8) {
+								buffer.swap(packed);
+								reading->compressed[item] = 1;
+							}
+						}
+					});
+				};
+
+				// Places a stored entry after what has been written so far.
+				auto place = [this, &strm, &written_size](PackArchive::Entry& entry, std::uint64_t stored_size) {
+					bool small = small_threshold != 0 && stored_size < small_threshold;
+					entry.offset = align(written_size, small ? small_alignment : alignment);
+					entry.stored_size = stored_size;
+					bool padded = pad(strm, entry.offset - written_size);
+					written_size = entry.offset + stored_size;
+					return padded;
+				};
+
+				Batch batches[2];
+				batches[0] = next_batch(0);
+				auto reader = read_batch(batches[0]);
+				std::vector<char> chunk;
+				std::vector<char> blocks;
+				std::vector<std::uint64_t> ends;
+				for (int turn = 0; written && batches[turn].first < stored.size(); turn ^= 1) {
+					auto& current = batches[turn];
+					reader->finish();
+					batches[turn ^ 1] = next_batch(current.last);
+					reader = read_batch(batches[turn ^ 1]);
+
+					for (size_t item = current.first; item < current.last && written; ++item) {
+						auto position = stored[item];
+						auto& entry = entries[slots[position]];
+						auto& source = sources[position];
+						if (current.streamed && compress) {
+							// Block table first (filled in once the blocks are written).
+							auto table_size = (entry.size + block_size - 1) / block_size * sizeof(std::uint64_t);
+							auto start = align(written_size, alignment);
+							written = pad(strm, start - written_size) && pad(strm, table_size);
+							ends.clear();
+							std::ifstream input;
+							for (std::uint64_t at = 0; at < entry.size && written; at += CHUNK_SIZE) {
+								auto step = std::min(CHUNK_SIZE, entry.size - at);
+								chunk.resize((size_t)step);
+								blocks.clear();
+								written = read_source(source.path, source.bytes, input, at, chunk.data(), step);
+								if (written) {
+									CompressedEntryFile::compress_blocks(chunk.data(), step, block_size,
+										ends.empty() ? table_size : ends.back(), blocks, ends);
+									written = (bool)strm.write(blocks.data(), (std::streamsize)blocks.size());
+								}
+							}
+							written = written && strm.seekp((std::streamoff)start) &&
+								strm.write((const char*)ends.data(), (std::streamsize)table_size) &&
+								strm.seekp(0, std::ios::end);
+							entry.offset = start;
+							entry.stored_size = ends.empty() ? table_size : ends.back();
+							entry.flags = PackArchive::ENTRY_COMPRESSED;
+							written_size = start + entry.stored_size;
+							++figures.compressed;
+						} else if (current.streamed) {
+							written = place(entry, entry.size);
+							std::ifstream input;
+							for (std::uint64_t at = 0; at < entry.size && written; at += CHUNK_SIZE) {
+								auto step = std::min(CHUNK_SIZE, entry.size - at);
+								chunk.resize((size_t)step);
+								written = read_source(source.path, source.bytes, input, at, chunk.data(), step) &&
+									strm.write(chunk.data(), (std::streamsize)step);
+							}
+						} else {
+							auto& buffer = current.buffers[item - current.first];
+							written = !current.failed[item - current.first] && place(entry, buffer.size()) &&
+								strm.write(buffer.data(), (std::streamsize)buffer.size());
+							if (current.compressed[item - current.first]) {
+								entry.flags = PackArchive::ENTRY_COMPRESSED;
+								++figures.compressed;
+							}
+							// Written: no need to hold it until the batch ends.
+							std::vector<char>().swap(buffer);
+						}
+					}
+				}
+				reader->finish();
+
+				// Duplicates share what their twin stored.
+				for (size_t position = 0; position < count; ++position) {
+					if (twins[position] != count) {
+						auto& twin = entries[slots[twins[position]]];
+						auto& entry = entries[slots[position]];
+						entry.offset = twin.offset;
+						entry.stored_size = twin.stored_size;
+						entry.flags = twin.flags;
+					}
+				}
+				header.file_size = written_size;
+				figures.file_size = written_size;
+				written = written && strm.seekp(0) &&
+					strm.write((const char*)&header, sizeof(header)) &&
+					strm.seekp((std::streamoff)header.entries_offset) &&
+					strm.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PackArchive::Entry)));
+				if (written) {
+					strm.close();
+					written = !strm.fail();
+				}
+			}
+			std::error_code error;
+			if (!written) {
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+			std::filesystem::rename(temporary, path, error);
+			if (error) {
+				std::filesystem::remove(temporary, error);
+				return false;
+			}
+			statistics = figures;
+			return true;
+		}
+	}
+}
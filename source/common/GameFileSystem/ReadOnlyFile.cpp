@@ -0,0 +1,86 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+
+#include <ReversingSpace/GameFileSystem/ReadOnlyFile.hpp>
+
+#include <algorithm>
+
+namespace reversingspace {
+	namespace gfs {
+		storage::StorageSize ReadOnlyFile::allowance(storage::StorageOffset offset,
+			storage::StorageSize requested) const {
+			if (offset < 0 || (storage::StorageSize)offset >= size) {
+				return 0;
+			}
+			return std::min(requested, size - (storage::StorageSize)offset);
+		}
+
+		storage::StorageSize ReadOnlyFile::seek(storage::StorageOffset offset,
+			storage::Seek whence) {
+			std::lock_guard<std::mutex> lock(cursor_mutex);
+			storage::StorageOffset target = offset;
+			switch (whence) {
+				// 0 + offset
+				case storage::Seek::Set: {
+				} break;
+
+				// current + offset
+				case storage::Seek::Current: {
+					target += (storage::StorageOffset)cursor;
+				} break;
+
+				// end + offset
+				case storage::Seek::End: {
+					target += (storage::StorageOffset)size;
+				} break;
+			}
+
+			// Clamp
+			cursor = (target < 0) ? 0 : std::min((storage::StorageSize)target, size);
+			return cursor;
+		}
+
+		storage::StorageOffset ReadOnlyFile::tell() const {
+			std::lock_guard<std::mutex> lock(cursor_mutex);
+			return (storage::StorageOffset)cursor;
+		}
+
+		storage::StorageSize ReadOnlyFile::read(char* data,
+			storage::StorageSize requested) {
+			std::lock_guard<std::mutex> lock(cursor_mutex);
+			auto count = read_from((storage::StorageOffset)cursor, data, requested);
+			cursor += count;
+			return count;
+		}
+
+		storage::StorageSize ReadOnlyFile::read(std::vector<std::uint8_t>& data,
+			storage::StorageSize requested) {
+			std::lock_guard<std::mutex> lock(cursor_mutex);
+			auto count = read_from((storage::StorageOffset)cursor, data, requested);
+			cursor += count;
+			return count;
+		}
+
+		storage::StorageSize ReadOnlyFile::read_from(storage::StorageOffset offset,
+			std::vector<std::uint8_t>& data, storage::StorageSize requested) {
+			auto count = allowance(offset, requested);
+			if (data.size() < count) {
+				data.resize((size_t)count);
+			}
+			if (count == 0) {
+				return 0;
+			}
+			return read_from(offset, (char*)data.data(), count);
+		}
+	}
+}
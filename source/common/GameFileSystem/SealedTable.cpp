@@ -0,0 +1,91 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/SealedTable.hpp>
+#include <ReversingSpace/GameFileSystem/FileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityMap.hpp>
+
+#include <cstring>
+
+namespace reversingspace {
+	namespace gfs {
+		FileSystem* SealedTable::find(StringIdentity identity) const {
+			auto hash = fnv1a(identity.data(), identity.size());
+			auto mask = slots.size() - 1;
+			for (size_t slot = (size_t)hash & mask; ; slot = (slot + 1) & mask) {
+				auto& entry = slots[slot];
+				if (entry.owner == EMPTY_SLOT) {
+					return nullptr;
+				}
+				if (entry.hash == hash && entry.name_length == identity.size() &&
+					memcmp(names.data() + entry.name_offset, identity.data(), identity.size()) == 0) {
+					return mounts[entry.owner].get();
+				}
+			}
+		}
+
+		FilePointer SealedTable::get_file(StringIdentity identity) const {
+			auto owner = find(identity);
+			return (owner == nullptr) ? nullptr : owner->get_file(identity);
+		}
+
+		void SealedTable::for_each(const EnumerationFunction& callback) const {
+			for (auto& entry : slots) {
+				if (entry.owner != EMPTY_SLOT) {
+					callback(StringIdentity(names.data() + entry.name_offset, entry.name_length));
+				}
+			}
+		}
+
+		SealedTablePointer SealedTable::build(const std::vector<FileSystemPointer>& stack) {
+			// Top down: the first mount listing an identity owns it.
+			IdentityMap<std::uint32_t> owners;
+			for (size_t position = stack.size(); position-- > 0; ) {
+				auto owner = (std::uint32_t)position;
+				bool enumerated = stack[position]->enumerate([&owners, owner](StringIdentity name) {
+					if (owners.count(name) == 0) {
+						owners[name] = owner;
+					}
+				});
+				if (!enumerated) {
+					return nullptr;
+				}
+			}
+
+			// At most half full (so there is always an empty slot to stop at).
+			size_t slot_count = 2;
+			while (slot_count < owners.size() * 2) {
+				slot_count *= 2;
+			}
+			auto table = std::make_shared<SealedTable>();
+			table->mounts = stack;
+			table->identity_count = owners.size();
+			table->slots.assign(slot_count, Slot{ 0, 0, 0, EMPTY_SLOT });
+			for (auto& entry : owners) {
+				Slot slot;
+				slot.hash = fnv1a(entry.first.data(), entry.first.size());
+				slot.name_offset = (std::uint32_t)table->names.size();
+				slot.name_length = (std::uint32_t)entry.first.size();
+				slot.owner = entry.second;
+				table->names.append(entry.first);
+				size_t position = (size_t)slot.hash & (slot_count - 1);
+				while (table->slots[position].owner != EMPTY_SLOT) {
+					position = (position + 1) & (slot_count - 1);
+				}
+				table->slots[position] = slot;
+			}
+			table->names.shrink_to_fit();
+			return table;
+		}
+	}
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2017-2018 ReversingSpace. See the COPYRIGHT file at the
+ * top-level directory of this distribution and in the repository:
+ * https://github.com/ReversingSpace/cpp-gamefilesystem
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+**/
+
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+namespace reversingspace {
+	namespace gfs {
+		WorkerPool::WorkerPool(size_t thread_count) {
+			if (thread_count == 0) {
+				thread_count = std::thread::hardware_concurrency();
+			}
+			if (thread_count == 0) {
+				// Unknown; pick something sensible.
+				thread_count = 4;
+			}
+			threads.reserve(thread_count);
+			for (size_t i = 0; i < thread_count; ++i) {
+				threads.emplace_back(&WorkerPool::run, this);
+			}
+		}
+
+		WorkerPool::~WorkerPool() {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			available.notify_all();
+			for (auto& thread : threads) {
+				thread.join();
+			}
+		}
+
+		void WorkerPool::submit(std::function<void()> task) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				tasks.push_back(std::move(task));
+			}
+			available.notify_one();
+		}
+
+		void WorkerPool::run() {
+			for (;;) {
+				std::function<void()> task;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					available.wait(lock, [this]() {
+						return stopping || !tasks.empty();
+					});
+					if (tasks.empty()) {
+						return; // Stopping, and nothing left to run.
+					}
+					task = std::move(tasks.front());
+					tasks.pop_front();
+				}
+				task();
+			}
+		}
+
+		void ParallelLoop::State::work() {
+			for (size_t i; (i = next++) < count; ) {
+				task(i);
+			}
+		}
+
+		ParallelLoop::ParallelLoop(WorkerPool* pool, size_t count, std::function<void(size_t)> task)
+			: state(std::make_shared<State>()) {
+			state->task = std::move(task);
+			state->count = count;
+			if (pool == nullptr) {
+				return;
+			}
+			for (size_t helper = 0; helper < pool->size() && helper < count; ++helper) {
+				auto shared = state;
+				pool->submit([shared]() {
+					{
+						std::lock_guard<std::mutex> lock(shared->mutex);
+						if (shared->closed) {
+							return;
+						}
+						++shared->active;
+					}
+					shared->work();
+					std::lock_guard<std::mutex> lock(shared->mutex);
+					--shared->active;
+					shared->idle.notify_all();
+				});
+			}
+		}
+
+		ParallelLoop::~ParallelLoop() {
+			finish();
+		}
+
+		void ParallelLoop::finish() {
+			state->work();
+			std::unique_lock<std::mutex> lock(state->mutex);
+			state->closed = true;
+			state->idle.wait(lock, [this]() { return state->active == 0; });
+		}
+	}
+}
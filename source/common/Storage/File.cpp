@@ -33,40 +33,18 @@ namespace reversingspace {
 			return p;
 		}
 
-		FilePointer File::create(const std::filesystem::path& path,
+		FilePointer File::create(std::filesystem::path path,
 				FileAccess access) {
 
-			// Partial block on updating:
-			// Issue #2 (Symlink support)
-
-			// Fail to create if no creation is passed in.
-			if (((int)access & (int)FileAccess::Write)) {
-				// Force creation for write.
-				auto parent = path.parent_path();
-				if (!std::filesystem::is_directory(parent)) {
-					if (!std::filesystem::create_directories(parent)) {
-						// Failed to create directory (and did not exist before).
-						return nullptr;
-					}
-				}
-			} else {
-				// Doesn't exist, so can't read it.
-				if (!std::filesystem::exists(path)) {
-					return nullptr;
-				}
-
-				// Not a regular file, so fail.
-				// Partial blocker on Issue #2
-				if (!(std::filesystem::is_regular_file(path))) {
-					return nullptr;
-				}
-			}
+			// Existence, type (Issue #2: symlinks are followed) and missing
+			// parent directories are all handled by the platform open, on
+			// the handle, so the path is only resolved once.
 
 			// Create a default file instance.
 			auto file = std::make_shared<File>();
 
 			// Feed it the minimum requirements.
-			file->path = path;
+			file->path = std::move(path);
 			file->access = access;
 			
 			// Use the platform-specific open.
@@ -80,7 +58,21 @@ namespace reversingspace {
 		}
 
 		StorageSize File::get_size() const {
-			return std::filesystem::file_size(path);
+			if (size_cached) {
+				return cached_size;
+			}
+			return query_size();
+		}
+
+		FilePointer File::create_at(PlatformFileHandle directory, const char* name,
+				std::filesystem::path&& path, FileAccess access) {
+			auto file = std::make_shared<File>();
+			file->access = access;
+			if (!file->open_at(directory, name)) {
+				return nullptr;
+			}
+			file->path = std::move(path);
+			return file;
 		}
 
 		ViewPointer File::get_view(StorageOffset offset, StorageSize length) {
@@ -2,13 +2,19 @@
 
 #include <ReversingSpace/GameFileSystem.hpp>
 #include <ReversingSpace/GameFileSystem/Archive.hpp>
+#include <ReversingSpace/GameFileSystem/ArchiveEntryFile.hpp>
 #include <ReversingSpace/GameFileSystem/Directory.hpp>
 #include <ReversingSpace/GameFileSystem/File.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
 #include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
 #include <ReversingSpace/Storage/File.hpp>
 
+#include <atomic>
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 // memcmp, memcpy
 #include <cstring>
@@ -30,10 +36,13 @@ private:
 	/// Number of entries.
 	std::uint32_t count;
 
+	/// Mapping of the whole archive (shared by its entries).
+	reversingspace::storage::ViewPointer view;
+
 public:
 	/// Trivial constructor.
 	MyArchive(reversingspace::storage::FilePointer file, std::uint32_t entries): file(file), count(entries),
-		reversingspace::gfs::Archive() {}
+		view(file->get_view(0, file->get_size())), reversingspace::gfs::Archive() {}
 
 public: // Archive
 	std::uint32_t get_child_count() const {
@@ -46,14 +55,23 @@ public: // FileSystem
 		return nullptr;
 	}
 
+	// "junk" is the `count` bytes following the header.
 	reversingspace::gfs::FilePointer get_file(reversingspace::gfs::StringIdentity identity,
 		reversingspace::storage::FileAccess access) {
-		return nullptr;
+		if (identity != "junk") {
+			return nullptr;
+		}
+		return reversingspace::gfs::ArchiveEntryFile::create(view, 8, count);
 	}
 
 	std::filesystem::path get_path() const {
 		return file->get_path();
 	}
+
+	bool enumerate(const reversingspace::gfs::EnumerationFunction& callback) {
+		callback("junk");
+		return true;
+	}
 };
 
 reversingspace::gfs::ArchivePointer my_archive_loader(reversingspace::storage::FilePointer file) {
@@ -122,6 +140,31 @@ int main(int argc, char **argv) {
 			return 1;
 		}
 
+		// Entries share the archive's mapping, each with its own cursor.
+		{
+			auto first = good_archive->get_file("junk");
+			auto second = good_archive->get_file("junk");
+			char buffer[sizeof(JUNK)] = {};
+			if (first == nullptr || first->get_size() != sizeof(JUNK) ||
+				first->read(buffer, sizeof(buffer)) != sizeof(JUNK) || memcmp(buffer, JUNK, sizeof(JUNK)) != 0 ||
+				first->tell() != (std::int64_t)sizeof(JUNK) || second->tell() != 0) {
+				printf("archive entry read wrongly (this shouldn't happen)");
+				return 1;
+			}
+			if (second->seek(-4, reversingspace::storage::Seek::End) != sizeof(JUNK) - 4 ||
+				second->read(buffer, sizeof(buffer)) != 4 || memcmp(buffer, JUNK + sizeof(JUNK) - 4, 4) != 0 ||
+				second->read_from(sizeof(JUNK), buffer, 1) != 0 || second->write(buffer, 1) != 0) {
+				printf("archive entry bounds were not kept (this shouldn't happen)");
+				return 1;
+			}
+			auto view = std::static_pointer_cast<reversingspace::gfs::ArchiveEntryFile>(first)->get_view();
+			if (reversingspace::gfs::ArchiveEntryFile::create(view, 8, view->get_size()) != nullptr ||
+				std::static_pointer_cast<reversingspace::gfs::ArchiveEntryFile>(second)->get_view() != view) {
+				printf("archive entry range was not checked (this shouldn't happen)");
+				return 1;
+			}
+		}
+
 		archive_system.unregister_directory(userland_directory);
 
 		// Test good (should now fail)
@@ -150,6 +193,123 @@ int main(int argc, char **argv) {
 		}
 	}
 
+	// Lazy loading: nothing is opened until first use.
+	{
+		std::atomic<int> opens{ 0 };
+		reversingspace::gfs::ArchiveSystem<reversingspace::gfs::Archive, FileType> archive_system;
+		archive_system.register_loader([&opens](reversingspace::storage::FilePointer file) {
+			++opens;
+			return my_archive_loader(file);
+		});
+		archive_system.register_directory(userland_directory);
+
+		if (archive_system.load_lazy("missing_archive") != nullptr) {
+			printf("missing archive was found (this shouldn't happen)");
+			return 1;
+		}
+		auto good_archive = archive_system.load_lazy("good_archive");
+		if (good_archive == nullptr || good_archive->get_path() != archive_system.find("good_archive")) {
+			printf("good archive was not found (this shouldn't happen)");
+			return 1;
+		}
+
+		// Mounting (and stamping a file) opens nothing.
+		auto storage_server = reversingspace::gfs::StorageServer<FileType>::create(userland_directory_path);
+		storage_server->mount(good_archive);
+		std::string stamp;
+		if (!good_archive->get_stamp(stamp) || !good_archive->check_stamp(stamp)) {
+			printf("lazy archive could not be stamped (this shouldn't happen)");
+			return 1;
+		}
+		if (opens != 0 || good_archive->is_opened()) {
+			printf("lazy archive opened before use (this shouldn't happen)");
+			return 1;
+		}
+
+		// The first look-up opens it, once.
+		storage_server->get_file("anything");
+		storage_server->get_file("anything_else");
+		if (opens != 1 || !good_archive->is_opened() || good_archive->open() == nullptr) {
+			printf("lazy archive was not opened exactly once (this shouldn't happen)");
+			return 1;
+		}
+
+		// Racing first uses still open it once.
+		auto raced_archive = archive_system.load_lazy("good_archive");
+		std::vector<std::thread> threads;
+		for (int i = 0; i < 8; ++i) {
+			threads.emplace_back([&raced_archive]() {
+				raced_archive->get_file("anything");
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		if (opens != 2) {
+			printf("racing lazy archive was not opened exactly once (this shouldn't happen)");
+			return 1;
+		}
+
+		// With a loaded index, a hit opens its provider only and a miss opens nothing.
+		{
+			std::vector<std::string> names = { "good_archive" };
+			for (int i = 1; i < 4; ++i) {
+				names.push_back("good_archive_" + std::to_string(i));
+				std::filesystem::copy_file(userland_directory_path / "good_archive",
+					userland_directory_path / names.back(),
+					std::filesystem::copy_options::overwrite_existing);
+			}
+			auto mount_all = [&archive_system, &names](reversingspace::gfs::StorageServer<FileType>& server) {
+				std::vector<reversingspace::gfs::LazyMountPointer> lazy;
+				for (auto& name : names) {
+					lazy.push_back(archive_system.load_lazy(name));
+					server.mount(lazy.back());
+				}
+				return lazy;
+			};
+			auto opened = [](const std::vector<reversingspace::gfs::LazyMountPointer>& lazy) {
+				std::string flags;
+				for (auto& mount : lazy) {
+					flags.push_back(mount->is_opened() ? '1' : '0');
+				}
+				return flags;
+			};
+
+			auto first = reversingspace::gfs::StorageServer<FileType>::create(userland_directory_path,
+				reversingspace::gfs::default_hash_function());
+			mount_all(*first);
+			first->build_index();
+			if (!first->save_index()) {
+				printf("lazy archives' index could not be saved (this shouldn't happen)");
+				return 1;
+			}
+
+			auto second = reversingspace::gfs::StorageServer<FileType>::create(userland_directory_path,
+				reversingspace::gfs::default_hash_function());
+			auto lazy = mount_all(*second);
+			if (!second->load_index() || opened(lazy) != "0000") {
+				printf("loading an index opened lazy archives (this shouldn't happen)");
+				return 1;
+			}
+			if (second->get_dataland_file("junk") == nullptr || opened(lazy) != "0001") {
+				printf("a hit opened more than its provider (this shouldn't happen)");
+				return 1;
+			}
+			if (second->get_dataland_file("missing") != nullptr || opened(lazy) != "0001") {
+				printf("a miss opened lazy archives (this shouldn't happen)");
+				return 1;
+			}
+		}
+
+		// An archive no loader accepts is an empty mount.
+		auto bad_archive = archive_system.load_lazy("bad_archive");
+		if (bad_archive == nullptr || bad_archive->get_file("anything") != nullptr ||
+			bad_archive->open() != nullptr || !bad_archive->enumerate([](reversingspace::gfs::StringIdentity) {})) {
+			printf("bad lazy archive was not empty (this shouldn't happen)");
+			return 1;
+		}
+	}
+
 	std::filesystem::remove_all(userland_directory_path);
 
 	return 0;
@@ -0,0 +1,149 @@
+// Stress test: StorageServer look-ups racing mount/unmount.
+
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+
+// Number of reader threads.
+const size_t READER_COUNT = 32;
+
+// Number of overlay mounts cycled by the writer.
+const size_t OVERLAY_COUNT = 4;
+
+// Writes a small file holding `marker`.
+static void write_marker(const std::filesystem::path& path, const std::string& marker) {
+	std::ofstream strm(path);
+	strm << marker;
+}
+
+// Reads the marker from a file (empty on failure).
+static std::string read_marker(reversingspace::gfs::FilePointer file) {
+	if (file == nullptr) {
+		return std::string();
+	}
+	char marker[16] = { 0 };
+	file->read(marker, sizeof(marker) - 1);
+	return std::string(marker);
+}
+
+int main(int argc, char **argv) {
+	// Run time (seconds) may be given as the first argument.
+	double seconds = (argc > 1) ? atof(argv[1]) : 2.0;
+
+	const std::filesystem::path root = std::filesystem::current_path() / "concurrency";
+	std::filesystem::remove_all(root);
+
+	// Base mount: always present, provides every name.
+	auto base_path = root / "base";
+	std::filesystem::create_directories(base_path);
+	write_marker(base_path / "shared", "base");
+	write_marker(base_path / "base_only", "base");
+
+	// Overlays: each shadows "shared" and adds a name of its own.
+	std::vector<reversingspace::gfs::FileSystemPointer> overlays;
+	for (size_t i = 0; i < OVERLAY_COUNT; ++i) {
+		auto overlay_path = root / ("overlay" + std::to_string(i));
+		std::filesystem::create_directories(overlay_path);
+		write_marker(overlay_path / "shared", "overlay" + std::to_string(i));
+		write_marker(overlay_path / ("overlay_only" + std::to_string(i)), "overlay" + std::to_string(i));
+		overlays.push_back(std::make_shared<reversingspace::gfs::Directory<FileType>>(overlay_path));
+	}
+
+	auto storage_server = reversingspace::gfs::StorageServer<FileType>::create(root / "userland",
+		reversingspace::gfs::default_hash_function());
+	if (storage_server == nullptr) {
+		throw std::runtime_error("failed to construct storage server");
+	}
+	storage_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(base_path));
+
+	std::atomic<bool> running{ true };
+	std::atomic<size_t> lookups{ 0 };
+	std::atomic<size_t> failures{ 0 };
+
+	// Readers: the base names must always resolve, whatever is mounted.
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < READER_COUNT; ++r) {
+		readers.emplace_back([&, r]() {
+			using namespace reversingspace::gfs::literals;
+			size_t local = 0;
+			while (running) {
+				auto shared = read_marker(storage_server->get_file("shared"));
+				if (shared != "base" && shared.compare(0, 7, "overlay") != 0) {
+					++failures;
+				}
+				if (read_marker(storage_server->get_file("base_only")) != "base") {
+					++failures;
+				}
+				if (storage_server->get_file("base_only"_gfs) == nullptr) {
+					++failures;
+				}
+				// Overlay names come and go; they only need to not crash.
+				storage_server->get_file("overlay_only" + std::to_string(r % OVERLAY_COUNT));
+				local += 4;
+			}
+			lookups += local;
+		});
+	}
+
+	// Writer: continuously mount and unmount overlays, switching between
+	// probing, the merged index, mount filters, the look-up cache and
+	// parallel probing as it goes.
+	auto pool = reversingspace::gfs::WorkerPool::create(4);
+	size_t changes = 0;
+	size_t round = 0;
+	auto start = std::chrono::steady_clock::now();
+	while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+		for (auto& overlay : overlays) {
+			storage_server->mount(overlay);
+			++changes;
+		}
+		switch (round++ % 4) {
+			case 1: storage_server->build_index(); storage_server->build_mount_filters(); break;
+			case 2: storage_server->enable_cache(); storage_server->enable_parallel_probing(pool); break;
+			case 3:
+				storage_server->drop_index();
+				storage_server->disable_cache();
+				storage_server->disable_parallel_probing();
+				storage_server->drop_mount_filters();
+				break;
+			default: break;
+		}
+		for (auto& overlay : overlays) {
+			storage_server->unmount(overlay);
+			++changes;
+		}
+	}
+	running = false;
+	for (auto& reader : readers) {
+		reader.join();
+	}
+
+	std::cout << lookups << " look-ups across " << READER_COUNT << " threads during "
+		<< changes << " mount changes; " << failures << " failures." << std::endl;
+	if (failures != 0) {
+		throw std::runtime_error("look-ups failed during mount/unmount.");
+	}
+
+	// Everything was unmounted again: only the base remains.
+	if (storage_server->mount_count() != 1 || read_marker(storage_server->get_file("shared")) != "base") {
+		throw std::runtime_error("mount table inconsistent after the stress run.");
+	}
+
+	storage_server = nullptr;
+	overlays.clear();
+	std::filesystem::remove_all(root);
+	return 0;
+}
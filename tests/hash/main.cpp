@@ -0,0 +1,88 @@
+// Test for the default (built-in) identity hash.
+
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace reversingspace::gfs::literals;
+
+// Published FNV-1a (64-bit) vectors; these are checked at compile time.
+static_assert(""_gfs == 0xcbf29ce484222325ULL, "FNV-1a of the empty string is the offset basis");
+static_assert("a"_gfs == 0xaf63dc4c8601ec8cULL, "FNV-1a of 'a'");
+static_assert("foobar"_gfs == 0x85944171f73967e8ULL, "FNV-1a of 'foobar'");
+
+int main(int argc, char **argv) {
+	// The runtime hash must agree with the compile-time hash.
+	constexpr reversingspace::gfs::HashedIdentity compiled = "textures/ui.dds"_gfs;
+	const std::string name = "textures/ui.dds";
+	if (reversingspace::gfs::default_hash(name) != compiled) {
+		std::cout << "runtime hash differs from the compile-time hash." << std::endl;
+		throw std::runtime_error("hash mismatch");
+	}
+
+	auto function = reversingspace::gfs::default_hash_function();
+	if (function(name) != compiled) {
+		std::cout << "default_hash_function differs from the compile-time hash." << std::endl;
+		throw std::runtime_error("hash mismatch");
+	}
+
+	// Batch hashing must match one-at-a-time hashing exactly.  Names are
+	// packed in one buffer (as a directory listing would be), and lengths
+	// vary (including empty names) to cover the uneven tails.
+	const size_t NAME_COUNT = 500000;
+	std::string arena;
+	std::vector<size_t> lengths;
+	for (size_t i = 0; i < NAME_COUNT; ++i) {
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), "textures/set%03zu/asset_%zu.dds", i % 997, i);
+		size_t length = (i % 13 == 0) ? (i % 7) : strlen(buffer);
+		arena.append(buffer, length);
+		lengths.push_back(length);
+	}
+	std::vector<std::string_view> names;
+	size_t offset = 0;
+	for (auto length : lengths) {
+		names.emplace_back(arena.data() + offset, length);
+		offset += length;
+	}
+
+	// Best of a few runs, to keep the numbers somewhat stable.
+	std::vector<reversingspace::gfs::HashedIdentity> expected(names.size());
+	std::vector<reversingspace::gfs::HashedIdentity> batched;
+	double scalar_best = 0;
+	double batch_best = 0;
+	for (int run = 0; run < 5; ++run) {
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < names.size(); ++i) {
+			expected[i] = reversingspace::gfs::fnv1a(names[i].data(), names[i].size());
+		}
+		std::chrono::duration<double> scalar = std::chrono::steady_clock::now() - start;
+
+		start = std::chrono::steady_clock::now();
+		batched = reversingspace::gfs::default_hash_batch(names);
+		std::chrono::duration<double> batch = std::chrono::steady_clock::now() - start;
+
+		if (run == 0 || scalar.count() < scalar_best) {
+			scalar_best = scalar.count();
+		}
+		if (run == 0 || batch.count() < batch_best) {
+			batch_best = batch.count();
+		}
+	}
+
+	if (batched != expected) {
+		std::cout << "batch hashing differs from one-at-a-time hashing." << std::endl;
+		throw std::runtime_error("batch hash mismatch");
+	}
+
+	std::cout << "scalar: " << (scalar_best * 1000.0) << " ms; batch: "
+		<< (batch_best * 1000.0) << " ms (" << (scalar_best / batch_best)
+		<< "x) for " << names.size() << " names" << std::endl;
+	return 0;
+}
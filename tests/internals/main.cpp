@@ -1,10 +1,16 @@
 // Test for ReversingSpace/cpp-gamefilesystem.
 
 #include <ReversingSpace/GameFileSystem.hpp>
+#include <ReversingSpace/GameFileSystem/Directory.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
 
 #include <iostream>
 #include <stdexcept>
 
+#if defined(__unix__) || (defined (__APPLE__) && defined (__MACH__))
+#include <sys/stat.h>
+#endif
+
 int main(int argc, char **argv) {
 	auto cwd = std::filesystem::current_path();
 	auto test0 = cwd / "test0.ext";
@@ -51,5 +57,55 @@ int main(int argc, char **argv) {
 	}
 	std::filesystem::remove(test1);
 
+	// test 2
+	// Single-open validation: directories cannot be read, writes create
+	// their parents, and read-only files know their size.
+	{
+		auto test2 = cwd / "test2";
+		std::filesystem::remove_all(test2);
+		if (reversingspace::storage::File::create(cwd) != nullptr) {
+			throw std::runtime_error("opened a directory for reading.");
+		}
+
+		auto nested = test2 / "a" / "b" / "test2.ext";
+		{
+			auto writer = reversingspace::storage::File::create(nested,
+				reversingspace::storage::FileAccess::ReadWrite);
+			if (writer == nullptr) {
+				throw std::runtime_error("test2.ext (and its parents) not created.");
+			}
+			auto view = writer->get_view(0, 100);
+			view->flush();
+		}
+
+		auto reader = reversingspace::storage::File::create(nested);
+		if (reader == nullptr || reader->get_size() != 100) {
+			throw std::runtime_error("test2.ext not readable at the written size.");
+		}
+		std::filesystem::remove_all(test2);
+	}
+
+#if defined(__unix__) || (defined (__APPLE__) && defined (__MACH__))
+	// test 3
+	// A FIFO is refused without blocking (no writer will ever open it).
+	{
+		auto test3 = cwd / "test3";
+		std::filesystem::remove_all(test3);
+		std::filesystem::create_directories(test3);
+		auto pipe = test3 / "pipe";
+		if (::mkfifo(pipe.c_str(), 0600) != 0) {
+			throw std::runtime_error("test3 FIFO could not be made.");
+		}
+		if (reversingspace::storage::File::create(pipe) != nullptr) {
+			throw std::runtime_error("opened a FIFO for reading.");
+		}
+		reversingspace::gfs::Directory<reversingspace::gfs::PlatformFile> directory(test3);
+		if (directory.get_file("pipe") != nullptr) {
+			throw std::runtime_error("Directory served a FIFO.");
+		}
+		std::filesystem::remove_all(test3);
+	}
+#endif
+
 	return 0;
 }
\ No newline at end of file
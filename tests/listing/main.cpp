@@ -0,0 +1,338 @@
+// Test (and benchmark) for directory listings, scans and relative opens.
+
+#include <ReversingSpace/GameFileSystem/Directory.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <set>
+#include <string>
+#include <vector>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+using reversingspace::gfs::EntryType;
+
+// Number of subdirectories created.
+const size_t DIRECTORY_COUNT = 8;
+
+// Creates a tree `depth` levels deep, `fan_out` directories wide, with
+// `files` files per directory.
+static void create_tree(const std::filesystem::path& path, size_t depth, size_t fan_out, size_t files) {
+	std::filesystem::create_directories(path);
+	for (size_t i = 0; i < files; ++i) {
+		std::ofstream strm(path / ("f" + std::to_string(i)));
+	}
+	if (depth == 0) {
+		return;
+	}
+	for (size_t i = 0; i < fan_out; ++i) {
+		create_tree(path / ("d" + std::to_string(i)), depth - 1, fan_out, files);
+	}
+}
+
+// Reads a whole file as a string (empty on failure).
+static std::string read_all(reversingspace::gfs::FilePointer file) {
+	if (file == nullptr) {
+		return std::string();
+	}
+	std::string content((size_t)file->get_size(), '\0');
+	file->read(&content[0], content.size());
+	return content;
+}
+
+// Writes a file holding `content`.
+static void write_all(const std::filesystem::path& path, const std::string& content) {
+	std::ofstream strm(path, std::ios::binary);
+	strm << content;
+}
+
+// Flattens a listing to names.
+static std::vector<std::string> names_of(const reversingspace::gfs::DirectoryListingPointer& listing) {
+	std::vector<std::string> names;
+	for (auto& entry : *listing) {
+		names.emplace_back(entry.name);
+	}
+	return names;
+}
+
+int main(int argc, char **argv) {
+	// File count may be given as the first argument (e.g. 200000 to time a mod scan).
+	size_t file_count = (argc > 1) ? (size_t)atol(argv[1]) : 2000;
+
+	const std::filesystem::path root = std::filesystem::current_path() / "listing";
+	std::filesystem::remove_all(root);
+	std::filesystem::create_directories(root);
+
+	// Files of differing sizes, plus subdirectories.
+	std::map<std::string, std::uint64_t> sizes;
+	for (size_t i = 0; i < file_count; ++i) {
+		auto name = "file" + std::to_string(i) + ".dat";
+		std::ofstream strm(root / name, std::ios::binary);
+		std::string content(i % 97, 'x');
+		strm << content;
+		sizes[name] = content.size();
+	}
+	for (size_t i = 0; i < DIRECTORY_COUNT; ++i) {
+		std::filesystem::create_directories(root / ("dir" + std::to_string(i)));
+	}
+
+	// Links report their target; dangling links are `Unknown`.
+	size_t link_files = 0, link_directories = 0, link_dangling = 0;
+	std::error_code error;
+	std::filesystem::create_directory_symlink(root / "dir0", root / "link_dir", error);
+	if (!error) {
+		std::filesystem::create_symlink(root / "file0.dat", root / "link_file", error);
+		std::filesystem::create_symlink(root / "missing", root / "link_dangling", error);
+		if (!error) {
+			link_files = link_directories = link_dangling = 1;
+			sizes["link_file"] = 0;
+		}
+	}
+
+	reversingspace::gfs::Directory<FileType> directory(root);
+
+	// Types only.
+	auto listing = directory.list();
+	if (listing == nullptr) {
+		throw std::runtime_error("failed to list the directory.");
+	}
+	if (listing->size() != file_count + DIRECTORY_COUNT + link_files + link_directories + link_dangling) {
+		throw std::runtime_error("listing has the wrong number of entries.");
+	}
+	if (directory.file_count() != file_count + link_files ||
+		directory.directory_count() != DIRECTORY_COUNT + link_directories ||
+		listing->count(EntryType::Unknown) != link_dangling) {
+		throw std::runtime_error("listing miscounted entry types.");
+	}
+	for (auto& entry : *listing) {
+		if (entry.name == "." || entry.name == "..") {
+			throw std::runtime_error("listing includes '.' or '..'.");
+		}
+	}
+
+	// Sizes and times.
+	auto detailed = directory.list(true);
+	auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	for (auto& entry : *detailed) {
+		if (entry.type != EntryType::File) {
+			continue;
+		}
+		auto expected = sizes.find(std::string(entry.name));
+		if (expected == sizes.end()) {
+			throw std::runtime_error("listing returned an unexpected file.");
+		}
+		if (entry.name != "link_file" && entry.size != expected->second) {
+			throw std::runtime_error("listing returned the wrong size.");
+		}
+		// Written within the last hour (and not in the future, allowing for clock granularity).
+		if (entry.modified > now + 1000000000LL || entry.modified < now - 3600LL * 1000000000LL) {
+			throw std::runtime_error("listing returned an implausible modification time.");
+		}
+	}
+
+	// A missing directory cannot be listed.
+	if (reversingspace::gfs::DirectoryListing::create(root / "missing") != nullptr) {
+		throw std::runtime_error("listed a missing directory.");
+	}
+
+	// Compare with the two-pass `directory_iterator` count (one stat per entry per pass).
+	auto start = std::chrono::steady_clock::now();
+	size_t counted = (size_t)std::count_if(
+		std::filesystem::directory_iterator(root), std::filesystem::directory_iterator(),
+		static_cast<bool(*)(const std::filesystem::path&)>(std::filesystem::is_directory));
+	counted += (size_t)std::count_if(
+		std::filesystem::directory_iterator(root), std::filesystem::directory_iterator(),
+		static_cast<bool(*)(const std::filesystem::path&)>(std::filesystem::is_regular_file));
+	auto iterated = std::chrono::steady_clock::now() - start;
+
+	start = std::chrono::steady_clock::now();
+	auto single = directory.list();
+	size_t listed = single->count(EntryType::Directory) + single->count(EntryType::File);
+	auto listed_time = std::chrono::steady_clock::now() - start;
+
+	if (counted != listed) {
+		throw std::runtime_error("listing disagrees with std::filesystem.");
+	}
+	std::cout << listed << " entries: directory_iterator (two passes) "
+		<< std::chrono::duration<double, std::milli>(iterated).count() << "ms, listing "
+		<< std::chrono::duration<double, std::milli>(listed_time).count() << "ms." << std::endl;
+
+	// Recursive scans: the same sorted result whatever the thread count.
+	{
+		// Tree size may be given as the second argument (depth; 5 fans out to ~100k files).
+		size_t depth = (argc > 2) ? (size_t)atol(argv[2]) : 3;
+		auto tree = root / "tree";
+		create_tree(tree, depth, 6, 10);
+
+		std::set<std::string> expected;
+		for (auto& entry : std::filesystem::recursive_directory_iterator(tree)) {
+			expected.insert(entry.path().lexically_relative(tree).generic_string());
+		}
+
+		start = std::chrono::steady_clock::now();
+		auto serial = reversingspace::gfs::DirectoryListing::scan(tree);
+		auto serial_time = std::chrono::steady_clock::now() - start;
+		auto serial_names = names_of(serial);
+		if (serial_names != std::vector<std::string>(expected.begin(), expected.end())) {
+			throw std::runtime_error("scan disagrees with recursive_directory_iterator.");
+		}
+
+		for (size_t threads : { 1, 4, 8 }) {
+			auto pool = reversingspace::gfs::WorkerPool::create(threads);
+			start = std::chrono::steady_clock::now();
+			auto parallel = reversingspace::gfs::DirectoryListing::scan(tree, false, pool);
+			auto parallel_time = std::chrono::steady_clock::now() - start;
+			if (names_of(parallel) != serial_names) {
+				throw std::runtime_error("parallel scan is not deterministic.");
+			}
+			std::cout << serial_names.size() << " entries scanned: serial "
+				<< std::chrono::duration<double, std::milli>(serial_time).count() << "ms, "
+				<< threads << " helpers "
+				<< std::chrono::duration<double, std::milli>(parallel_time).count() << "ms." << std::endl;
+		}
+
+		auto detailed_tree = reversingspace::gfs::DirectoryListing::scan(tree, true,
+			reversingspace::gfs::WorkerPool::create(2));
+		if (names_of(detailed_tree) != serial_names) {
+			throw std::runtime_error("scan with metadata differs.");
+		}
+
+		// A scan may be started from a task on the pool it uses.
+		auto pool = reversingspace::gfs::WorkerPool::create(1);
+		std::mutex mutex;
+		std::condition_variable finished;
+		reversingspace::gfs::DirectoryListingPointer nested;
+		pool->submit([&]() {
+			auto result = reversingspace::gfs::DirectoryListing::scan(tree, false, pool);
+			std::lock_guard<std::mutex> lock(mutex);
+			nested = result;
+			finished.notify_all();
+		});
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			finished.wait(lock, [&]() { return nested != nullptr; });
+		}
+		if (names_of(nested) != serial_names) {
+			throw std::runtime_error("scan from a pool task differs.");
+		}
+
+		// Directory::enumerate is backed by the scan.
+		reversingspace::gfs::Directory<FileType> tree_directory(tree);
+		tree_directory.set_worker_pool(pool);
+		std::vector<std::string> enumerated;
+		tree_directory.enumerate([&enumerated](reversingspace::gfs::StringIdentity identity) {
+			enumerated.emplace_back(identity);
+		});
+		std::vector<std::string> files;
+		for (auto& name : expected) {
+			if (std::filesystem::is_regular_file(tree / name)) {
+				files.push_back(name);
+			}
+		}
+		if (enumerated != files) {
+			throw std::runtime_error("enumerate disagrees with the scan.");
+		}
+	}
+
+	// A link back to an ancestor is listed but not entered; other links to a directory are.
+	{
+		auto cycle = root / "cycle";
+		std::filesystem::create_directories(cycle / "sub");
+		write_all(cycle / "sub" / "f.txt", "f");
+		std::filesystem::create_directory_symlink("..", cycle / "sub" / "up", error);
+		if (!error) {
+			std::filesystem::create_directory_symlink("sub", cycle / "alias", error);
+		}
+		if (!error) {
+			const std::vector<std::string> expected = {
+				"alias", "alias/f.txt", "alias/up", "sub", "sub/f.txt", "sub/up",
+			};
+			if (names_of(reversingspace::gfs::DirectoryListing::scan(cycle)) != expected ||
+				names_of(reversingspace::gfs::DirectoryListing::scan(cycle, false,
+					reversingspace::gfs::WorkerPool::create(4))) != expected) {
+				throw std::runtime_error("scan entered a looping link.");
+			}
+		}
+	}
+
+	// Relative opens (DirectoryHandle).
+	{
+		auto opens = root / "opens";
+		std::filesystem::create_directories(opens / "a" / "b");
+		write_all(opens / "top.txt", "top");
+		write_all(opens / "a" / "b" / "deep.txt", "deep");
+
+		auto directory = std::make_shared<reversingspace::gfs::Directory<FileType>>(opens);
+		if (read_all(directory->get_file("top.txt")) != "top" ||
+			read_all(directory->get_file("a/b/deep.txt")) != "deep") {
+			throw std::runtime_error("relative opens failed.");
+		}
+		if (directory->get_file("a/b") != nullptr || directory->get_file("a/b/missing.txt") != nullptr) {
+			throw std::runtime_error("opened a directory or a missing file.");
+		}
+
+		// A deleted (and recreated) subdirectory is reopened.
+		std::filesystem::remove_all(opens / "a" / "b");
+		std::filesystem::create_directories(opens / "a" / "b");
+		write_all(opens / "a" / "b" / "deep.txt", "again");
+		if (read_all(directory->get_file("a/b/deep.txt")) != "again") {
+			throw std::runtime_error("stale subdirectory descriptor used.");
+		}
+
+		// Writes still create missing directories.
+		if (directory->get_file("c/d/new.txt", reversingspace::storage::FileAccess::ReadWrite) == nullptr ||
+			!std::filesystem::exists(opens / "c" / "d" / "new.txt")) {
+			throw std::runtime_error("write through a directory failed.");
+		}
+
+		// The root is held open: renaming it does not break look-ups.
+		auto handle = reversingspace::gfs::DirectoryHandle::create(opens);
+		if (handle != nullptr) {
+			std::filesystem::rename(opens, root / "renamed");
+			if (read_all(directory->get_file("a/b/deep.txt")) != "again") {
+				throw std::runtime_error("look-up failed after the root was renamed.");
+			}
+			std::filesystem::rename(root / "renamed", opens);
+
+			// The cache is bounded.
+			auto small = reversingspace::gfs::DirectoryHandle::create(root / "tree", 2);
+			for (size_t i = 0; i < 6; ++i) {
+				small->open("d" + std::to_string(i) + "/f0", root / "tree" / ("d" + std::to_string(i)) / "f0");
+			}
+			if (small->cached_count() != 2) {
+				throw std::runtime_error("directory handle cache exceeded its capacity.");
+			}
+
+			// Compare with opening by full path.
+			const size_t OPEN_COUNT = 20000;
+			auto deep_path = root / "tree" / "d1" / "d2" / "d3" / "f0";
+			start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < OPEN_COUNT; ++i) {
+				reversingspace::storage::File::create(deep_path);
+			}
+			auto by_path = std::chrono::steady_clock::now() - start;
+			auto tree_handle = reversingspace::gfs::DirectoryHandle::create(root / "tree");
+			start = std::chrono::steady_clock::now();
+			for (size_t i = 0; i < OPEN_COUNT; ++i) {
+				tree_handle->open("d1/d2/d3/f0", std::filesystem::path(deep_path));
+			}
+			auto by_handle = std::chrono::steady_clock::now() - start;
+			std::cout << OPEN_COUNT << " opens: by path "
+				<< std::chrono::duration<double, std::milli>(by_path).count() << "ms, relative "
+				<< std::chrono::duration<double, std::milli>(by_handle).count() << "ms." << std::endl;
+		}
+	}
+
+	std::filesystem::remove_all(root);
+	return 0;
+}
@@ -0,0 +1,505 @@
+// Test (and benchmark) for the reference archive format (PackArchive, PackBuilder)
+// and its block compression (lz_compress, CompressedEntryFile), including how
+// decompression scales over pool threads.
+
+#include <ReversingSpace/GameFileSystem/Archive.hpp>
+#include <ReversingSpace/GameFileSystem/ArchiveEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/CompressedEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/Compression.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+#include <ReversingSpace/GameFileSystem/PackArchive.hpp>
+#include <ReversingSpace/GameFileSystem/PackBuilder.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using reversingspace::gfs::FilePointer;
+using reversingspace::gfs::PackArchive;
+using reversingspace::gfs::PackBuilder;
+using reversingspace::gfs::StringIdentity;
+
+// Writes a file, creating its directory.
+static void write(const std::filesystem::path& path, const std::string& content) {
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream strm(path, std::ios::binary);
+	strm << content;
+}
+
+// Reads a whole file ("" for nullptr).
+static std::string contents(const FilePointer& file) {
+	std::vector<std::uint8_t> buffer;
+	if (file != nullptr) {
+		file->read(buffer, file->get_size());
+	}
+	return std::string(buffer.begin(), buffer.end());
+}
+
+// Bytes of a string.
+static std::vector<std::uint8_t> bytes(const std::string& content) {
+	return std::vector<std::uint8_t>(content.begin(), content.end());
+}
+
+// Offset of an entry within its pack.
+static std::int64_t offset_of(const FilePointer& file) {
+	auto entry = std::static_pointer_cast<reversingspace::gfs::ArchiveEntryFile>(file);
+	return entry->get_data() - (const char*)entry->get_view()->get_data_pointer();
+}
+
+// Whole file as a string.
+static std::string slurp(const std::filesystem::path& path) {
+	std::ifstream strm(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+}
+
+// Contents of the i-th generated entry.
+static std::string payload(int i) {
+	return "entry " + std::to_string(i) + std::string((size_t)(i % 37), (char)('a' + i % 26));
+}
+
+int main(int argc, char **argv) {
+	const auto root = std::filesystem::current_path() / "pack";
+	std::filesystem::remove_all(root);
+	write(root / "source" / "readme.txt", "read me");
+	write(root / "source" / "empty.bin", "");
+
+	// Round trip: names, hashes, misses, page alignment and cursors.
+	{
+		PackBuilder builder;
+		builder.add("readme.txt", root / "source" / "readme.txt");
+		builder.add("empty.bin", root / "source" / "empty.bin");
+		for (int i = 0; i < 500; ++i) {
+			builder.add("data/" + std::to_string(i) + ".bin", bytes(payload(i)));
+		}
+		if (!builder.write(root / "data.pack")) {
+			throw std::runtime_error("pack could not be written.");
+		}
+
+		auto pack = PackArchive::open(root / "data.pack");
+		if (pack == nullptr || pack->get_child_count() != 502) {
+			throw std::runtime_error("pack could not be opened.");
+		}
+		if (contents(pack->get_file("readme.txt")) != "read me" ||
+			pack->get_file("empty.bin") == nullptr || pack->get_file("empty.bin")->get_size() != 0) {
+			throw std::runtime_error("pack lost a file entry.");
+		}
+		for (int i = 0; i < 500; ++i) {
+			auto name = "data/" + std::to_string(i) + ".bin";
+			if (contents(pack->get_file(StringIdentity(name))) != payload(i) ||
+				contents(pack->get_file(reversingspace::gfs::default_hash(name))) != payload(i)) {
+				std::cout << name << " resolves wrongly." << std::endl;
+				throw std::runtime_error("pack look-up failed.");
+			}
+		}
+		if (pack->get_file("missing.bin") != nullptr ||
+			pack->get_file(reversingspace::gfs::default_hash("missing.bin")) != nullptr ||
+			pack->get_file("readme.txt", reversingspace::storage::FileAccess::ReadWrite) != nullptr) {
+			throw std::runtime_error("pack found a missing (or writable) entry.");
+		}
+
+		// Page-aligned: each entry starts a page, so its first byte sits
+		// at a page boundary of the file.
+		auto raw = reversingspace::storage::File::create(root / "data.pack");
+		auto view = raw->get_view(0, raw->get_size());
+		auto base = (const char*)view->get_data_pointer();
+		auto header = (const PackArchive::Header*)base;
+		auto entries = (const PackArchive::Entry*)(base + header->entries_offset);
+		for (std::uint32_t i = 0; i < header->entry_count; ++i) {
+			if (entries[i].offset % PackArchive::DEFAULT_ALIGNMENT != 0) {
+				throw std::runtime_error("pack entry is not page-aligned.");
+			}
+		}
+
+		// Cursors are per file.
+		auto first = pack->get_file("data/7.bin");
+		auto second = pack->get_file("data/7.bin");
+		char buffer[5] = {};
+		first->seek(2);
+		if (first->read(buffer, 4) != 4 || std::string(buffer, 4) != payload(7).substr(2, 4) ||
+			first->tell() != 6 || second->tell() != 0 ||
+			first->read_from(1000, buffer, 4) != 0 || first->write(buffer, 4) != 0) {
+			throw std::runtime_error("pack entry file misbehaved.");
+		}
+
+		// Names are enumerated (so prefix queries work too).
+		long enumerated = 0;
+		long prefixed = 0;
+		if (!pack->enumerate([&enumerated](StringIdentity) { ++enumerated; }) || enumerated != 502 ||
+			!pack->enumerate_prefix("data/", [&prefixed](StringIdentity) { ++prefixed; }) || prefixed != 500) {
+			throw std::runtime_error("pack enumerated wrongly.");
+		}
+
+		// Files outlive the archive (they hold the mapping).
+		auto kept = pack->get_file("readme.txt");
+		pack.reset();
+		if (contents(kept) != "read me") {
+			throw std::runtime_error("pack entry did not outlive its archive.");
+		}
+	}
+
+	// Duplicates are refused; damaged and foreign files are rejected.
+	{
+		PackBuilder builder;
+		builder.add("twice.txt", bytes("one"));
+		builder.add("twice.txt", bytes("two"));
+		if (builder.write(root / "twice.pack") || builder.set_alignment(3)) {
+			throw std::runtime_error("builder accepted a bad pack.");
+		}
+
+		PackBuilder empty;
+		if (!empty.write(root / "empty.pack") || PackArchive::open(root / "empty.pack") == nullptr ||
+			PackArchive::open(root / "empty.pack")->get_file("anything") != nullptr) {
+			throw std::runtime_error("empty pack misbehaved.");
+		}
+
+		std::filesystem::copy_file(root / "data.pack", root / "short.pack");
+		std::filesystem::resize_file(root / "short.pack", std::filesystem::file_size(root / "data.pack") - 1);
+		if (PackArchive::open(root / "short.pack") != nullptr ||
+			PackArchive::open(root / "source" / "readme.txt") != nullptr ||
+			PackArchive::open(root / "missing.pack") != nullptr) {
+			throw std::runtime_error("damaged pack was opened.");
+		}
+	}
+
+	// Loaded through an ArchiveSystem and mounted.
+	{
+		reversingspace::gfs::ArchiveSystem<> archives;
+		archives.register_directory(
+			std::make_shared<reversingspace::gfs::Directory<reversingspace::gfs::PlatformFile>>(root));
+		archives.register_loader(PackArchive::load);
+		auto archive = archives.load("data.pack");
+		auto server = reversingspace::gfs::StorageServer<>::create(root / "source",
+			reversingspace::gfs::default_hash_function());
+		if (archive == nullptr || !server->mount(archive)) {
+			throw std::runtime_error("pack could not be mounted.");
+		}
+		if (contents(server->get_file("data/42.bin")) != payload(42) ||
+			contents(server->get_file(reversingspace::gfs::default_hash("data/43.bin"))) != payload(43)) {
+			throw std::runtime_error("mounted pack resolved wrongly.");
+		}
+	}
+
+	// Packing a tree: trace order, deduplication, small entries, and the
+	// same pack with or without a pool.
+	{
+		std::string big(100000, 'x');
+		write(root / "tree" / "a.txt", "shared");
+		write(root / "tree" / "b" / "c.txt", "traced");
+		write(root / "tree" / "b" / "d.txt", "shared");
+		write(root / "tree" / "big.bin", big);
+
+		auto configure = [&root](PackBuilder& builder) {
+			if (!builder.add_directory(root / "tree", "tree/") || builder.size() != 4 ||
+				!builder.set_small_entries(4096, 16)) {
+				throw std::runtime_error("tree could not be added.");
+			}
+			builder.set_access_trace({ "tree/b/c.txt", "missing.txt", "tree/big.bin", "tree/b/c.txt" });
+		};
+		PackBuilder parallel;
+		configure(parallel);
+		parallel.set_worker_pool(reversingspace::gfs::WorkerPool::create(4));
+		PackBuilder serial;
+		configure(serial);
+		if (!parallel.write(root / "tree.pack") || !serial.write(root / "serial.pack") ||
+			slurp(root / "tree.pack") != slurp(root / "serial.pack")) {
+			throw std::runtime_error("parallel and serial packs differ.");
+		}
+
+		auto pack = PackArchive::open(root / "tree.pack");
+		auto a = pack->get_file("tree/a.txt");
+		auto c = pack->get_file("tree/b/c.txt");
+		auto d = pack->get_file("tree/b/d.txt");
+		auto large = pack->get_file("tree/big.bin");
+		if (contents(a) != "shared" || contents(c) != "traced" || contents(d) != "shared" || contents(large) != big) {
+			throw std::runtime_error("tree pack resolved wrongly.");
+		}
+		if (!(offset_of(c) < offset_of(large) && offset_of(large) < offset_of(a)) ||
+			offset_of(a) != offset_of(d) || offset_of(large) % PackArchive::DEFAULT_ALIGNMENT != 0 ||
+			offset_of(c) % 16 != 0 || offset_of(a) % 16 != 0) {
+			throw std::runtime_error("tree pack was laid out wrongly.");
+		}
+		auto& figures = parallel.get_statistics();
+		if (figures.entries != 4 || figures.stored != 3 || figures.deduplicated_bytes != 6 ||
+			figures.file_size != std::filesystem::file_size(root / "tree.pack")) {
+			throw std::runtime_error("tree pack figures are wrong.");
+		}
+
+		// Manifests name entries (optionally storing another file).
+		write(root / "manifest.txt", "# comment\n\ntree/b/c.txt\r\nrenamed.txt\ttree/a.txt\n");
+		PackBuilder listed;
+		if (!listed.add_manifest(root / "manifest.txt") || listed.size() != 2 ||
+			!listed.write(root / "listed.pack") || listed.add_manifest(root / "missing.txt")) {
+			throw std::runtime_error("manifest could not be packed.");
+		}
+		pack = PackArchive::open(root / "listed.pack");
+		if (contents(pack->get_file("tree/b/c.txt")) != "traced" || contents(pack->get_file("renamed.txt")) != "shared") {
+			throw std::runtime_error("manifest pack resolved wrongly.");
+		}
+
+		// Missing sources fail the write (leaving nothing behind).
+		PackBuilder broken;
+		broken.add("gone.txt", root / "gone.txt");
+		if (broken.write(root / "broken.pack") || std::filesystem::exists(root / "broken.pack") ||
+			std::filesystem::exists(root / "broken.pack.tmp")) {
+			throw std::runtime_error("pack of a missing file was written.");
+		}
+	}
+
+	// The codec round-trips, and rejects malformed input.
+	{
+		using reversingspace::gfs::lz_compress;
+		using reversingspace::gfs::lz_compress_bound;
+		using reversingspace::gfs::lz_decompress;
+		std::mt19937 random(7);
+		std::string noise(70000, 0);
+		for (auto& c : noise) {
+			c = (char)random();
+		}
+		std::string text;
+		while (text.size() < 70000) {
+			text += payload((int)(text.size() % 97)) + "\n";
+		}
+		for (const std::string& input : { std::string(), std::string("abc"), std::string("abcdabcdabcd"),
+			std::string(100000, 'z'), noise, text, text.substr(0, 19) }) {
+			std::vector<char> packed(lz_compress_bound(input.size()));
+			auto size = lz_compress(input.data(), input.size(), packed.data(), packed.size());
+			std::string output(input.size(), 0);
+			if (size == 0 || !lz_decompress(packed.data(), size, &output[0], output.size()) || output != input ||
+				(input.size() > 1 && lz_decompress(packed.data(), size, &output[0], output.size() - 1)) ||
+				(size > 1 && lz_decompress(packed.data(), size - 1, &output[0], output.size()))) {
+				throw std::runtime_error("codec did not round-trip.");
+			}
+		}
+		if (lz_compress(text.data(), text.size(), &std::string(16, 0)[0], 16) != 0) {
+			throw std::runtime_error("codec overran its output.");
+		}
+		std::string output(64, 0);
+		for (const std::string& bad : { std::string(), std::string("\x0f\x00\x00", 3), std::string("\x10" "a\x05\x00", 4) }) {
+			if (lz_decompress(bad.data(), bad.size(), &output[0], output.size())) {
+				throw std::runtime_error("codec accepted malformed input.");
+			}
+		}
+	}
+
+	// Compressed entries: reads anywhere, across blocks, match the raw
+	// bytes; incompressible entries are stored as-is; damage reads short.
+	{
+		std::string text;
+		while (text.size() < 300000) {
+			text += payload((int)(text.size() % 101)) + "\n";
+		}
+		std::mt19937 random(11);
+		std::string noise(50000, 0);
+		for (auto& c : noise) {
+			c = (char)random();
+		}
+		auto configure = [&](PackBuilder& builder) {
+			builder.add("text.txt", bytes(text));
+			builder.add("copy.txt", bytes(text));
+			builder.add("noise.bin", bytes(noise));
+			builder.add("small.txt", bytes("small"));
+		};
+		PackBuilder plain;
+		configure(plain);
+		PackBuilder packed;
+		configure(packed);
+		if (packed.set_compression(true, 1000) || packed.set_compression(true, 2u << 20) ||
+			!packed.set_compression(true, 16 * 1024)) {
+			throw std::runtime_error("builder accepted a bad block size.");
+		}
+		packed.set_worker_pool(reversingspace::gfs::WorkerPool::create(2));
+		if (!plain.write(root / "plain.pack") || !packed.write(root / "packed.pack") ||
+			packed.get_statistics().compressed != 1 || packed.get_statistics().stored != 3 ||
+			std::filesystem::file_size(root / "packed.pack") * 2 > std::filesystem::file_size(root / "plain.pack")) {
+			throw std::runtime_error("compressed pack is no smaller.");
+		}
+
+		auto pack = PackArchive::open(root / "packed.pack");
+		auto file = pack->get_file("text.txt");
+		if (std::dynamic_pointer_cast<reversingspace::gfs::CompressedEntryFile>(file) == nullptr ||
+			std::dynamic_pointer_cast<reversingspace::gfs::ArchiveEntryFile>(pack->get_file("noise.bin")) == nullptr ||
+			contents(file) != text || contents(pack->get_file("copy.txt")) != text ||
+			contents(pack->get_file("noise.bin")) != noise || contents(pack->get_file("small.txt")) != "small") {
+			throw std::runtime_error("compressed pack resolved wrongly.");
+		}
+		for (int i = 0; i < 200; ++i) {
+			auto offset = random() % text.size();
+			auto length = random() % 40000;
+			std::vector<char> buffer(length);
+			auto count = file->read_from((std::int64_t)offset, buffer.data(), length);
+			if (count != std::min<size_t>(length, text.size() - offset) ||
+				std::string(buffer.data(), (size_t)count) != text.substr(offset, (size_t)count)) {
+				throw std::runtime_error("compressed entry read wrongly.");
+			}
+		}
+		std::string sequential;
+		char piece[100];
+		file->seek(0);
+		for (std::uint64_t count; (count = file->read(piece, sizeof(piece))) != 0; ) {
+			sequential.append(piece, (size_t)count);
+		}
+		if (sequential != text || file->read_from(-1, piece, 1) != 0 || file->write(piece, 1) != 0) {
+			throw std::runtime_error("compressed entry misbehaved.");
+		}
+
+		// Decompressed on a pool: the same bytes, whatever the range.
+		pack->set_worker_pool(reversingspace::gfs::WorkerPool::create(3));
+		auto pooled = pack->get_file("text.txt");
+		if (contents(pooled) != text) {
+			throw std::runtime_error("pooled compressed entry read wrongly.");
+		}
+		for (int i = 0; i < 50; ++i) {
+			auto offset = random() % text.size();
+			auto length = random() % 200000;
+			std::vector<char> buffer(length);
+			auto count = pooled->read_from((std::int64_t)offset, buffer.data(), length);
+			if (count != std::min<size_t>(length, text.size() - offset) ||
+				std::string(buffer.data(), (size_t)count) != text.substr(offset, (size_t)count)) {
+				throw std::runtime_error("pooled compressed entry read wrongly.");
+			}
+		}
+
+		// A damaged block stops the read there.
+		auto damaged = slurp(root / "packed.pack");
+		auto header = (const PackArchive::Header*)damaged.data();
+		auto entries = (const PackArchive::Entry*)(damaged.data() + header->entries_offset);
+		for (std::uint32_t i = 0; i < header->entry_count; ++i) {
+			if (entries[i].flags & PackArchive::ENTRY_COMPRESSED) {
+				// Second block's bytes overwritten with garbage.
+				std::uint64_t start;
+				memcpy(&start, damaged.data() + entries[i].offset, sizeof(start));
+				for (int j = 0; j < 64; ++j) {
+					damaged[(size_t)(entries[i].offset + start + j)] = (char)0xff;
+				}
+				break;
+			}
+		}
+		write(root / "damaged.pack", damaged);
+		pack = PackArchive::open(root / "damaged.pack");
+		for (int pass = 0; pass < 2; ++pass) {
+			if (pass == 1) {
+				pack->set_worker_pool(reversingspace::gfs::WorkerPool::create(3));
+			}
+			std::vector<char> buffer(text.size());
+			auto count = pack->get_file("text.txt")->read_from(0, buffer.data(), text.size());
+			if (count != 16 * 1024 || std::string(buffer.data(), (size_t)count) != text.substr(0, (size_t)count)) {
+				throw std::runtime_error("damaged compressed entry read wrongly.");
+			}
+		}
+	}
+
+	// Decompression scaling: one large entry read whole, by the calling
+	// thread alone and on pools of increasing size.
+	{
+		std::mt19937 random(13);
+		std::string texture;
+		texture.reserve(48 << 20);
+		while (texture.size() < (48 << 20)) {
+			texture += "texel " + std::to_string(random() % 100000) + " " + payload((int)(random() % 64)) + "\n";
+		}
+		texture.resize(48 << 20);
+		PackBuilder builder;
+		builder.set_compression(true);
+		builder.set_worker_pool(reversingspace::gfs::WorkerPool::create());
+		builder.add("texture.bin", bytes(texture));
+		if (!builder.write(root / "texture.pack")) {
+			throw std::runtime_error("texture pack could not be written.");
+		}
+		auto pack = PackArchive::open(root / "texture.pack");
+		std::vector<char> buffer(texture.size());
+
+		using clock = std::chrono::steady_clock;
+		const int reads = 3;
+		double serial = 0;
+		for (size_t threads : { 0, 1, 2, 4, 8 }) {
+			pack->set_worker_pool(threads == 0 ? nullptr : reversingspace::gfs::WorkerPool::create(threads));
+			auto file = pack->get_file("texture.bin");
+			auto start = clock::now();
+			for (int i = 0; i < reads; ++i) {
+				if (file->read_from(0, buffer.data(), buffer.size()) != buffer.size()) {
+					throw std::runtime_error("texture could not be read.");
+				}
+			}
+			auto seconds = std::chrono::duration<double>(clock::now() - start).count() / reads;
+			if (threads == 0) {
+				serial = seconds;
+			}
+			if (memcmp(buffer.data(), texture.data(), texture.size()) != 0) {
+				throw std::runtime_error("texture read wrongly.");
+			}
+			std::cout << "48MB entry (" << std::filesystem::file_size(root / "texture.pack") / (1024 * 1024)
+				<< "MB stored), " << threads << " pool threads: " << (48.0 / seconds) << "MB/s ("
+				<< serial / seconds << "x)" << std::endl;
+		}
+	}
+
+	// Packing throughput (loose files, with a pool).
+	{
+		const int files = 256;
+		std::string block(64 * 1024, 0);
+		for (int i = 0; i < files; ++i) {
+			for (size_t j = 0; j < block.size(); j += 64) {
+				block[j] = (char)(i + j);
+			}
+			write(root / "bulk" / (std::to_string(i % 16) + "/" + std::to_string(i) + ".bin"), block);
+		}
+		PackBuilder builder;
+		builder.set_worker_pool(reversingspace::gfs::WorkerPool::create());
+		using clock = std::chrono::steady_clock;
+		auto start = clock::now();
+		if (!builder.add_directory(root / "bulk") || !builder.write(root / "bulk.pack")) {
+			throw std::runtime_error("bulk pack could not be written.");
+		}
+		auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+		std::cout << files << " files (" << builder.get_statistics().content_bytes / (1024 * 1024)
+			<< "MB) packed at " << (double)builder.get_statistics().content_bytes / (1024 * 1024) / seconds
+			<< "MB/s" << std::endl;
+	}
+
+	// Opening costs the same however many entries the pack holds.
+	{
+		const int count = 100000;
+		PackBuilder builder;
+		builder.set_alignment(8);
+		for (int i = 0; i < count; ++i) {
+			builder.add("assets/" + std::to_string(i % 300) + "/" + std::to_string(i) + ".bin", bytes(payload(i)));
+		}
+		if (!builder.write(root / "large.pack")) {
+			throw std::runtime_error("large pack could not be written.");
+		}
+
+		using clock = std::chrono::steady_clock;
+		const int opens = 100;
+		auto start = clock::now();
+		for (int i = 0; i < opens; ++i) {
+			if (PackArchive::open(root / "large.pack") == nullptr) {
+				throw std::runtime_error("large pack could not be opened.");
+			}
+		}
+		auto open_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / opens;
+
+		auto pack = PackArchive::open(root / "large.pack");
+		start = clock::now();
+		for (int i = 0; i < count; ++i) {
+			if (pack->get_file(reversingspace::gfs::default_hash(
+				"assets/" + std::to_string(i % 300) + "/" + std::to_string(i) + ".bin")) == nullptr) {
+				throw std::runtime_error("large pack look-up failed.");
+			}
+		}
+		auto lookup_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count() / count;
+		std::cout << count << "-entry pack: open " << open_us << "us, " << lookup_ns
+			<< "ns per hashed look-up" << std::endl;
+	}
+
+	std::filesystem::remove_all(root);
+	return 0;
+}
@@ -0,0 +1,293 @@
+// Test for saved mount indexes (MountIndexFile).
+
+#include <ReversingSpace/GameFileSystem/MountIndex.hpp>
+#include <ReversingSpace/GameFileSystem/MountIndexFile.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+using reversingspace::gfs::FileSystemPointer;
+using reversingspace::gfs::MountIndex;
+using reversingspace::gfs::MountIndexFile;
+
+// Writes a file, creating its directory.
+static void write(const std::filesystem::path& path, const std::string& content) {
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream strm(path, std::ios::binary);
+	strm << content;
+}
+
+// Reads a whole file.
+static std::string read(const std::filesystem::path& path) {
+	std::ifstream strm(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(strm), std::istreambuf_iterator<char>());
+}
+
+// Counts the identities a filesystem enumerates (-1 if it cannot).
+template<typename Enumerable>
+static long count(Enumerable& enumerable) {
+	long total = 0;
+	bool enumerated = enumerable.enumerate([&total](reversingspace::gfs::StringIdentity) {
+		++total;
+	});
+	return enumerated ? total : -1;
+}
+
+// Creates a fresh stack over `base` and `mod` (mod on top).
+static std::vector<FileSystemPointer> make_stack(const std::filesystem::path& root) {
+	return {
+		std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "base"),
+		std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "mod"),
+	};
+}
+
+int main(int argc, char **argv) {
+	const auto root = std::filesystem::current_path() / "persist";
+	std::filesystem::remove_all(root);
+	write(root / "base" / "a.txt", "base");
+	write(root / "base" / "shaders" / "x.glsl", "shader");
+	write(root / "mod" / "a.txt", "modded");
+	write(root / "mod" / "new.txt", "new");
+	std::filesystem::create_directories(root / "userland");
+	const auto index_path = root / "userland" / "mounts.index";
+
+	// Saved and loaded, resolution is unchanged.
+	{
+		auto stack = make_stack(root);
+		MountIndex built;
+		built.build(stack);
+		if (!built.save(stack, index_path)) {
+			throw std::runtime_error("index could not be saved.");
+		}
+		auto file = MountIndexFile::open(index_path);
+		if (file == nullptr || file->size() != 3 || file->mount_count() != 2) {
+			throw std::runtime_error("saved index could not be opened.");
+		}
+
+		auto fresh = make_stack(root);
+		MountIndex loaded;
+		if (!loaded.load(fresh, file) || loaded.opaque_count() != 0) {
+			throw std::runtime_error("unchanged mounts were not trusted.");
+		}
+		if (loaded.size() != 3 || count(loaded) != 3) {
+			throw std::runtime_error("loaded index lists the wrong identities.");
+		}
+		FileSystemPointer owner;
+		auto a = loaded.resolve(fresh, "a.txt", owner);
+		if (a == nullptr || owner != fresh[1] || a->get_size() != 6) {
+			throw std::runtime_error("loaded index lost the mount order.");
+		}
+		if (loaded.resolve(fresh, "shaders/x.glsl", owner) == nullptr || owner != fresh[0]) {
+			throw std::runtime_error("loaded index missed a lower mount.");
+		}
+		if (loaded.resolve(fresh, "missing.txt", owner) != nullptr) {
+			throw std::runtime_error("loaded index resolved a missing file.");
+		}
+
+		// Changes overlay the loaded file.
+		loaded.erase(fresh[1]);
+		a = loaded.resolve(fresh, "a.txt", owner);
+		if (a == nullptr || owner != fresh[0] || count(loaded) != 2) {
+			throw std::runtime_error("unmount did not apply over the loaded index.");
+		}
+		loaded.insert(fresh, fresh[1]);
+		a = loaded.resolve(fresh, "a.txt", owner);
+		if (a == nullptr || owner != fresh[1] || count(loaded) != 3) {
+			throw std::runtime_error("mount did not apply over the loaded index.");
+		}
+
+		// Saving again keeps the overlay.
+		const auto resaved = root / "userland" / "resaved.index";
+		if (!loaded.save(fresh, resaved)) {
+			throw std::runtime_error("loaded index could not be saved.");
+		}
+		MountIndex reloaded;
+		if (!reloaded.load(fresh, MountIndexFile::open(resaved)) || count(reloaded) != 3) {
+			throw std::runtime_error("resaved index differs.");
+		}
+	}
+
+	// Copies share their storage, but not their changes.
+	{
+		auto stack = make_stack(root);
+		MountIndex original;
+		original.build(stack);
+		MountIndex copy = original;
+		copy.erase(stack[1]);
+		copy.remove("shaders/x.glsl", stack[0]);
+		FileSystemPointer owner;
+		if (original.resolve(stack, "a.txt", owner) == nullptr || owner != stack[1] ||
+			original.resolve(stack, "shaders/x.glsl", owner) == nullptr || count(original) != 3) {
+			throw std::runtime_error("change to a copy reached the original.");
+		}
+		if (copy.resolve(stack, "a.txt", owner) == nullptr || owner != stack[0] || count(copy) != 1) {
+			throw std::runtime_error("copy lost its changes.");
+		}
+	}
+
+	// Other mounts (or another order) are rejected.
+	{
+		auto file = MountIndexFile::open(index_path);
+		auto stack = make_stack(root);
+		std::vector<FileSystemPointer> reversed = { stack[1], stack[0] };
+		std::vector<FileSystemPointer> shorter = { stack[0] };
+		MountIndex index;
+		if (index.load(reversed, file) || index.load(shorter, file)) {
+			throw std::runtime_error("index was loaded for other mounts.");
+		}
+	}
+
+	// Damaged or foreign files are rejected.
+	{
+		auto bytes = read(index_path);
+		auto check = [&root](const std::string& content, const char* what) {
+			const auto damaged = root / "userland" / "damaged.index";
+			write(damaged, content);
+			if (MountIndexFile::open(damaged) != nullptr) {
+				throw std::runtime_error(std::string("opened ") + what + ".");
+			}
+		};
+		auto version = bytes;
+		version[8] ^= 0x7f;
+		check(version, "another version");
+		auto magic = bytes;
+		magic[0] = 'X';
+		check(magic, "a file without the signature");
+		check(bytes.substr(0, bytes.size() - 1), "a truncated file");
+		check(bytes.substr(0, 16), "a header fragment");
+		check("", "an empty file");
+	}
+
+	// A changed mount is probed in place.
+	{
+		auto stack = make_stack(root);
+		auto file = MountIndexFile::open(index_path);
+		write(root / "mod" / "later.txt", "later");
+		// Bumped explicitly: the write may land in the same timestamp tick.
+		auto time = std::filesystem::last_write_time(root / "mod");
+		std::filesystem::last_write_time(root / "mod", time + std::chrono::hours(1));
+
+		MountIndex loaded;
+		if (!loaded.load(stack, file) || loaded.opaque_count() != 1) {
+			throw std::runtime_error("changed mount was trusted.");
+		}
+		FileSystemPointer owner;
+		if (loaded.resolve(stack, "later.txt", owner) == nullptr || owner != stack[1]) {
+			throw std::runtime_error("changed mount was not probed.");
+		}
+		auto a = loaded.resolve(stack, "a.txt", owner);
+		if (a == nullptr || owner != stack[1]) {
+			throw std::runtime_error("changed mount lost its priority.");
+		}
+		if (loaded.resolve(stack, "shaders/x.glsl", owner) == nullptr || owner != stack[0]) {
+			throw std::runtime_error("unchanged mount lost its entries.");
+		}
+		if (loaded.enumerate([](reversingspace::gfs::StringIdentity) {})) {
+			throw std::runtime_error("index with a changed mount enumerated.");
+		}
+	}
+
+	// A file added between enumeration and saving is not hidden: the
+	// saved stamp is the one taken before enumerating.
+	{
+		auto stack = make_stack(root);
+		MountIndex built;
+		built.build(stack);
+		write(root / "mod" / "late.txt", "late");
+		auto time = std::filesystem::last_write_time(root / "mod");
+		std::filesystem::last_write_time(root / "mod", time + std::chrono::hours(2));
+		const auto late_path = root / "userland" / "late.index";
+		if (!built.save(stack, late_path)) {
+			throw std::runtime_error("index could not be saved.");
+		}
+
+		auto fresh = make_stack(root);
+		MountIndex loaded;
+		FileSystemPointer owner;
+		if (!loaded.load(fresh, MountIndexFile::open(late_path)) || loaded.opaque_count() != 1 ||
+			loaded.resolve(fresh, "late.txt", owner) == nullptr || owner != fresh[1]) {
+			throw std::runtime_error("file added before saving was hidden.");
+		}
+	}
+
+	// A listed file which cannot be opened is not stale; one confirmed gone is.
+	{
+		auto stack = make_stack(root);
+		MountIndex index;
+		index.build(stack);
+		std::filesystem::remove(root / "mod" / "new.txt");
+		std::filesystem::create_directories(root / "mod" / "new.txt");
+		FileSystemPointer owner;
+		std::vector<FileSystemPointer> stale;
+		if (index.resolve(stack, "new.txt", owner, &stale) != nullptr || !stale.empty()) {
+			throw std::runtime_error("file which could not be opened was reported stale.");
+		}
+		std::filesystem::remove(root / "mod" / "new.txt");
+		if (index.resolve(stack, "new.txt", owner, &stale) != nullptr ||
+			stale.size() != 1 || stale[0] != stack[1]) {
+			throw std::runtime_error("removed file was not reported stale.");
+		}
+		write(root / "mod" / "new.txt", "new");
+	}
+
+	// StorageServer: saved to userland, loaded on a later start, repaired lazily.
+	{
+		auto mount_all = [&root](reversingspace::gfs::StorageServer<FileType>& server) {
+			server.mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "base"));
+			server.mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "mod"));
+		};
+		auto first = reversingspace::gfs::StorageServer<FileType>::create(root / "userland");
+		mount_all(*first);
+		if (first->save_index()) {
+			throw std::runtime_error("saved without an index.");
+		}
+		first->build_index();
+		if (!first->save_index()) {
+			throw std::runtime_error("storage server could not save its index.");
+		}
+
+		auto second = reversingspace::gfs::StorageServer<FileType>::create(root / "userland");
+		if (second->load_index()) {
+			throw std::runtime_error("index was loaded over no mounts.");
+		}
+		mount_all(*second);
+		if (!second->load_index() || !second->is_indexed()) {
+			throw std::runtime_error("storage server could not load its index.");
+		}
+		auto a = second->get_dataland_file("a.txt");
+		auto before = count(*second);
+		if (a == nullptr || a->get_size() != 6 || before < 0) {
+			throw std::runtime_error("storage server resolved wrongly from a loaded index.");
+		}
+
+		// Removed behind the index's back: queued on the first miss,
+		// dropped once repairs are applied.
+		std::filesystem::remove(root / "mod" / "new.txt");
+		if (second->get_dataland_file("new.txt") != nullptr) {
+			throw std::runtime_error("removed file was resolved.");
+		}
+		if (count(*second) != before) {
+			throw std::runtime_error("stale entry was repaired from the look-up.");
+		}
+		if (!second->repair_index() || count(*second) != before - 1 || second->repair_index()) {
+			throw std::runtime_error("stale entry was not repaired.");
+		}
+
+		second->unmount(root / "mod");
+		if (second->load_index()) {
+			throw std::runtime_error("index was loaded over other mounts.");
+		}
+	}
+
+	std::cout << "Saved index: " << std::filesystem::file_size(index_path) << " bytes" << std::endl;
+	std::filesystem::remove_all(root);
+	return 0;
+}
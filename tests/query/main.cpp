@@ -0,0 +1,343 @@
+// Test (and benchmark) for prefix and glob queries (IdentityTree).
+
+#include <ReversingSpace/GameFileSystem/Archive.hpp>
+#include <ReversingSpace/GameFileSystem/IdentityTree.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+using reversingspace::gfs::StringIdentity;
+
+// Straightforward (backtracking) glob matcher to check `GlobPattern` against.
+static bool reference_match(StringIdentity pattern, StringIdentity name) {
+	if (pattern.empty()) {
+		return name.empty();
+	}
+	if (pattern.substr(0, 3) == "**/") {
+		if (reference_match(pattern.substr(3), name)) {
+			return true;
+		}
+		for (size_t i = 0; i < name.size(); ++i) {
+			if (name[i] == '/' && reference_match(pattern.substr(3), name.substr(i + 1))) {
+				return true;
+			}
+		}
+		return false;
+	}
+	if (pattern.substr(0, 2) == "**") {
+		for (size_t i = 0; i <= name.size(); ++i) {
+			if (reference_match(pattern.substr(2), name.substr(i))) {
+				return true;
+			}
+		}
+		return false;
+	}
+	if (pattern[0] == '*') {
+		for (size_t i = 0; i <= name.size(); ++i) {
+			if (reference_match(pattern.substr(1), name.substr(i))) {
+				return true;
+			}
+			if (i < name.size() && name[i] == '/') {
+				break;
+			}
+		}
+		return false;
+	}
+	if (name.empty()) {
+		return false;
+	}
+	if (pattern[0] == '?') {
+		return name[0] != '/' && reference_match(pattern.substr(1), name.substr(1));
+	}
+	return name[0] == pattern[0] && reference_match(pattern.substr(1), name.substr(1));
+}
+
+// Collects the results of a query.
+static std::vector<std::string> collect(const std::function<void(const reversingspace::gfs::EnumerationFunction&)>& query) {
+	std::vector<std::string> names;
+	query([&names](StringIdentity name) {
+		names.push_back(std::string(name));
+	});
+	return names;
+}
+
+// Archive listing a fixed set of names (or none, if it does not enumerate).
+class MemoryArchive : public reversingspace::gfs::Archive {
+private:
+	std::filesystem::path path;
+	std::vector<std::string> names;
+	bool enumerable;
+
+public:
+	MemoryArchive(const std::filesystem::path& path, std::vector<std::string> names, bool enumerable = true) :
+		path(path), names(names), enumerable(enumerable) {}
+
+	std::uint32_t get_child_count() const {
+		return (std::uint32_t)names.size();
+	}
+
+	std::filesystem::path get_path() const {
+		return path;
+	}
+
+	reversingspace::gfs::FilePointer get_file(reversingspace::gfs::HashedIdentity,
+		reversingspace::storage::FileAccess) {
+		return nullptr;
+	}
+
+	reversingspace::gfs::FilePointer get_file(StringIdentity,
+		reversingspace::storage::FileAccess) {
+		return nullptr;
+	}
+
+	bool enumerate(const reversingspace::gfs::EnumerationFunction& callback) {
+		if (!enumerable) {
+			return false;
+		}
+		for (auto& name : names) {
+			callback(name);
+		}
+		return true;
+	}
+};
+
+// Writes an empty file, creating its directory.
+static void touch(const std::filesystem::path& path) {
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream strm(path);
+}
+
+int main(int argc, char **argv) {
+	const auto root = std::filesystem::current_path() / "query";
+	std::filesystem::remove_all(root);
+
+	// Tree and pattern against brute force, over names sharing many prefixes.
+	{
+		const char* directories[] = { "a", "b", "ab", "shaders", "s" };
+		const char* files[] = { "x.lua", "y.lua", "x.dds", "lua", "a" };
+		std::vector<std::string> names;
+		std::uint32_t seed = 12345;
+		auto next = [&seed]() {
+			seed = seed * 1664525u + 1013904223u;
+			return seed >> 8;
+		};
+		for (int i = 0; i < 2000; ++i) {
+			std::string name;
+			auto depth = next() % 4;
+			for (std::uint32_t d = 0; d < depth; ++d) {
+				name += directories[next() % 5];
+				name += "/";
+			}
+			name += files[next() % 5];
+			names.push_back(name);
+		}
+		for (int i = 0; i < 200; ++i) {
+			// Raw strings, including the empty name and stray slashes.
+			std::string name;
+			auto length = next() % 7;
+			for (std::uint32_t c = 0; c < length; ++c) {
+				name += "ab/"[next() % 3];
+			}
+			names.push_back(name);
+		}
+
+		std::vector<StringIdentity> views(names.begin(), names.end());
+		auto tree = reversingspace::gfs::IdentityTree::create(views);
+		std::set<std::string> unique(names.begin(), names.end());
+		std::vector<std::string> sorted(unique.begin(), unique.end());
+		if (tree->size() != sorted.size()) {
+			throw std::runtime_error("tree size differs from the number of unique names.");
+		}
+		if (collect([&tree](auto& callback) { tree->find_prefix("", callback); }) != sorted) {
+			throw std::runtime_error("tree does not list every name in sorted order.");
+		}
+
+		// Every prefix of every name, plus prefixes nothing starts with.
+		std::set<std::string> prefixes = { "c", "shaders/z", "a/b/c/d/e", "x.lua/" };
+		for (auto& name : sorted) {
+			for (size_t length = 0; length <= name.size(); ++length) {
+				prefixes.insert(name.substr(0, length));
+			}
+		}
+		for (auto& prefix : prefixes) {
+			std::vector<std::string> expected;
+			for (auto& name : sorted) {
+				if (name.compare(0, prefix.size(), prefix) == 0) {
+					expected.push_back(name);
+				}
+			}
+			if (collect([&tree, &prefix](auto& callback) { tree->find_prefix(prefix, callback); }) != expected) {
+				throw std::runtime_error("prefix query differs for \"" + prefix + "\".");
+			}
+		}
+
+		const char* patterns[] = {
+			"", "*", "**", "***", "?", "??", "*.lua", "**.lua", "**/x.lua", "**/",
+			"shaders/*", "shaders/**", "shaders/*.lua", "shaders/**/x.lua", "?/x.lua",
+			"a*", "a**b", "*/*", "a/**/b", "a/**/b/**", "x.lua", "s?aders/**.dds",
+			"*a*/x.*", "b/", "ab/?/**lua", "**a", "a/b/a/x.lua",
+		};
+		for (auto pattern_text : patterns) {
+			reversingspace::gfs::GlobPattern pattern(pattern_text);
+			std::vector<std::string> expected;
+			for (auto& name : sorted) {
+				bool reference = reference_match(pattern_text, name);
+				if (pattern.matches(name) != reference) {
+					throw std::runtime_error(std::string("pattern \"") + pattern_text + "\" disagrees on \"" + name + "\".");
+				}
+				if (reference) {
+					expected.push_back(name);
+				}
+			}
+			if (collect([&tree, &pattern](auto& callback) { tree->find_glob(pattern, callback); }) != expected) {
+				throw std::runtime_error(std::string("glob query differs for \"") + pattern_text + "\".");
+			}
+		}
+		std::cout << "Tree: " << tree->size() << " names, " << tree->node_count() << " nodes, "
+			<< tree->memory_size() << " bytes." << std::endl;
+	}
+
+	// Directory: answered from a tree built on the first query.
+	{
+		touch(root / "base" / "shaders" / "a.lua");
+		touch(root / "base" / "shaders" / "b.lua");
+		touch(root / "base" / "shaders" / "sub" / "c.lua");
+		touch(root / "base" / "textures" / "t.dds");
+		touch(root / "base" / "readme.txt");
+		auto directory = std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "base");
+
+		auto shaders = collect([&directory](auto& callback) { directory->enumerate_prefix("shaders/", callback); });
+		if (shaders != std::vector<std::string>{ "shaders/a.lua", "shaders/b.lua", "shaders/sub/c.lua" }) {
+			throw std::runtime_error("directory prefix query failed.");
+		}
+		auto scripts = collect([&directory](auto& callback) { directory->enumerate_glob("shaders/*.lua", callback); });
+		if (scripts != std::vector<std::string>{ "shaders/a.lua", "shaders/b.lua" }) {
+			throw std::runtime_error("directory glob query failed.");
+		}
+
+		// Queries do not touch the disk until the tree is dropped.
+		touch(root / "base" / "shaders" / "late.lua");
+		if (collect([&directory](auto& callback) { directory->enumerate_glob("**.lua", callback); }).size() != 3) {
+			throw std::runtime_error("directory query rescanned the disk.");
+		}
+		directory->invalidate_query_index();
+		if (collect([&directory](auto& callback) { directory->enumerate_glob("**.lua", callback); }).size() != 4) {
+			throw std::runtime_error("directory query missed a file after invalidation.");
+		}
+
+		// A folding directory does not enumerate, so it cannot be queried.
+		directory->set_case_folding(true);
+		if (directory->enumerate_prefix("", [](StringIdentity) {})) {
+			throw std::runtime_error("folding directory answered a query.");
+		}
+	}
+
+	// Archives: queried through their enumeration.
+	{
+		MemoryArchive archive("packed", { "shaders/z.lua", "shaders/a.lua", "music/theme.ogg" });
+		auto packed = collect([&archive](auto& callback) { archive.enumerate_glob("shaders/*", callback); });
+		if (packed != std::vector<std::string>{ "shaders/a.lua", "shaders/z.lua" }) {
+			throw std::runtime_error("archive glob query failed.");
+		}
+		MemoryArchive opaque("opaque", { "shaders/a.lua" }, false);
+		if (opaque.enumerate_prefix("", [](StringIdentity) {})) {
+			throw std::runtime_error("non-enumerable archive answered a query.");
+		}
+	}
+
+	// StorageServer: merged by priority, each identity once.
+	{
+		touch(root / "userland" / "shaders" / "user.lua");
+		touch(root / "mod" / "shaders" / "a.lua");
+		touch(root / "mod" / "shaders" / "new.lua");
+		auto storage_server = reversingspace::gfs::StorageServer<FileType>::create(root / "userland");
+		storage_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "base"));
+		storage_server->mount(std::make_shared<MemoryArchive>(root / "packed",
+			std::vector<std::string>{ "shaders/a.lua", "shaders/packed.lua" }));
+		storage_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "mod"));
+
+		auto merged = collect([&storage_server](auto& callback) {
+			if (!storage_server->enumerate_glob("shaders/*.lua", callback)) {
+				throw std::runtime_error("storage server could not be queried.");
+			}
+		});
+		// Userland first, then the top mount down.
+		std::vector<std::string> expected = {
+			"shaders/user.lua",
+			"shaders/a.lua", "shaders/new.lua",
+			"shaders/packed.lua",
+			"shaders/b.lua", "shaders/late.lua",
+		};
+		if (merged != expected) {
+			throw std::runtime_error("storage server glob query failed.");
+		}
+		auto textures = collect([&storage_server](auto& callback) {
+			storage_server->enumerate_prefix("textures/", callback);
+		});
+		if (textures != std::vector<std::string>{ "textures/t.dds" }) {
+			throw std::runtime_error("storage server prefix query failed.");
+		}
+
+		// A mount which cannot enumerate makes the answer incomplete.
+		storage_server->mount(std::make_shared<MemoryArchive>(root / "opaque",
+			std::vector<std::string>{ "shaders/hidden.lua" }, false));
+		if (storage_server->enumerate_prefix("shaders/", [](StringIdentity) {})) {
+			throw std::runtime_error("storage server answered with an opaque mount.");
+		}
+	}
+
+	// Benchmark: a prefix query against filtering every name.
+	{
+		std::vector<std::string> names;
+		for (int d = 0; d < 100; ++d) {
+			for (int f = 0; f < 1000; ++f) {
+				names.push_back("data/d" + std::to_string(d) + "/file" + std::to_string(f) + ".bin");
+			}
+		}
+		std::vector<StringIdentity> views(names.begin(), names.end());
+
+		auto start = std::chrono::steady_clock::now();
+		auto tree = reversingspace::gfs::IdentityTree::create(views);
+		auto built = std::chrono::steady_clock::now();
+
+		size_t tree_hits = 0;
+		for (int d = 0; d < 100; ++d) {
+			tree->find_prefix("data/d" + std::to_string(d) + "/file1", [&tree_hits](StringIdentity) {
+				++tree_hits;
+			});
+		}
+		auto queried = std::chrono::steady_clock::now();
+
+		size_t scan_hits = 0;
+		for (int d = 0; d < 100; ++d) {
+			auto prefix = "data/d" + std::to_string(d) + "/file1";
+			for (auto name : views) {
+				if (name.substr(0, prefix.size()) == prefix) {
+					++scan_hits;
+				}
+			}
+		}
+		auto scanned = std::chrono::steady_clock::now();
+
+		if (tree_hits != scan_hits) {
+			throw std::runtime_error("tree and filter disagree.");
+		}
+		using ms = std::chrono::duration<double, std::milli>;
+		std::cout << "Build (" << names.size() << " names): " << ms(built - start).count() << "ms" << std::endl;
+		std::cout << "100 prefix queries (" << tree_hits << " results): tree " << ms(queried - built).count()
+			<< "ms, filtered " << ms(scanned - queried).count() << "ms" << std::endl;
+	}
+
+	std::filesystem::remove_all(root);
+	return 0;
+}
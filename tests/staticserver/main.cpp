@@ -0,0 +1,172 @@
+// Test (and benchmark) for compile-time mount stacks (StaticStorageServer).
+
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/StaticStorageServer.hpp>
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+using DirectoryType = reversingspace::gfs::Directory<FileType>;
+using reversingspace::gfs::FilePointer;
+using reversingspace::gfs::StringIdentity;
+
+// Writes a file, creating its directory.
+static void write(const std::filesystem::path& path, const std::string& content) {
+	std::filesystem::create_directories(path.parent_path());
+	std::ofstream strm(path, std::ios::binary);
+	strm << content;
+}
+
+// Reads a whole file ("" for nullptr).
+static std::string contents(const FilePointer& file) {
+	std::vector<std::uint8_t> buffer;
+	if (file != nullptr) {
+		file->read(buffer, file->get_size());
+	}
+	return std::string(buffer.begin(), buffer.end());
+}
+
+// In-memory archive answering from a name table (so look-ups never touch the disk).
+class MemoryArchive final : public reversingspace::gfs::FileSystem {
+private:
+	std::filesystem::path path;
+	reversingspace::gfs::IdentityMap<bool> names;
+	FilePointer payload;
+
+public:
+	explicit MemoryArchive(const std::filesystem::path& path): path(path) {}
+
+	void add(StringIdentity name, FilePointer file) {
+		names[name] = true;
+		payload = file;
+	}
+
+	std::filesystem::path get_path() const {
+		return path;
+	}
+
+	FilePointer get_file(reversingspace::gfs::HashedIdentity,
+		reversingspace::storage::FileAccess = reversingspace::storage::FileAccess::Read) {
+		return nullptr;
+	}
+
+	FilePointer get_file(StringIdentity identity,
+		reversingspace::storage::FileAccess = reversingspace::storage::FileAccess::Read) {
+		return (names.count(identity) != 0) ? payload : nullptr;
+	}
+};
+
+int main(int argc, char **argv) {
+	const auto root = std::filesystem::current_path() / "staticserver";
+	std::filesystem::remove_all(root);
+	write(root / "userland" / "saved.dat", "saved");
+	write(root / "userland" / "shared.txt", "userland");
+	write(root / "patch" / "shared.txt", "patch");
+	write(root / "patch" / "patched.txt", "patched");
+	write(root / "base" / "shared.txt", "base");
+	write(root / "base" / "patched.txt", "unpatched");
+	write(root / "base" / "textures" / "ui.dds", "ui");
+
+	// Resolves exactly as the dynamic server does.
+	{
+		auto hash = reversingspace::gfs::default_hash_function();
+		auto dynamic = reversingspace::gfs::StorageServer<FileType>::create(root / "userland", hash);
+		dynamic->mount(std::make_shared<DirectoryType>(root / "base"));
+		dynamic->mount(std::make_shared<DirectoryType>(root / "patch"));
+
+		reversingspace::gfs::StaticStorageServer<DirectoryType, DirectoryType, DirectoryType> fixed(
+			root / "userland", root / "patch", root / "base");
+		fixed.set_hash_function(hash);
+		static_assert(decltype(fixed)::mount_count() == 2, "two dataland mounts");
+
+		const char* names[] = { "saved.dat", "shared.txt", "patched.txt", "textures/ui.dds", "missing.txt" };
+		for (auto name : names) {
+			if (contents(fixed.get_file(name)) != contents(dynamic->get_file(name)) ||
+				contents(fixed.get_dataland_file(name)) != contents(dynamic->get_dataland_file(name)) ||
+				contents(fixed.get_file(hash(name))) != contents(dynamic->get_file(hash(name)))) {
+				std::cout << name << " resolves differently." << std::endl;
+				throw std::runtime_error("static server differs from the dynamic server.");
+			}
+		}
+		if (contents(fixed.get_file("shared.txt")) != "userland" ||
+			contents(fixed.get_dataland_file("shared.txt")) != "patch" ||
+			contents(fixed.get_file("patched.txt")) != "patched") {
+			throw std::runtime_error("static server resolved in the wrong order.");
+		}
+
+		long fixed_count = 0;
+		long dynamic_count = 0;
+		if (!fixed.enumerate([&fixed_count](StringIdentity) { ++fixed_count; }) ||
+			!dynamic->enumerate([&dynamic_count](StringIdentity) { ++dynamic_count; }) ||
+			fixed_count != dynamic_count) {
+			throw std::runtime_error("static server enumerates differently.");
+		}
+	}
+
+	// Benchmark: dataland look-ups through three in-memory layers.
+	{
+		auto payload = DirectoryType(root / "base").get_file("shared.txt");
+		std::vector<std::string> names;
+		for (int i = 0; i < 20000; ++i) {
+			names.push_back("data/" + std::to_string(i % 97) + "/file" + std::to_string(i) + ".bin");
+		}
+
+		auto dynamic = reversingspace::gfs::StorageServer<FileType>::create(root / "userland");
+		auto base = std::make_shared<MemoryArchive>(root / "memory_base");
+		auto patch = std::make_shared<MemoryArchive>(root / "memory_patch");
+		auto mod = std::make_shared<MemoryArchive>(root / "memory_mod");
+		reversingspace::gfs::StaticStorageServer<DirectoryType, MemoryArchive, MemoryArchive, MemoryArchive> fixed(
+			root / "userland", root / "memory_mod", root / "memory_patch", root / "memory_base");
+		for (size_t i = 0; i < names.size(); ++i) {
+			base->add(names[i], payload);
+			fixed.get_mount<2>().add(names[i], payload);
+			if (i % 10 == 0) {
+				patch->add(names[i], payload);
+				fixed.get_mount<1>().add(names[i], payload);
+			}
+			if (i % 100 == 0) {
+				mod->add(names[i], payload);
+				fixed.get_mount<0>().add(names[i], payload);
+			}
+		}
+		dynamic->mount(base);
+		dynamic->mount(patch);
+		dynamic->mount(mod);
+
+		const int rounds = 20;
+		using clock = std::chrono::steady_clock;
+		auto time = [&names](auto&& lookup) {
+			size_t hits = 0;
+			auto start = clock::now();
+			for (int round = 0; round < rounds; ++round) {
+				for (auto& name : names) {
+					hits += (lookup(name) != nullptr) ? 1 : 0;
+				}
+			}
+			auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			if (hits != names.size() * rounds) {
+				throw std::runtime_error("benchmark look-up missed.");
+			}
+			return elapsed / (double)(names.size() * rounds);
+		};
+		double dynamic_ns = time([&dynamic](const std::string& name) {
+			return dynamic->get_dataland_file(name);
+		});
+		double fixed_ns = time([&fixed](const std::string& name) {
+			return fixed.get_dataland_file(name);
+		});
+		std::cout << names.size() * rounds << " look-ups over 3 mounts: dynamic " << dynamic_ns
+			<< "ns, static " << fixed_ns << "ns per look-up" << std::endl;
+	}
+
+	std::filesystem::remove_all(root);
+	return 0;
+}
@@ -1,5 +1,6 @@
 // This is a test for the StorageServer component.
 
+#include <ReversingSpace/GameFileSystem/CaseFolding.hpp>
 #include <ReversingSpace/GameFileSystem/StorageServer.hpp>
 #include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
 
@@ -7,6 +8,9 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
 
 // Declare this once.
 using FileType = reversingspace::gfs::PlatformFile;
@@ -240,6 +244,310 @@ int main(int argc, char **argv) {
 			}
 		}
 	}
+
+	// Merged index: must resolve exactly as the probing walk does.
+	{
+		// Reads the 8 byte marker from a file (throwing if it's missing).
+		auto read_marker = [&storage_server](const std::string& name) {
+			auto file = storage_server->get_file(name);
+			if (file == nullptr) {
+				std::cout << name << " missing with the index built." << std::endl;
+				throw std::runtime_error("indexed look-up failed.");
+			}
+			char marker[8] = { 0 };
+			file->read(marker, 8);
+			return std::string(marker);
+		};
+
+		// Only test_files2 is mounted at this point.
+		storage_server->build_index();
+		if (read_marker("test_file_0") != "tf0tst1") {
+			throw std::runtime_error("indexed test_file_0 resolved from the wrong mount.");
+		}
+
+		// Incremental: mounting on top must take priority...
+		auto tdl0_dir = std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl0_fs_path);
+		storage_server->mount(tdl0_dir);
+		if (read_marker("test_file_0") != "tf0tst0" || read_marker("test_file_0a") != "tf0tsta") {
+			throw std::runtime_error("indexed look-up ignored the new mount.");
+		}
+
+		// ... and unmounting must fall through to the next provider.
+		storage_server->unmount(tdl0_dir);
+		if (read_marker("test_file_0") != "tf0tst1") {
+			throw std::runtime_error("indexed look-up did not fall through on unmount.");
+		}
+		if (storage_server->get_file("test_file_0a") != nullptr) {
+			throw std::runtime_error("indexed look-up found tf0a after unmount.");
+		}
+		storage_server->drop_index();
+	}
+
+	// Parallel probing: must pick the same mount as the serial walk.
+	{
+		auto tdl0_dir = std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl0_fs_path);
+		storage_server->mount(tdl0_dir);
+
+		// A single thread also covers the caller running unclaimed probes.
+		for (size_t threads : { 1, 4 }) {
+			storage_server->enable_parallel_probing(reversingspace::gfs::WorkerPool::create(threads));
+			auto tf0 = storage_server->get_file("test_file_0");
+			char marker[8] = { 0 };
+			if (tf0 == nullptr || tf0->read(marker, 8) != 8 || strcmp(marker, "tf0tst0") != 0) {
+				std::cout << "parallel probe did not prefer the top mount." << std::endl;
+				throw std::runtime_error("parallel probe broke priority.");
+			}
+			if (storage_server->get_file("test_file_1") == nullptr) {
+				std::cout << "parallel probe missed test_file_1 (lower mount)." << std::endl;
+				throw std::runtime_error("parallel probe failed.");
+			}
+			if (storage_server->get_file("test_file_missing") != nullptr) {
+				throw std::runtime_error("parallel probe found a missing file.");
+			}
+		}
+		storage_server->disable_parallel_probing();
+		storage_server->unmount(tdl0_dir);
+	}
+
+	// Mount filters: skipped mounts must not change results.
+	{
+		// The filter itself: no false negatives, and few false positives.
+		const size_t ENTRY_COUNT = 100000;
+		// (Each entry is inserted twice: by name and by hash.)
+		reversingspace::gfs::IdentityFilter filter(2 * ENTRY_COUNT, true);
+		for (size_t i = 0; i < ENTRY_COUNT; ++i) {
+			filter.insert("present/" + std::to_string(i));
+			filter.insert((reversingspace::gfs::HashedIdentity)i);
+		}
+		size_t false_positives = 0;
+		for (size_t i = 0; i < ENTRY_COUNT; ++i) {
+			if (!filter.may_contain("present/" + std::to_string(i)) ||
+				!filter.may_contain((reversingspace::gfs::HashedIdentity)i)) {
+				throw std::runtime_error("identity filter reported a present identity as absent.");
+			}
+			if (filter.may_contain("absent/" + std::to_string(i))) {
+				++false_positives;
+			}
+		}
+		// 10 bits per key: expect under 1%.
+		std::cout << "identity filter: " << filter.memory_size() << " bytes, "
+			<< false_positives << " false positives in " << ENTRY_COUNT << std::endl;
+		if (false_positives > ENTRY_COUNT / 50) {
+			throw std::runtime_error("identity filter has too many false positives.");
+		}
+
+		auto tdl0_dir = std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl0_fs_path);
+		storage_server->mount(tdl0_dir);
+		storage_server->build_mount_filters();
+		auto tf0 = storage_server->get_file("test_file_0");
+		char marker[8] = { 0 };
+		if (tf0 == nullptr || tf0->read(marker, 8) != 8 || strcmp(marker, "tf0tst0") != 0) {
+			std::cout << "filtered look-up did not prefer the top mount." << std::endl;
+			throw std::runtime_error("mount filters broke priority.");
+		}
+		if (storage_server->get_file("test_file_1") == nullptr) {
+			throw std::runtime_error("filtered look-up missed test_file_1.");
+		}
+
+		// Filters are snapshots: new files need a rebuild.
+		{
+			std::ofstream strm(tdl0_fs_path / "test_file_filtered");
+			strm << "filtered";
+		}
+		if (storage_server->get_file("test_file_filtered") != nullptr) {
+			throw std::runtime_error("stale mount filter did not skip the mount.");
+		}
+		storage_server->build_mount_filters();
+		if (storage_server->get_file("test_file_filtered") == nullptr) {
+			throw std::runtime_error("rebuilt mount filter still skips the mount.");
+		}
+		storage_server->drop_mount_filters();
+		storage_server->unmount(tdl0_dir);
+	}
+
+	// Hashed look-ups against a directory (lazy hash index).
+	{
+		reversingspace::gfs::HashFunction hasher = [](reversingspace::gfs::StringIdentity name) {
+			return (reversingspace::gfs::HashedIdentity)std::hash<std::string_view>{}(name);
+		};
+		reversingspace::gfs::Directory<FileType> directory(tdl1_fs_path);
+		if (directory.get_file(hasher("test_file_1")) != nullptr) {
+			throw std::runtime_error("hashed look-up succeeded without a hash function.");
+		}
+		directory.offer_hash_function(hasher);
+		if (directory.get_file(hasher("test_file_1")) == nullptr) {
+			std::cout << "test_file_1 not found by hash." << std::endl;
+			throw std::runtime_error("hashed directory look-up failed.");
+		}
+		if (directory.get_file(hasher("test_file_0a")) != nullptr) {
+			throw std::runtime_error("hashed look-up found a file from another directory.");
+		}
+
+		// A string miss is not retried hashed on a directory: its hash
+		// index is not built (so it is still fresh afterwards).
+		auto hashing = reversingspace::gfs::StorageServer<FileType>::create(userland_root, hasher);
+		auto mounted = std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl1_fs_path);
+		hashing->mount(mounted);
+		if (hashing->get_file("test_file_late") != nullptr) {
+			throw std::runtime_error("missing file was resolved.");
+		}
+		{
+			std::ofstream strm(tdl1_fs_path / "test_file_late");
+			strm << "late";
+		}
+		if (mounted->get_file(hasher("test_file_late")) == nullptr) {
+			throw std::runtime_error("string miss built the directory's hash index.");
+		}
+		std::filesystem::remove(tdl1_fs_path / "test_file_late");
+	}
+
+	// Case folding: Windows-authored identities against lower-case content.
+	{
+		// Folding (the word-at-a-time path and the tail) matches a byte-wise fold.
+		std::string every_byte;
+		for (int c = 0; c < 256; ++c) {
+			every_byte.push_back((char)c);
+		}
+		auto folded = reversingspace::gfs::fold_case(every_byte);
+		for (int c = 0; c < 256; ++c) {
+			char expected = (c >= 'A' && c <= 'Z') ? (char)(c + 32) : (char)c;
+			if (folded[c] != expected) {
+				throw std::runtime_error("fold_case folded a byte incorrectly.");
+			}
+		}
+		if (reversingspace::gfs::fold_case("Textures/UI.DDS") != "textures/ui.dds") {
+			throw std::runtime_error("fold_case failed on a path.");
+		}
+
+		const auto case_fs_path = std::filesystem::current_path() / "casefold";
+		std::filesystem::create_directories(case_fs_path / "textures");
+		{
+			std::ofstream strm(case_fs_path / "textures" / "ui.dds");
+			strm << "ui";
+		}
+		bool case_sensitive = !std::filesystem::exists(case_fs_path / "TEXTURES" / "UI.DDS");
+
+		auto case_dir = std::make_shared<reversingspace::gfs::Directory<FileType>>(case_fs_path);
+		if (case_sensitive && case_dir->get_file("Textures/UI.DDS") != nullptr) {
+			throw std::runtime_error("found a file in another casing without folding.");
+		}
+		case_dir->set_case_folding(true);
+		if (case_dir->get_file("Textures/UI.DDS") == nullptr || case_dir->get_file("textures/ui.dds") == nullptr) {
+			throw std::runtime_error("case-folded look-up failed.");
+		}
+		if (case_dir->get_file("Textures/Missing.DDS") != nullptr) {
+			throw std::runtime_error("case-folded look-up found a missing file.");
+		}
+
+		// Through a StorageServer with the merged index and filters on.
+		storage_server->mount(case_dir);
+		storage_server->build_index();
+		storage_server->build_mount_filters();
+		if (storage_server->get_file("TEXTURES/ui.DDS") == nullptr) {
+			throw std::runtime_error("case-folded look-up failed through the storage server.");
+		}
+		storage_server->drop_mount_filters();
+		storage_server->drop_index();
+		storage_server->unmount(case_dir);
+		std::filesystem::remove_all(case_fs_path);
+	}
+
+	// Look-up cache: negative entries must hold until invalidated.
+	{
+		storage_server->enable_cache();
+
+		if (storage_server->get_file("test_file_cached") != nullptr) {
+			std::cout << "test_file_cached found before it was written." << std::endl;
+			throw std::runtime_error("found test_file_cached in an invalid way.");
+		}
+		{
+			std::ofstream strm(tdl1_fs_path / "test_file_cached");
+			strm << "cached";
+			strm.flush();
+		}
+		if (storage_server->get_file("test_file_cached") != nullptr) {
+			std::cout << "negative cache entry for test_file_cached was ignored." << std::endl;
+			throw std::runtime_error("negative cache entry ignored.");
+		}
+		storage_server->invalidate_cache("test_file_cached");
+		if (storage_server->get_file("test_file_cached") == nullptr) {
+			std::cout << "test_file_cached missing after invalidation." << std::endl;
+			throw std::runtime_error("test_file_cached missing.");
+		}
+
+		// Positive entries must survive (and re-resolve) repeated use.
+		if (storage_server->get_file("test_file_1") == nullptr ||
+			storage_server->get_file("test_file_1") == nullptr) {
+			std::cout << "test_file_1 missing with the cache enabled." << std::endl;
+			throw std::runtime_error("test_file_1 missing.");
+		}
+
+		// Identities are views: a slice of a larger (unterminated) buffer
+		// must resolve, both on a cache miss and on the following hit.
+		const std::string listing = "test_file_1test_file_cached";
+		std::string_view slice(listing.data(), 11);
+		if (storage_server->get_file(slice) == nullptr || storage_server->get_file(slice) == nullptr) {
+			std::cout << "test_file_1 missing when looked up by slice." << std::endl;
+			throw std::runtime_error("string_view look-up failed.");
+		}
+
+		// Unmounting must invalidate the cache.
+		storage_server->unmount(tdl1_fs_path);
+		if (storage_server->get_file("test_file_1") != nullptr) {
+			std::cout << "test_file_1 found despite mount being removed." << std::endl;
+			throw std::runtime_error("found test_file_1 in an invalid way.");
+		}
+		storage_server->disable_cache();
+	}
+
+	// Sealed: resolves as before, and rejects every change.
+	{
+		auto sealed_server = reversingspace::gfs::StorageServer<FileType>::create(userland_root);
+		sealed_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl0_fs_path));
+		sealed_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(tdl1_fs_path));
+
+		const char* names[] = { "test_file_0", "test_file_0a", "test_file_1", "test_file_cached", "missing_file" };
+		auto contents = [&sealed_server](const char* name) {
+			auto file = sealed_server->get_dataland_file(name);
+			std::vector<std::uint8_t> buffer;
+			if (file != nullptr) {
+				file->read(buffer, file->get_size());
+			}
+			return std::string(buffer.begin(), buffer.end());
+		};
+		std::vector<std::string> before;
+		for (auto name : names) {
+			before.push_back(contents(name));
+		}
+		long listed_before = 0;
+		sealed_server->enumerate([&listed_before](std::string_view) { ++listed_before; });
+
+		if (!sealed_server->seal() || !sealed_server->is_sealed() || sealed_server->seal()) {
+			throw std::runtime_error("server did not seal exactly once.");
+		}
+		for (size_t i = 0; i < before.size(); ++i) {
+			if (contents(names[i]) != before[i]) {
+				std::cout << names[i] << " resolves differently once sealed." << std::endl;
+				throw std::runtime_error("sealed look-up differs.");
+			}
+		}
+		long listed_after = 0;
+		if (!sealed_server->enumerate([&listed_after](std::string_view) { ++listed_after; }) ||
+			listed_after != listed_before) {
+			throw std::runtime_error("sealed enumeration differs.");
+		}
+
+		sealed_server->unmount(tdl1_fs_path);
+		sealed_server->build_index();
+		sealed_server->build_mount_filters();
+		if (sealed_server->mount(std::make_shared<reversingspace::gfs::Directory<FileType>>(userland_root)) ||
+			sealed_server->mount_count() != 2 || sealed_server->is_indexed() ||
+			sealed_server->is_filtered() || sealed_server->enable_watching() ||
+			sealed_server->get_dataland_file("test_file_1") == nullptr) {
+			throw std::runtime_error("sealed server accepted a change.");
+		}
+	}
+
 	std::filesystem::remove_all(tdl0_fs_path);
 	std::filesystem::remove_all(tdl1_fs_path);
 	return 0;
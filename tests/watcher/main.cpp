@@ -0,0 +1,132 @@
+// Test for change notifications (DirectoryWatcher and StorageServer watching).
+
+#include <ReversingSpace/GameFileSystem/StorageServer.hpp>
+#include <ReversingSpace/GameFileSystem/PlatformFile.hpp>
+#include <ReversingSpace/GameFileSystem/Hash.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+// Declare this once.
+using FileType = reversingspace::gfs::PlatformFile;
+using Kind = reversingspace::gfs::DirectoryChange::Kind;
+
+// Polls `condition` for up to five seconds.
+template<typename Condition>
+static bool eventually(Condition condition) {
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (std::chrono::steady_clock::now() < deadline) {
+		if (condition()) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return condition();
+}
+
+int main(int argc, char **argv) {
+	const std::filesystem::path root = std::filesystem::current_path() / "watcher";
+	std::filesystem::remove_all(root);
+	std::filesystem::create_directories(root / "watched");
+
+	// The watcher on its own: changes arrive, coalesced, with relative names.
+	// A link back to the root must not rename the root's watch.
+	std::error_code link_error;
+	std::filesystem::create_directories(root / "watched" / "loop");
+	std::filesystem::create_directory_symlink("..", root / "watched" / "loop" / "up", link_error);
+	{
+		std::mutex mutex;
+		std::map<std::string, Kind> seen;
+		auto watcher = reversingspace::gfs::DirectoryWatcher::create(root / "watched",
+			[&mutex, &seen](const reversingspace::gfs::DirectoryChanges& changes) {
+				std::lock_guard<std::mutex> lock(mutex);
+				for (auto& change : changes) {
+					seen[change.identity] = change.kind;
+				}
+			});
+		if (watcher == nullptr) {
+			std::cout << "Change notifications are unsupported on this platform; skipping." << std::endl;
+			std::filesystem::remove_all(root);
+			return 0;
+		}
+		auto saw = [&mutex, &seen](const std::string& identity, Kind kind) {
+			return eventually([&]() {
+				std::lock_guard<std::mutex> lock(mutex);
+				auto entry = seen.find(identity);
+				return entry != seen.end() && entry->second == kind;
+			});
+		};
+
+		{
+			std::ofstream strm(root / "watched" / "a.txt");
+			strm << "a";
+		}
+		if (!saw("a.txt", Kind::Added)) {
+			throw std::runtime_error("watcher missed a created file.");
+		}
+
+		// New subdirectories are watched (and their files announced).
+		std::filesystem::create_directories(root / "watched" / "sub");
+		{
+			std::ofstream strm(root / "watched" / "sub" / "b.txt");
+			strm << "b";
+		}
+		if (!saw("sub/b.txt", Kind::Added)) {
+			throw std::runtime_error("watcher missed a file in a new subdirectory.");
+		}
+
+		std::filesystem::remove(root / "watched" / "a.txt");
+		if (!saw("a.txt", Kind::Removed)) {
+			throw std::runtime_error("watcher missed a removed file.");
+		}
+	}
+	std::filesystem::remove_all(root / "watched" / "loop");
+
+	// StorageServer: index, filters and cache follow the disk.
+	{
+		auto storage_server = reversingspace::gfs::StorageServer<FileType>::create(root / "userland",
+			reversingspace::gfs::default_hash_function());
+		auto mount = std::make_shared<reversingspace::gfs::Directory<FileType>>(root / "watched");
+		storage_server->mount(mount);
+		storage_server->build_index();
+		storage_server->build_mount_filters();
+		storage_server->enable_cache();
+		if (!storage_server->enable_watching()) {
+			throw std::runtime_error("failed to watch the mount.");
+		}
+
+		// Negative entries, index, filter and hash index all say "absent"...
+		using namespace reversingspace::gfs::literals;
+		if (storage_server->get_file("late.txt") != nullptr ||
+			storage_server->get_file("late.txt"_gfs) != nullptr) {
+			throw std::runtime_error("late.txt found before it was written.");
+		}
+		{
+			std::ofstream strm(root / "watched" / "late.txt");
+			strm << "late";
+		}
+		// ... until the change arrives.
+		if (!eventually([&]() { return storage_server->get_file("late.txt") != nullptr; })) {
+			throw std::runtime_error("late.txt not found after it was written.");
+		}
+		if (storage_server->get_file("late.txt"_gfs) == nullptr) {
+			throw std::runtime_error("late.txt not found by hash after it was written.");
+		}
+
+		std::filesystem::remove(root / "watched" / "late.txt");
+		if (!eventually([&]() { return storage_server->get_file("late.txt") == nullptr; })) {
+			throw std::runtime_error("late.txt still found after it was removed.");
+		}
+
+		storage_server->disable_watching();
+	}
+
+	std::filesystem::remove_all(root);
+	return 0;
+}
@@ -0,0 +1,134 @@
+// Pack tool: builds a pack (see PackArchive) from directory trees and manifests.
+
+#include <ReversingSpace/GameFileSystem/CompressedEntryFile.hpp>
+#include <ReversingSpace/GameFileSystem/PackBuilder.hpp>
+#include <ReversingSpace/GameFileSystem/WorkerPool.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using reversingspace::gfs::PackBuilder;
+
+static int usage() {
+	std::cerr <<
+		"usage: revspace-pack [options] <output> <input>...\n"
+		"\n"
+		"Inputs are directories (packed whole, named by relative path) or\n"
+		"@manifest files (one name, or name<TAB>file, per line).\n"
+		"\n"
+		"options:\n"
+		"  --prefix NAME        prefix the names of the directories that follow\n"
+		"  --trace FILE         write the entries named in FILE (one per line) first\n"
+		"  --alignment N        align entries to N bytes (default: a page)\n"
+		"  --small N[:ALIGN]    align entries under N bytes to ALIGN (default 8) instead\n"
+		"  --no-dedupe          store every entry's content, even when identical\n"
+		"  --compress[=BLOCK]   block-compress entries (BLOCK: 4096 to 1048576, default 65536)\n"
+		"  --threads N          worker threads (default: one per hardware thread; 1: none)\n";
+	return 2;
+}
+
+int main(int argc, char **argv) {
+	PackBuilder builder;
+	std::string prefix;
+	std::string output;
+	size_t threads = 0;
+	bool inputs = false;
+
+	// Created before the first input, as the pool also scans directories.
+	bool pooled = false;
+	auto start_pool = [&builder, &threads, &pooled]() {
+		if (!pooled && threads != 1) {
+			builder.set_worker_pool(reversingspace::gfs::WorkerPool::create(threads));
+		}
+		pooled = true;
+	};
+
+	for (int i = 1; i < argc; ++i) {
+		std::string argument = argv[i];
+		bool valued = (i + 1 < argc);
+		if (argument == "--prefix" && valued) {
+			prefix = argv[++i];
+		} else if (argument == "--trace" && valued) {
+			if (!builder.load_access_trace(argv[++i])) {
+				std::cerr << "cannot read trace " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (argument == "--alignment" && valued) {
+			if (!builder.set_alignment((std::uint32_t)std::strtoul(argv[++i], nullptr, 10))) {
+				std::cerr << "alignment must be a power of two" << std::endl;
+				return 2;
+			}
+		} else if (argument == "--small" && valued) {
+			std::string value = argv[++i];
+			auto colon = value.find(':');
+			std::uint32_t small_alignment = 8;
+			if (colon != std::string::npos) {
+				small_alignment = (std::uint32_t)std::strtoul(value.c_str() + colon + 1, nullptr, 10);
+			}
+			if (!builder.set_small_entries(std::strtoull(value.c_str(), nullptr, 10), small_alignment)) {
+				std::cerr << "alignment must be a power of two" << std::endl;
+				return 2;
+			}
+		} else if (argument == "--no-dedupe") {
+			builder.set_deduplication(false);
+		} else if (argument.compare(0, 10, "--compress") == 0) {
+			std::uint32_t block = reversingspace::gfs::CompressedEntryFile::DEFAULT_BLOCK_SIZE;
+			if (argument.size() > 10) {
+				if (argument[10] != '=') {
+					return usage();
+				}
+				block = (std::uint32_t)std::strtoul(argument.c_str() + 11, nullptr, 10);
+			}
+			if (!builder.set_compression(true, block)) {
+				std::cerr << "block size must be a power of two from 4096 to 1048576" << std::endl;
+				return 2;
+			}
+		} else if (argument == "--threads" && valued) {
+			threads = (size_t)std::strtoul(argv[++i], nullptr, 10);
+		} else if (!argument.empty() && argument[0] == '-') {
+			return usage();
+		} else if (output.empty()) {
+			output = argument;
+		} else if (argument[0] == '@') {
+			inputs = true;
+			start_pool();
+			if (!builder.add_manifest(argument.substr(1))) {
+				std::cerr << "cannot read manifest " << argument.substr(1) << std::endl;
+				return 1;
+			}
+		} else {
+			inputs = true;
+			start_pool();
+			if (!builder.add_directory(argument, prefix)) {
+				std::cerr << "cannot read directory " << argument << std::endl;
+				return 1;
+			}
+		}
+	}
+	if (output.empty() || !inputs) {
+		return usage();
+	}
+
+	start_pool();
+
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	if (!builder.write(output)) {
+		std::cerr << "cannot write " << output
+			<< " (unreadable source, or two entries with the same name or hash)" << std::endl;
+		return 1;
+	}
+	auto seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+	auto& figures = builder.get_statistics();
+	const double megabyte = 1024.0 * 1024.0;
+	std::cout << std::fixed << std::setprecision(1)
+		<< output << ": " << figures.entries << " entries (" << figures.stored << " stored), "
+		<< figures.content_bytes / megabyte << "MB in, " << figures.file_size / megabyte << "MB out ("
+		<< figures.deduplicated_bytes / megabyte << "MB deduplicated, " << figures.compressed << " compressed), "
+		<< figures.content_bytes / megabyte / (seconds > 0 ? seconds : 1) << "MB/s" << std::endl;
+	return 0;
+}